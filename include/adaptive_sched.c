@@ -0,0 +1,160 @@
+#include "adaptive_sched.h"
+#include <zephyr/logging/log.h>
+#include <stdlib.h>
+#if defined(CONFIG_SHELL)
+#include <zephyr/shell/shell.h>
+#endif
+
+LOG_MODULE_REGISTER(adaptive_sched, CONFIG_APP_SCHED_LOG_LEVEL);
+
+#define ACTIVITY_MAX 1000
+
+struct sched_bounds {
+	uint32_t min_ms;
+	uint32_t max_ms;
+};
+
+static const struct sched_bounds bounds[SCHED_OUT_COUNT] = {
+	[SCHED_OUT_SAMPLE] = { CONFIG_APP_SCHED_SAMPLE_MIN_MS, CONFIG_APP_SCHED_SAMPLE_MAX_MS },
+	[SCHED_OUT_DISPLAY] = { CONFIG_APP_SCHED_DISPLAY_MIN_MS, CONFIG_APP_SCHED_DISPLAY_MAX_MS },
+	[SCHED_OUT_ADV] = { CONFIG_APP_SCHED_ADV_MIN_MS, CONFIG_APP_SCHED_ADV_MAX_MS },
+};
+
+static const char *const output_names[SCHED_OUT_COUNT] = {
+	[SCHED_OUT_SAMPLE] = "sample",
+	[SCHED_OUT_DISPLAY] = "display",
+	[SCHED_OUT_ADV] = "adv",
+};
+
+static struct k_spinlock sched_lock;
+static struct sched_state state = {
+	/* Start slow until a rate of change is known */
+	.interval_ms = {
+		CONFIG_APP_SCHED_SAMPLE_MAX_MS,
+		CONFIG_APP_SCHED_DISPLAY_MAX_MS,
+		CONFIG_APP_SCHED_ADV_MAX_MS,
+	},
+};
+static int16_t last_temp;
+static uint16_t last_humidity;
+static int64_t last_sample_ms;
+static int64_t last_run_ms[SCHED_OUT_COUNT];
+static bool has_run[SCHED_OUT_COUNT];
+
+/* Change per minute as permille of the rate considered fast */
+static uint32_t rate_permille(int32_t delta, int64_t dt_ms, uint32_t fast_per_min)
+{
+	uint64_t rate = (uint64_t)abs(delta) * 60000 * ACTIVITY_MAX / ((uint64_t)dt_ms * fast_per_min);
+
+	return (uint32_t)MIN(rate, ACTIVITY_MAX);
+}
+
+/* Linear from the upper bound when calm to the lower bound when fast */
+static uint32_t interval_for(enum sched_output out, uint32_t activity)
+{
+	const struct sched_bounds *b = &bounds[out];
+
+	return b->max_ms - (b->max_ms - b->min_ms) * activity / ACTIVITY_MAX;
+}
+
+void adaptive_sched_observe(int16_t temp_celsius, uint16_t humidity_percent)
+{
+	int64_t now = k_uptime_get();
+	uint32_t sample;
+
+	k_spinlock_key_t key = k_spin_lock(&sched_lock);
+
+	if (last_sample_ms != 0 && now > last_sample_ms) {
+		int64_t dt = now - last_sample_ms;
+
+		sample = MAX(rate_permille(temp_celsius - last_temp, dt,
+					   CONFIG_APP_SCHED_TEMP_FAST),
+			     rate_permille((int32_t)humidity_percent - last_humidity, dt,
+					   CONFIG_APP_SCHED_HUMIDITY_FAST));
+
+		/* Attack at once, decay with a 1/4 exponential average */
+		if (sample >= state.activity_permille) {
+			state.activity_permille = sample;
+		} else {
+			state.activity_permille = (state.activity_permille * 3 + sample) / 4;
+		}
+
+		for (int i = 0; i < SCHED_OUT_COUNT; i++) {
+			state.interval_ms[i] = interval_for(i, state.activity_permille);
+		}
+	}
+
+	last_temp = temp_celsius;
+	last_humidity = humidity_percent;
+	last_sample_ms = now;
+
+	k_spin_unlock(&sched_lock, key);
+
+	LOG_DBG("Activity %u, intervals %u/%u/%u ms", state.activity_permille,
+		state.interval_ms[SCHED_OUT_SAMPLE], state.interval_ms[SCHED_OUT_DISPLAY],
+		state.interval_ms[SCHED_OUT_ADV]);
+}
+
+uint32_t adaptive_sched_interval_ms(enum sched_output out)
+{
+	return state.interval_ms[out];
+}
+
+bool adaptive_sched_due(enum sched_output out)
+{
+	int64_t now = k_uptime_get();
+	bool due;
+
+	k_spinlock_key_t key = k_spin_lock(&sched_lock);
+
+	due = !has_run[out] ||
+	      now - last_run_ms[out] + state.interval_ms[SCHED_OUT_SAMPLE] / 2 >=
+	      state.interval_ms[out];
+
+	if (due) {
+		has_run[out] = true;
+		last_run_ms[out] = now;
+		state.runs[out]++;
+	} else {
+		state.skipped[out]++;
+	}
+
+	k_spin_unlock(&sched_lock, key);
+
+	return due;
+}
+
+void adaptive_sched_get(struct sched_state *out)
+{
+	k_spinlock_key_t key = k_spin_lock(&sched_lock);
+
+	*out = state;
+
+	k_spin_unlock(&sched_lock, key);
+}
+
+#if defined(CONFIG_SHELL)
+static int cmd_diag_sched(const struct shell *sh, size_t argc, char **argv)
+{
+	struct sched_state s;
+
+	adaptive_sched_get(&s);
+
+	shell_fprintf(sh, SHELL_NORMAL, "{\"activity_permille\":%u", s.activity_permille);
+
+	for (int i = 0; i < SCHED_OUT_COUNT; i++) {
+		shell_fprintf(sh, SHELL_NORMAL,
+			      ",\"%s\":{\"interval_ms\":%u,\"min_ms\":%u,\"max_ms\":%u,"
+			      "\"runs\":%u,\"skipped\":%u}",
+			      output_names[i], s.interval_ms[i], bounds[i].min_ms,
+			      bounds[i].max_ms, s.runs[i], s.skipped[i]);
+	}
+
+	shell_fprintf(sh, SHELL_NORMAL, "}\n");
+
+	return 0;
+}
+
+SHELL_SUBCMD_ADD((diag), sched, NULL, "Adaptive scheduler decisions (JSON)",
+		 cmd_diag_sched, 1, 0);
+#endif /* CONFIG_SHELL */
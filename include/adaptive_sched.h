@@ -0,0 +1,64 @@
+#ifndef ADAPTIVE_SCHED_H
+#define ADAPTIVE_SCHED_H
+
+#include <zephyr/kernel.h>
+
+/**
+ * @brief Outputs paced by the adaptive scheduler
+ */
+enum sched_output {
+	SCHED_OUT_SAMPLE = 0,  /* Sensor sampling and BLE notifications */
+	SCHED_OUT_DISPLAY,     /* E-paper refresh */
+	SCHED_OUT_ADV,         /* Sensor broadcast in the advertising data */
+	SCHED_OUT_COUNT,
+};
+
+/**
+ * @brief Current scheduler decisions
+ */
+struct sched_state {
+	uint16_t activity_permille;           /* Smoothed rate of change, 1000 = fast */
+	uint32_t interval_ms[SCHED_OUT_COUNT]; /* Current interval per output */
+	uint32_t runs[SCHED_OUT_COUNT];        /* Times the output was due */
+	uint32_t skipped[SCHED_OUT_COUNT];     /* Samples the output was held back */
+};
+
+/**
+ * @brief Feed a new reading
+ *
+ * Updates the rate of change and, from it, the interval of every output
+ * within its configured bounds. Fast changes shorten the intervals at
+ * once, calm readings stretch them again over several samples.
+ *
+ * @param temp_celsius Temperature in Celsius * 100
+ * @param humidity_percent Humidity in percent * 100
+ */
+void adaptive_sched_observe(int16_t temp_celsius, uint16_t humidity_percent);
+
+/**
+ * @brief Get the current interval of an output
+ *
+ * @param out Output
+ * @return Interval in milliseconds
+ */
+uint32_t adaptive_sched_interval_ms(enum sched_output out);
+
+/**
+ * @brief Check whether an output is due at this sample
+ *
+ * Outputs are checked on every sample, so an output counts as due when
+ * less than half a sample interval of its own interval is left.
+ *
+ * @param out Output
+ * @return true if the output should run now; it is then marked as run
+ */
+bool adaptive_sched_due(enum sched_output out);
+
+/**
+ * @brief Get a snapshot of the scheduler decisions
+ *
+ * @param out Destination snapshot
+ */
+void adaptive_sched_get(struct sched_state *out);
+
+#endif /* ADAPTIVE_SCHED_H */
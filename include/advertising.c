@@ -0,0 +1,188 @@
+#include "advertising.h"
+#include "ble_metrics.h"
+#include <zephyr/bluetooth/bluetooth.h>
+#include <zephyr/bluetooth/conn.h>
+#include <zephyr/bluetooth/gap.h>
+#include <zephyr/bluetooth/hci.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/logging/log.h>
+
+LOG_MODULE_REGISTER(advertising, CONFIG_APP_ADV_LOG_LEVEL);
+
+/* ESS UUID followed by the sensor broadcast */
+static uint8_t sensor_data[2 + ADV_SENSOR_LEN] = {
+	0x1A, 0x18,  /* Environmental Sensing Service (0x181A) - little endian */
+	SENSOR_RECORD_VERSION,
+};
+
+/* BLE advertising data */
+static const struct bt_data ad[] = {
+	BT_DATA_BYTES(BT_DATA_FLAGS, (BT_LE_AD_GENERAL | BT_LE_AD_NO_BREDR)),
+	BT_DATA_BYTES(BT_DATA_UUID16_ALL,
+		      0x1A, 0x18,  /* Environmental Sensing Service (0x181A) - little endian */
+		      0x0F, 0x18,  /* Battery Service (0x180F) - little endian */
+		      0xE0, 0xFF), /* RGB LED Service (0xFFE0) - little endian */
+	BT_DATA(BT_DATA_SVC_DATA16, sensor_data, sizeof(sensor_data)),
+};
+
+static const struct bt_data sd[] = {
+	BT_DATA(BT_DATA_NAME_COMPLETE, CONFIG_BT_DEVICE_NAME, sizeof(CONFIG_BT_DEVICE_NAME) - 1),
+};
+
+/* Not set when the advertiser is owned by someone else (mesh) */
+static bool started;
+
+/* High duty directed advertising towards the last bonded central */
+static bool directed;
+static bool resume_undirected; /* Directed advertising is not resumed by the host */
+static bt_addr_le_t last_central;
+
+int advertising_start(void)
+{
+	struct bt_le_adv_param adv_param = {
+		.id = BT_ID_DEFAULT,
+		.sid = 0,
+		.secondary_max_skip = 0,
+		.options = BT_LE_ADV_OPT_CONN,
+		.interval_min = BT_GAP_ADV_FAST_INT_MIN_2,
+		.interval_max = BT_GAP_ADV_FAST_INT_MAX_2,
+		.peer = NULL,
+	};
+	int err;
+
+	err = bt_le_adv_start(&adv_param, ad, ARRAY_SIZE(ad), sd, ARRAY_SIZE(sd));
+	if (err) {
+		return err;
+	}
+	started = true;
+	directed = false;
+	resume_undirected = false;
+	ble_metrics_adv_started();
+
+	LOG_INF("Advertising started as '%s'", CONFIG_BT_DEVICE_NAME);
+	return 0;
+}
+
+int advertising_burst(uint32_t duration_ms)
+{
+	struct bt_le_adv_param adv_param = {
+		.id = BT_ID_DEFAULT,
+		.options = BT_LE_ADV_OPT_SCANNABLE,
+		.interval_min = BT_GAP_ADV_FAST_INT_MIN_2,
+		.interval_max = BT_GAP_ADV_FAST_INT_MAX_2,
+	};
+	int err;
+
+	err = bt_le_adv_start(&adv_param, ad, ARRAY_SIZE(ad), sd, ARRAY_SIZE(sd));
+	if (err) {
+		return err;
+	}
+
+	k_sleep(K_MSEC(duration_ms));
+
+	return bt_le_adv_stop();
+}
+
+void advertising_set_record(const struct sensor_record *rec)
+{
+	int err;
+
+	sensor_record_encode(rec, &sensor_data[2]);
+
+	/* Directed advertising carries no data */
+	if (!started || directed) {
+		return;
+	}
+
+	/* Fails while connected, the next update catches up */
+	err = bt_le_adv_update_data(ad, ARRAY_SIZE(ad), sd, ARRAY_SIZE(sd));
+	if (err && err != -EAGAIN) {
+		LOG_WRN("Advertising data update failed (err %d)", err);
+	}
+}
+
+#if defined(CONFIG_APP_ADV_DIRECTED_RECONNECT)
+/*
+ * The host resumes undirected advertising after a disconnect. Replace it
+ * with 1.28 s of high duty directed advertising, so the bonded central
+ * reconnects within a few milliseconds instead of waiting for its scan.
+ */
+static void directed_handler(struct k_work *work)
+{
+	struct bt_le_adv_param adv_param = {
+		.id = BT_ID_DEFAULT,
+		.options = BT_LE_ADV_OPT_CONN | BT_LE_ADV_OPT_ONE_TIME,
+		.peer = &last_central,
+	};
+	char addr[BT_ADDR_LE_STR_LEN];
+	int err;
+
+	bt_le_adv_stop();
+
+	err = bt_le_adv_start(&adv_param, NULL, 0, NULL, 0);
+	if (err) {
+		LOG_WRN("Directed advertising failed (err %d)", err);
+		advertising_start();
+		return;
+	}
+	directed = true;
+	ble_metrics_adv_started();
+
+	bt_addr_le_to_str(&last_central, addr, sizeof(addr));
+	LOG_INF("Directed advertising to %s", addr);
+}
+
+static K_WORK_DEFINE(directed_work, directed_handler);
+
+/* Back to undirected advertising after a directed burst */
+static void undirected_handler(struct k_work *work)
+{
+	int err = advertising_start();
+
+	if (err) {
+		LOG_ERR("Advertising failed to restart (err %d)", err);
+	}
+}
+
+static K_WORK_DEFINE(undirected_work, undirected_handler);
+
+static void adv_connected(struct bt_conn *conn, uint8_t err)
+{
+	if (!directed) {
+		return;
+	}
+
+	if (err == BT_HCI_ERR_ADV_TIMEOUT) {
+		LOG_INF("Directed advertising timed out");
+		k_work_submit(&undirected_work);
+		return;
+	}
+
+	directed = false;
+	resume_undirected = !err;
+}
+
+static void adv_disconnected(struct bt_conn *conn, uint8_t reason)
+{
+	const bt_addr_le_t *dst = bt_conn_get_dst(conn);
+
+	if (!started) {
+		return;
+	}
+
+	if (!bt_addr_le_is_bonded(BT_ID_DEFAULT, dst)) {
+		if (resume_undirected) {
+			k_work_submit(&undirected_work);
+		}
+		return;
+	}
+
+	bt_addr_le_copy(&last_central, dst);
+	k_work_submit(&directed_work);
+}
+
+BT_CONN_CB_DEFINE(adv_conn_callbacks) = {
+	.connected = adv_connected,
+	.disconnected = adv_disconnected,
+};
+#endif /* CONFIG_APP_ADV_DIRECTED_RECONNECT */
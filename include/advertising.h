@@ -0,0 +1,43 @@
+#ifndef ADVERTISING_H
+#define ADVERTISING_H
+
+#include <zephyr/kernel.h>
+#include "sensor_record.h"
+
+/*
+ * Sensor broadcast carried as ESS (0x181A) service data so neighbouring
+ * nodes can pick up readings without connecting: the ESS UUID followed
+ * by the latest sensor record (sensor_record.h).
+ */
+#define ADV_SENSOR_LEN SENSOR_RECORD_LEN
+
+/**
+ * @brief Start connectable advertising
+ *
+ * With CONFIG_APP_ADV_DIRECTED_RECONNECT, a disconnect from a bonded
+ * central is followed by high duty directed advertising to it before
+ * undirected advertising resumes.
+ *
+ * @return 0 on success, negative errno on failure
+ */
+int advertising_start(void);
+
+/**
+ * @brief Broadcast the sensor data in a non-connectable burst
+ *
+ * Blocks for the whole burst. Used by the low-duty mode, where the node
+ * does not advertise between bursts.
+ *
+ * @param duration_ms Burst length in milliseconds
+ * @return 0 on success, negative errno on failure
+ */
+int advertising_burst(uint32_t duration_ms);
+
+/**
+ * @brief Update the sensor broadcast in the advertising data
+ *
+ * @param rec Latest sensor record
+ */
+void advertising_set_record(const struct sensor_record *rec);
+
+#endif /* ADVERTISING_H */
@@ -1,45 +1,86 @@
 #include "battery.h"
+#include "display_epaper.h"
+#include "diagnostics.h"
+#include "trace.h"
+#include "workqueues.h"
 #include <zephyr/device.h>
 #include <zephyr/drivers/adc.h>
 #include <zephyr/drivers/gpio.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/crc.h>
 #include <zephyr/logging/log.h>
+#include <stddef.h>
+#include <string.h>
 
-LOG_MODULE_REGISTER(battery, LOG_LEVEL_INF);
+LOG_MODULE_REGISTER(battery, CONFIG_APP_BATTERY_LOG_LEVEL);
 
 /* ADC settings for nRF52840 */
 #define ADC_DEVICE_NODE DT_NODELABEL(adc)
 #define ADC_RESOLUTION 12  /* 12-bit resolution */
 #define ADC_GAIN ADC_GAIN_1_6
 #define ADC_REFERENCE ADC_REF_INTERNAL
-#define ADC_ACQUISITION_TIME ADC_ACQ_TIME(ADC_ACQ_TIME_MICROSECONDS, 10)
-#define ADC_CHANNEL_ID 7  /* Use channel 7 for AIN7 (P0.31) */
+/* 40us acquisition is needed for the ~340k source impedance of the divider */
+#define ADC_ACQUISITION_TIME ADC_ACQ_TIME(ADC_ACQ_TIME_MICROSECONDS, 40)
+#define ADC_OVERSAMPLING 4  /* SAADC averages 2^4 = 16 samples in hardware */
 
 /* XIAO nRF52840 battery monitoring pins */
 #define VBAT_ENABLE_PIN 14  /* P0.14 - enables voltage divider when LOW */
 #define VBAT_ADC_PIN 31     /* P0.31 - AIN7 - battery voltage input */
 
-/* Voltage divider: 1M + 510k resistors = (1000 + 510) / 510 ≈ 2.96 */
-#define VBAT_DIVIDER_NUMERATOR 1510
-#define VBAT_DIVIDER_DENOMINATOR 510
+/*
+ * Compile-time lookup tables from ADC code to mV and percent over the
+ * VBAT_LUT_FIRST_CODE range (battery_math.h). Codes outside fall back to
+ * the arithmetic conversion.
+ */
+#define VBAT_LUT_MV(i, _) VBAT_CODE_TO_MV(VBAT_LUT_FIRST_CODE + (i))
+#define VBAT_LUT_PCT(i, _) VBAT_MV_TO_PCT(VBAT_LUT_MV(i, _))
 
-/* Calibration factor to compensate for ADC/resistor tolerances */
-/* Adjust this based on multimeter readings: (actual_voltage / measured_voltage) * 1000 */
-#define VBAT_CALIBRATION_FACTOR 1029  /* 1.029 * 1000 - adjusted for 4.00V target */
+static const uint16_t vbat_mv_lut[VBAT_LUT_SIZE] = {
+	LISTIFY(VBAT_LUT_SIZE, VBAT_LUT_MV, (,))
+};
+
+static const uint8_t vbat_pct_lut[VBAT_LUT_SIZE] = {
+	LISTIFY(VBAT_LUT_SIZE, VBAT_LUT_PCT, (,))
+};
+
+BUILD_ASSERT(VBAT_CODE_TO_MV(VBAT_LUT_FIRST_CODE) < 3300 &&
+	     VBAT_CODE_TO_MV(VBAT_LUT_FIRST_CODE + VBAT_LUT_SIZE - 1) > 4200,
+	     "Battery LUT must span the whole discharge curve");
 
-/* Moving average filter settings */
+/* Measurement window timing */
+#define VBAT_SETTLE_TIME_MS 2         /* Divider settle time after enabling */
+#define VBAT_CONVERSION_TIMEOUT_MS 20 /* Upper bound for one oversampled conversion */
+#define VBAT_DISPLAY_RETRY_MS 250     /* Retry delay while the panel is refreshing */
+#define VBAT_DISPLAY_WAIT_MS 5000     /* Longest blocking wait for the panel */
+
+/* Moving average filter settings (averaged in the ADC code domain) */
 #define VBAT_SAMPLE_COUNT 8  /* Number of samples to average */
-static uint16_t voltage_samples[VBAT_SAMPLE_COUNT];
-static uint8_t sample_index = 0;
-static bool samples_filled = false;
+#define VBAT_FILTER_MAGIC 0x56424154  /* "VBAT" */
+
+/* Kept across warm resets, so the average does not start over */
+struct vbat_filter {
+	uint32_t magic;
+	uint16_t code_samples[VBAT_SAMPLE_COUNT];
+	uint8_t sample_index;
+	bool samples_filled;
+	uint32_t crc;  /* CRC32 of the fields above */
+};
+
+static __noinit struct vbat_filter filter;
+static uint16_t last_voltage;
+static uint8_t last_percentage;
 
 static const struct device *adc_dev;
+static const struct device *gpio_dev;
 
 static struct adc_channel_cfg channel_cfg = {
 	.gain = ADC_GAIN,
 	.reference = ADC_REFERENCE,
 	.acquisition_time = ADC_ACQUISITION_TIME,
-	.channel_id = ADC_CHANNEL_ID,
+	.channel_id = BATTERY_ADC_CHANNEL,
+#if defined(CONFIG_ADC_CONFIGURABLE_INPUTS)
 	.input_positive = SAADC_CH_PSELP_PSELP_AnalogInput7,  /* P0.31 / AIN7 */
+#endif
 };
 
 static int16_t sample_buffer;
@@ -47,12 +88,241 @@ static struct adc_sequence sequence = {
 	.buffer = &sample_buffer,
 	.buffer_size = sizeof(sample_buffer),
 	.resolution = ADC_RESOLUTION,
+	.oversampling = ADC_OVERSAMPLING,
 };
 
+/* Asynchronous measurement state */
+static atomic_t measuring;
+static battery_measure_cb_t measure_cb;
+
+static struct k_poll_signal adc_signal;
+static struct k_poll_event adc_events[1];
+
+static void measure_start(struct k_work *work);
+static void measure_sample(struct k_work *work);
+static void measure_done(struct k_work *work);
+
+static K_WORK_DELAYABLE_DEFINE(measure_start_work, measure_start);
+static K_WORK_DELAYABLE_DEFINE(measure_sample_work, measure_sample);
+static struct k_work_poll measure_done_work;
+static struct k_work_poll measure_drain_work;
+static struct wq_stamp measure_start_stamp;
+static struct wq_stamp measure_sample_stamp;
+
+/* Drive P0.14 LOW to connect the divider to ground */
+static int divider_enable(void)
+{
+	return gpio_pin_configure(gpio_dev, VBAT_ENABLE_PIN, GPIO_OUTPUT_LOW);
+}
+
+/*
+ * Leave P0.14 floating so no current flows through the divider. P0.31
+ * then sits at VBAT through the 1M resistor, as it would with P0.14
+ * driven HIGH; the resistor keeps the current into the pin clamp below
+ * a microamp. Floating is preferred as P0.14 then never drives the
+ * divider from VDD when VBAT is lower (USB powered).
+ */
+static int divider_disable(void)
+{
+	return gpio_pin_configure(gpio_dev, VBAT_ENABLE_PIN, GPIO_DISCONNECTED);
+}
+
+static uint32_t filter_crc(void)
+{
+	return crc32_ieee((const uint8_t *)&filter, offsetof(struct vbat_filter, crc));
+}
+
+static bool filter_valid(void)
+{
+	return filter.magic == VBAT_FILTER_MAGIC && filter.crc == filter_crc() &&
+	       filter.sample_index < VBAT_SAMPLE_COUNT;
+}
+
+static uint16_t filter_average(void)
+{
+	uint32_t sum = 0;
+
+	uint8_t samples_to_average = filter.samples_filled ? VBAT_SAMPLE_COUNT : filter.sample_index;
+	if (samples_to_average == 0) {
+		samples_to_average = 1;  /* At least use the current sample */
+	}
+
+	for (uint8_t i = 0; i < samples_to_average; i++) {
+		sum += filter.code_samples[i];
+	}
+
+	return (uint16_t)((sum + samples_to_average / 2) / samples_to_average);
+}
+
+static uint16_t filter_push(int16_t raw)
+{
+	/* SAADC can report slightly negative codes around 0V */
+	filter.code_samples[filter.sample_index] = (uint16_t)MAX(raw, 0);
+	filter.sample_index = (filter.sample_index + 1) % VBAT_SAMPLE_COUNT;
+
+	/* Mark buffer as filled after first full cycle */
+	if (filter.sample_index == 0) {
+		filter.samples_filled = true;
+	}
+	filter.crc = filter_crc();
+
+	return filter_average();
+}
+
+/* Convert an averaged code, one table lookup on the common path */
+static void set_voltage(uint16_t code)
+{
+	uint16_t index = code - VBAT_LUT_FIRST_CODE;
+
+	if (code >= VBAT_LUT_FIRST_CODE && index < VBAT_LUT_SIZE) {
+		last_voltage = vbat_mv_lut[index];
+		last_percentage = vbat_pct_lut[index];
+	} else {
+		last_voltage = VBAT_CODE_TO_MV(code);
+		last_percentage = VBAT_MV_TO_PCT(last_voltage);
+	}
+}
+
+static uint16_t update_voltage(int16_t raw)
+{
+	uint16_t code = filter_push(raw);
+
+	set_voltage(code);
+
+	LOG_DBG("ADC raw %d, averaged code %u: %u mV (%u%%)",
+		raw, code, last_voltage, last_percentage);
+
+	return last_voltage;
+}
+
+/* Hand the result to the caller, the ADC stays owned */
+static void measure_report(int err)
+{
+	battery_measure_cb_t cb = measure_cb;
+
+	measure_cb = NULL;
+
+	if (cb) {
+		cb(err, last_voltage);
+	}
+}
+
+static void measure_finish(int err)
+{
+	atomic_clear(&measuring);
+	measure_report(err);
+}
+
+/* A timed out conversion completed late, only now may the next one start */
+static void measure_drained(struct k_work *work)
+{
+	unsigned int signaled;
+	int result;
+
+	k_poll_signal_check(&adc_signal, &signaled, &result);
+	LOG_WRN("Late ADC conversion done (%d), discarded", result);
+
+	atomic_clear(&measuring);
+}
+
+static void measure_start(struct k_work *work)
+{
+	int ret;
+
+	wq_started(WQ_SENSING, &measure_start_stamp);
+	TRACE_BEGIN(TRACE_SPAN_WORK, TRACE_WORK_BATTERY_START);
+
+	/* Refresh current sags the supply, so wait for the panel to go idle */
+	if (display_is_busy()) {
+		wq_schedule(WQ_SENSING, &measure_start_work, &measure_start_stamp,
+			    K_MSEC(VBAT_DISPLAY_RETRY_MS));
+	} else if ((ret = divider_enable()) != 0) {
+		LOG_ERR("Failed to enable voltage divider: %d", ret);
+		measure_finish(ret);
+	} else {
+		wq_schedule(WQ_SENSING, &measure_sample_work, &measure_sample_stamp,
+			    K_MSEC(VBAT_SETTLE_TIME_MS));
+	}
+
+	TRACE_END(TRACE_SPAN_WORK, TRACE_WORK_BATTERY_START);
+}
+
+static void measure_sample(struct k_work *work)
+{
+	int ret;
+
+	wq_started(WQ_SENSING, &measure_sample_stamp);
+	TRACE_BEGIN(TRACE_SPAN_WORK, TRACE_WORK_BATTERY_SAMPLE);
+
+	k_poll_signal_reset(&adc_signal);
+	k_poll_event_init(&adc_events[0], K_POLL_TYPE_SIGNAL,
+			  K_POLL_MODE_NOTIFY_ONLY, &adc_signal);
+
+	/* Conversion span ends in measure_done() */
+	TRACE_BEGIN(TRACE_SPAN_BATTERY_READ, 0);
+
+	ret = adc_read_async(adc_dev, &sequence, &adc_signal);
+	if (ret == 0) {
+		/* Completion is handled off the signal, the workqueue stays free meanwhile */
+		ret = k_work_poll_submit_to_queue(wq_queue(WQ_SENSING), &measure_done_work,
+						  adc_events, ARRAY_SIZE(adc_events),
+						  K_MSEC(VBAT_CONVERSION_TIMEOUT_MS));
+	}
+
+	if (ret != 0) {
+		LOG_ERR("ADC async read failed: %d", ret);
+		TRACE_END(TRACE_SPAN_BATTERY_READ, 0);
+		divider_disable();
+		measure_finish(ret);
+	}
+
+	TRACE_END(TRACE_SPAN_WORK, TRACE_WORK_BATTERY_SAMPLE);
+}
+
+static void measure_done(struct k_work *work)
+{
+	unsigned int signaled;
+	int result;
+
+	TRACE_END(TRACE_SPAN_BATTERY_READ, 0);
+	TRACE_BEGIN(TRACE_SPAN_WORK, TRACE_WORK_BATTERY_DONE);
+
+	divider_disable();
+
+	k_poll_signal_check(&adc_signal, &signaled, &result);
+	if (!signaled) {
+		/*
+		 * The conversion is still pending and holds the ADC, a new
+		 * read would block on it. Report the timeout now but keep
+		 * measurements off until the pending one completed.
+		 */
+		LOG_ERR("ADC conversion timed out");
+		if (k_work_poll_submit_to_queue(wq_queue(WQ_SENSING), &measure_drain_work,
+						adc_events, ARRAY_SIZE(adc_events),
+						K_FOREVER) != 0) {
+			atomic_clear(&measuring);
+		}
+		measure_report(-ETIMEDOUT);
+	} else if (result != 0) {
+		LOG_ERR("ADC conversion failed: %d", result);
+		measure_finish(result);
+	} else if (display_is_busy()) {
+		/* A refresh started during the window: the sample is skewed, take another */
+		LOG_DBG("Panel refresh overlapped measurement, retrying");
+		wq_schedule(WQ_SENSING, &measure_start_work, &measure_start_stamp,
+			    K_MSEC(VBAT_DISPLAY_RETRY_MS));
+	} else {
+		diag_record_adc_conversion(BIT(ADC_OVERSAMPLING));
+		update_voltage(sample_buffer);
+		measure_finish(0);
+	}
+
+	TRACE_END(TRACE_SPAN_WORK, TRACE_WORK_BATTERY_DONE);
+}
+
 int battery_init(void)
 {
 	int ret;
-	const struct device *gpio_dev;
 
 	/* Get GPIO device for P0.14 (VBAT_ENABLE) */
 	gpio_dev = DEVICE_DT_GET(DT_NODELABEL(gpio0));
@@ -61,20 +331,13 @@ int battery_init(void)
 		return -ENODEV;
 	}
 
-	/* Configure P0.14 as output and set LOW to enable voltage divider */
-	ret = gpio_pin_configure(gpio_dev, VBAT_ENABLE_PIN, GPIO_OUTPUT_ACTIVE);
+	/* Keep the divider disconnected until a measurement is requested */
+	ret = divider_disable();
 	if (ret != 0) {
 		LOG_ERR("Failed to configure VBAT_ENABLE pin: %d", ret);
 		return ret;
 	}
 
-	/* Set P0.14 LOW to enable battery voltage reading */
-	ret = gpio_pin_set(gpio_dev, VBAT_ENABLE_PIN, 0);
-	if (ret != 0) {
-		LOG_ERR("Failed to set VBAT_ENABLE LOW: %d", ret);
-		return ret;
-	}
-
 	/* Initialize ADC */
 	adc_dev = DEVICE_DT_GET(ADC_DEVICE_NODE);
 	if (!device_is_ready(adc_dev)) {
@@ -89,7 +352,23 @@ int battery_init(void)
 	}
 
 	/* Set channel mask for the sequence */
-	sequence.channels = BIT(ADC_CHANNEL_ID);
+	sequence.channels = BIT(BATTERY_ADC_CHANNEL);
+
+	diag_register_buffer("battery.filter", sizeof(filter));
+
+	k_poll_signal_init(&adc_signal);
+	k_work_poll_init(&measure_done_work, measure_done);
+	k_work_poll_init(&measure_drain_work, measure_drained);
+
+	/* After a warm reset the level is known before the first conversion */
+	if (filter_valid()) {
+		set_voltage(filter_average());
+		LOG_INF("Battery filter restored: %u mV (%u%%)", last_voltage, last_percentage);
+	} else {
+		memset(&filter, 0, sizeof(filter));
+		filter.magic = VBAT_FILTER_MAGIC;
+		filter.crc = filter_crc();
+	}
 
 	LOG_INF("Battery monitoring initialized (P0.31/AIN7)");
 	return 0;
@@ -97,91 +376,71 @@ int battery_init(void)
 
 uint16_t battery_read_voltage(void)
 {
+	int64_t wait_start = k_uptime_get();
 	int ret;
-	int32_t val_mv;
-	int32_t adc_voltage;
-	uint32_t average_voltage = 0;
 
-	ret = adc_read(adc_dev, &sequence);
-	if (ret != 0) {
-		LOG_ERR("ADC read failed: %d", ret);
-		return 0;
+	/* Refresh current sags the supply, so wait for the panel to go idle */
+	while (display_is_busy()) {
+		if (k_uptime_get() - wait_start >= VBAT_DISPLAY_WAIT_MS) {
+			LOG_WRN("Panel still busy, keeping %u mV", last_voltage);
+			return last_voltage;
+		}
+		k_sleep(K_MSEC(VBAT_DISPLAY_RETRY_MS));
 	}
 
-	LOG_INF("ADC raw value: %d", sample_buffer);
-
-	/* Convert ADC value to millivolts */
-	/* With internal reference (0.6V) and gain 1/6: */
-	/* ADC voltage = sample * (600mV * 6) / 4096 */
-	val_mv = sample_buffer;
-	adc_voltage = (val_mv * 600 * 6) / 4096;
-
-	LOG_INF("ADC voltage (before divider): %d mV", adc_voltage);
-
-	/* Apply voltage divider ratio to get actual battery voltage */
-	/* Battery voltage = ADC voltage * (1510 / 510) */
-	val_mv = (adc_voltage * VBAT_DIVIDER_NUMERATOR) / VBAT_DIVIDER_DENOMINATOR;
+	/* An asynchronous measurement owns the ADC, return its last result */
+	if (!atomic_cas(&measuring, 0, 1)) {
+		return last_voltage;
+	}
 
-	/* Apply calibration factor */
-	val_mv = (val_mv * VBAT_CALIBRATION_FACTOR) / 1000;
+	ret = divider_enable();
+	if (ret != 0) {
+		LOG_ERR("Failed to enable voltage divider: %d", ret);
+		atomic_clear(&measuring);
+		return 0;
+	}
 
-	LOG_INF("Battery voltage (before averaging): %d mV", val_mv);
+	k_sleep(K_MSEC(VBAT_SETTLE_TIME_MS));
 
-	/* Store sample in circular buffer */
-	voltage_samples[sample_index] = (uint16_t)val_mv;
-	sample_index = (sample_index + 1) % VBAT_SAMPLE_COUNT;
+	TRACE_BEGIN(TRACE_SPAN_BATTERY_READ, 0);
+	ret = adc_read(adc_dev, &sequence);
+	TRACE_END(TRACE_SPAN_BATTERY_READ, 0);
+	divider_disable();
+	atomic_clear(&measuring);
 
-	/* Mark buffer as filled after first full cycle */
-	if (sample_index == 0) {
-		samples_filled = true;
+	if (ret != 0) {
+		LOG_ERR("ADC read failed: %d", ret);
+		return 0;
 	}
 
-	/* Calculate moving average */
-	uint8_t samples_to_average = samples_filled ? VBAT_SAMPLE_COUNT : sample_index;
-	if (samples_to_average == 0) {
-		samples_to_average = 1;  /* At least use the current sample */
-	}
+	diag_record_adc_conversion(BIT(ADC_OVERSAMPLING));
+	return update_voltage(sample_buffer);
+}
 
-	for (uint8_t i = 0; i < samples_to_average; i++) {
-		average_voltage += voltage_samples[i];
+int battery_measure_async(battery_measure_cb_t cb)
+{
+	if (!atomic_cas(&measuring, 0, 1)) {
+		return -EBUSY;
 	}
-	average_voltage /= samples_to_average;
 
-	LOG_INF("Battery voltage (after averaging %d samples): %d mV",
-		samples_to_average, average_voltage);
+	measure_cb = cb;
+	wq_schedule(WQ_SENSING, &measure_start_work, &measure_start_stamp, K_NO_WAIT);
 
-	return (uint16_t)average_voltage;
+	return 0;
 }
 
-uint8_t battery_get_percentage(uint16_t mv)
+uint16_t battery_get_voltage(void)
 {
-    // Li-ion voltage curve (4.20V to 3.30V)
-    const uint16_t voltage_table[] = {
-        4200, 4100, 4000, 3900, 3800, 3700, 3600, 3500, 3400, 3300
-    };
-
-    const uint8_t percent_table[] = {
-        100,  96,   90,   80,   60,   40,   25,   10,    5,    0
-    };
-
-    // Above max → 100%
-    if (mv >= 4000) return 100;
-    // Below min → 0%
-    if (mv <= 3300) return 0;
-
-    // Piecewise linear interpolation
-    for (int i = 0; i < 9; i++) {
-        if (mv >= voltage_table[i+1]) {
-            uint16_t v1 = voltage_table[i];
-            uint16_t v2 = voltage_table[i+1];
-            uint8_t p1 = percent_table[i];
-            uint8_t p2 = percent_table[i+1];
-
-            // Linear interpolation between table points
-            return p1 - ((p1 - p2) * (v1 - mv) / (v1 - v2));
-        }
-    }
+	return last_voltage;
+}
 
-    return 0; // should not happen
+uint8_t battery_get_level(void)
+{
+	return last_percentage;
 }
 
+uint8_t battery_get_percentage(uint16_t mv)
+{
+	/* Same curve as the lookup table, unrolled - no table search */
+	return VBAT_MV_TO_PCT(mv);
+}
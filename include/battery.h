@@ -2,6 +2,21 @@
 #define BATTERY_H
 
 #include <zephyr/kernel.h>
+#include "battery_math.h"
+
+/* SAADC channel of the battery input, AIN7 (P0.31) */
+#define BATTERY_ADC_CHANNEL 7
+
+/**
+ * @brief Battery measurement completion callback
+ *
+ * Called from the sensing work queue (WQ_SENSING) once an asynchronous
+ * measurement finishes.
+ *
+ * @param err 0 on success, negative errno on failure
+ * @param voltage_mv Filtered battery voltage in millivolts (last good value on failure)
+ */
+typedef void (*battery_measure_cb_t)(int err, uint16_t voltage_mv);
 
 /**
  * @brief Initialize battery monitoring
@@ -13,10 +28,44 @@ int battery_init(void);
 /**
  * @brief Read battery voltage
  *
+ * Blocking measurement: waits while the e-paper panel is refreshing (at
+ * most 5 s, then the last voltage is returned), enables the divider,
+ * waits for it to settle and samples it. Prefer battery_measure_async()
+ * from workqueue context.
+ *
  * @return Battery voltage in millivolts (mV)
  */
 uint16_t battery_read_voltage(void);
 
+/**
+ * @brief Start an asynchronous battery measurement
+ *
+ * The voltage divider is only enabled for the measurement window and the
+ * conversion is deferred while the e-paper panel is refreshing.
+ *
+ * @param cb Callback invoked with the result (may be NULL)
+ * @return 0 on success, -EBUSY if a measurement is already in progress
+ */
+int battery_measure_async(battery_measure_cb_t cb);
+
+/**
+ * @brief Get the last filtered battery voltage
+ *
+ * Does not trigger an ADC conversion.
+ *
+ * @return Battery voltage in millivolts (0 if never measured)
+ */
+uint16_t battery_get_voltage(void);
+
+/**
+ * @brief Get the battery percentage of the last filtered voltage
+ *
+ * Looked up together with the voltage, no conversion is done.
+ *
+ * @return Battery level as percentage (0 if never measured)
+ */
+uint8_t battery_get_level(void);
+
 /**
  * @brief Get battery percentage (0-100%)
  *
@@ -0,0 +1,56 @@
+#ifndef BATTERY_MATH_H
+#define BATTERY_MATH_H
+
+#include <stdint.h>
+
+/*
+ * Only plain C here, without Zephyr headers: the conversions are shared
+ * with the native_sim battery emulation (sensor_emul.c) and the host
+ * tests in tests/host.
+ */
+
+/* Voltage divider: 1M + 510k resistors = (1000 + 510) / 510 ≈ 2.96 */
+#define VBAT_DIVIDER_NUMERATOR 1510
+#define VBAT_DIVIDER_DENOMINATOR 510
+
+/* Calibration factor to compensate for ADC/resistor tolerances */
+/* Adjust this based on multimeter readings: (actual_voltage / measured_voltage) * 1000 */
+#define VBAT_CALIBRATION_FACTOR 1029  /* 1.029 * 1000 - adjusted for 4.00V target */
+
+/*
+ * Battery mV from a 12-bit code in one rounded step:
+ * code * (600mV * 6) / 4096 * (1510 / 510) * (1029 / 1000)
+ */
+#define VBAT_MV_NUM (600ULL * 6 * VBAT_DIVIDER_NUMERATOR * VBAT_CALIBRATION_FACTOR)
+#define VBAT_MV_DEN (4096ULL * VBAT_DIVIDER_DENOMINATOR * 1000)
+#define VBAT_CODE_TO_MV(code) \
+	((uint16_t)((((uint64_t)(code)) * VBAT_MV_NUM + VBAT_MV_DEN / 2) / VBAT_MV_DEN))
+
+/* Battery mV to the ADC pin, the inverse of the divider and calibration */
+#define VBAT_PIN_MV(mv)							\
+	((uint32_t)((uint64_t)(mv) * VBAT_DIVIDER_DENOMINATOR * 1000 /	\
+		    ((uint64_t)VBAT_DIVIDER_NUMERATOR * VBAT_CALIBRATION_FACTOR)))
+
+/*
+ * Range of the code to mV and percent lookup tables in battery.c, codes
+ * 1024..1791 (about 2.74V to 4.80V)
+ */
+#define VBAT_LUT_FIRST_CODE 1024
+#define VBAT_LUT_SIZE 768
+
+/* Li-ion discharge curve (4.20V to 3.30V), piecewise linear */
+#define VBAT_PCT_SEG(mv, v1, v2, p1, p2) \
+	((p1) - (((p1) - (p2)) * ((v1) - (mv)) / ((v1) - (v2))))
+#define VBAT_MV_TO_PCT(mv)						\
+	((mv) >= 4200 ? 100 :						\
+	 (mv) >= 4100 ? VBAT_PCT_SEG(mv, 4200, 4100, 100, 96) :	\
+	 (mv) >= 4000 ? VBAT_PCT_SEG(mv, 4100, 4000, 96, 90) :		\
+	 (mv) >= 3900 ? VBAT_PCT_SEG(mv, 4000, 3900, 90, 80) :		\
+	 (mv) >= 3800 ? VBAT_PCT_SEG(mv, 3900, 3800, 80, 60) :		\
+	 (mv) >= 3700 ? VBAT_PCT_SEG(mv, 3800, 3700, 60, 40) :		\
+	 (mv) >= 3600 ? VBAT_PCT_SEG(mv, 3700, 3600, 40, 25) :		\
+	 (mv) >= 3500 ? VBAT_PCT_SEG(mv, 3600, 3500, 25, 10) :		\
+	 (mv) >= 3400 ? VBAT_PCT_SEG(mv, 3500, 3400, 10, 5) :		\
+	 (mv) > 3300 ? VBAT_PCT_SEG(mv, 3400, 3300, 5, 0) : 0)
+
+#endif /* BATTERY_MATH_H */
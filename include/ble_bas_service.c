@@ -0,0 +1,101 @@
+#include "ble_bas_service.h"
+#include <stdlib.h>
+#include <zephyr/bluetooth/bluetooth.h>
+#include <zephyr/bluetooth/gatt.h>
+#include <zephyr/bluetooth/uuid.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/logging/log.h>
+
+LOG_MODULE_REGISTER(ble_bas, CONFIG_APP_BLE_BAS_LOG_LEVEL);
+
+/* Battery voltage characteristic (custom, mV) */
+#define BATTERY_VOLTAGE_UUID_VAL 0xFFF1
+
+#define BT_UUID_BATTERY_VOLTAGE BT_UUID_DECLARE_16(BATTERY_VOLTAGE_UUID_VAL)
+
+/* Attribute index of the Battery Level value in bas_svc */
+#define BAS_ATTR_LEVEL 2
+
+/* Encoded values - reads are served from here, never from the ADC */
+static uint8_t battery_level = 100;
+static uint16_t battery_voltage_le;
+static uint8_t notified_level = 100;
+static bool level_notify_enabled;
+
+static void level_ccc_changed(const struct bt_gatt_attr *attr, uint16_t value)
+{
+	level_notify_enabled = (value == BT_GATT_CCC_NOTIFY);
+	LOG_INF("Battery Level notifications %s", level_notify_enabled ? "enabled" : "disabled");
+}
+
+/* Battery Level Characteristic Read Callback */
+static ssize_t read_level(struct bt_conn *conn,
+			  const struct bt_gatt_attr *attr,
+			  void *buf, uint16_t len, uint16_t offset)
+{
+	return bt_gatt_attr_read(conn, attr, buf, len, offset,
+				 &battery_level, sizeof(battery_level));
+}
+
+#if defined(CONFIG_APP_BAS_VOLTAGE)
+/* Battery Voltage Characteristic Read Callback */
+static ssize_t read_voltage(struct bt_conn *conn,
+			    const struct bt_gatt_attr *attr,
+			    void *buf, uint16_t len, uint16_t offset)
+{
+	return bt_gatt_attr_read(conn, attr, buf, len, offset,
+				 &battery_voltage_le, sizeof(battery_voltage_le));
+}
+#endif
+
+/* Battery Service Declaration */
+BT_GATT_SERVICE_DEFINE(bas_svc,
+	BT_GATT_PRIMARY_SERVICE(BT_UUID_BAS),
+
+	/* Battery Level Characteristic */
+	BT_GATT_CHARACTERISTIC(BT_UUID_BAS_BATTERY_LEVEL,
+			       BT_GATT_CHRC_READ | BT_GATT_CHRC_NOTIFY,
+			       BT_GATT_PERM_READ,
+			       read_level, NULL, NULL),
+	BT_GATT_CCC(level_ccc_changed, BT_GATT_PERM_READ | BT_GATT_PERM_WRITE),
+
+#if defined(CONFIG_APP_BAS_VOLTAGE)
+	/* Battery Voltage Characteristic (mV) */
+	BT_GATT_CHARACTERISTIC(BT_UUID_BATTERY_VOLTAGE,
+			       BT_GATT_CHRC_READ,
+			       BT_GATT_PERM_READ,
+			       read_voltage, NULL, NULL),
+#endif
+);
+
+void bas_update_battery(uint16_t voltage_mv, uint8_t percentage)
+{
+	int err;
+
+	battery_voltage_le = sys_cpu_to_le16(voltage_mv);
+	battery_level = MIN(percentage, 100);
+
+	if (abs((int)battery_level - (int)notified_level) < CONFIG_APP_BAS_NOTIFY_STEP) {
+		return;
+	}
+
+	if (!level_notify_enabled) {
+		return;
+	}
+
+	err = bt_gatt_notify(NULL, &bas_svc.attrs[BAS_ATTR_LEVEL],
+			     &battery_level, sizeof(battery_level));
+	if (err != 0 && err != -ENOTCONN) {
+		LOG_WRN("Battery Level notify failed (err %d)", err);
+		return;
+	}
+
+	notified_level = battery_level;
+	LOG_DBG("Battery Level notified: %d%%", battery_level);
+}
+
+int ble_bas_service_init(void)
+{
+	LOG_INF("Battery Service initialized (notify step %d%%)", CONFIG_APP_BAS_NOTIFY_STEP);
+	return 0;
+}
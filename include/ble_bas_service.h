@@ -0,0 +1,24 @@
+#ifndef BLE_BAS_SERVICE_H
+#define BLE_BAS_SERVICE_H
+
+#include <zephyr/kernel.h>
+
+/**
+ * @brief Initialize the Battery Service
+ *
+ * @return 0 on success, negative errno on failure
+ */
+int ble_bas_service_init(void);
+
+/**
+ * @brief Update the cached battery values
+ *
+ * Battery Level is notified to subscribers only when it changed by at
+ * least CONFIG_APP_BAS_NOTIFY_STEP percent since the last notification.
+ *
+ * @param voltage_mv Battery voltage in millivolts
+ * @param percentage Battery percentage (0-100)
+ */
+void bas_update_battery(uint16_t voltage_mv, uint8_t percentage);
+
+#endif /* BLE_BAS_SERVICE_H */
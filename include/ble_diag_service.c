@@ -0,0 +1,521 @@
+#include "ble_diag_service.h"
+#include "diagnostics.h"
+#include "trace.h"
+#include "ble_metrics.h"
+#include "adaptive_sched.h"
+#include "record_log.h"
+#include "workqueues.h"
+#include <zephyr/bluetooth/att.h>
+#include <zephyr/bluetooth/conn.h>
+#include <zephyr/bluetooth/bluetooth.h>
+#include <zephyr/bluetooth/gatt.h>
+#include <zephyr/bluetooth/uuid.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/logging/log.h>
+
+LOG_MODULE_REGISTER(ble_diag, CONFIG_APP_BLE_DIAG_LOG_LEVEL);
+
+/* Custom Diagnostics Service UUID */
+#define DIAG_SERVICE_UUID_VAL 0xFFD0
+#define DIAG_ENERGY_UUID_VAL 0xFFD1
+#define DIAG_TRACE_UUID_VAL 0xFFD2
+#define DIAG_BLE_UUID_VAL 0xFFD3
+#define DIAG_SCHED_UUID_VAL 0xFFD4
+#define DIAG_MEMORY_UUID_VAL 0xFFD5
+#define DIAG_RECORDS_UUID_VAL 0xFFD6
+
+#define BT_UUID_DIAG_SERVICE  BT_UUID_DECLARE_16(DIAG_SERVICE_UUID_VAL)
+#define BT_UUID_DIAG_ENERGY   BT_UUID_DECLARE_16(DIAG_ENERGY_UUID_VAL)
+#define BT_UUID_DIAG_TRACE    BT_UUID_DECLARE_16(DIAG_TRACE_UUID_VAL)
+#define BT_UUID_DIAG_BLE      BT_UUID_DECLARE_16(DIAG_BLE_UUID_VAL)
+#define BT_UUID_DIAG_SCHED    BT_UUID_DECLARE_16(DIAG_SCHED_UUID_VAL)
+#define BT_UUID_DIAG_MEMORY   BT_UUID_DECLARE_16(DIAG_MEMORY_UUID_VAL)
+#define BT_UUID_DIAG_RECORDS  BT_UUID_DECLARE_16(DIAG_RECORDS_UUID_VAL)
+
+/*
+ * Energy record (little endian):
+ * version u8, uptime_s u32, adv_events u32, conn_events u32,
+ * display_refreshes u32, display_busy_ms u32, adc_conversions u32,
+ * cpu_active_permille u16, avg_current_na u32, min_stack_unused u16
+ */
+#define DIAG_ENERGY_VERSION 1
+#define DIAG_ENERGY_LEN 33
+#define DIAG_MAX_THREADS 16
+
+/*
+ * BLE metrics record (little endian):
+ * version u8, adv_to_conn_ms u32, conn_to_first_op_ms u32, connections u32,
+ * connected_ms u32, notifications u32, notify_bytes u32, then per
+ * enum ble_metric_op: count u32, avg_us u32, max_us u32, bytes u32
+ */
+#define DIAG_BLE_VERSION 1
+#define DIAG_BLE_LEN (1 + 6 * 4 + BLE_METRIC_OP_COUNT * 4 * 4)
+
+/*
+ * Scheduler record (little endian):
+ * version u8, activity_permille u16, then per enum sched_output:
+ * interval_ms u32, runs u32, skipped u32
+ */
+#define DIAG_SCHED_VERSION 1
+#define DIAG_SCHED_LEN (1 + 2 + SCHED_OUT_COUNT * 3 * 4)
+
+/*
+ * Memory record (little endian):
+ * version u8, heap_size u32, heap_used u32, heap_max_used u32,
+ * stack_size u32, stack_unused u32, buffer_bytes u32, thread_count u8,
+ * then per thread: stack_size u16, stack_unused u16
+ */
+#define DIAG_MEMORY_VERSION 1
+#define DIAG_MEMORY_LEN (1 + 6 * 4 + 1 + DIAG_MAX_THREADS * 2 * 2)
+
+#define DIAG_RECORD_LEN \
+	MAX(MAX(DIAG_ENERGY_LEN, DIAG_BLE_LEN), MAX(DIAG_SCHED_LEN, DIAG_MEMORY_LEN))
+
+enum diag_record {
+	DIAG_RECORD_NONE = 0,
+	DIAG_RECORD_ENERGY,
+	DIAG_RECORD_BLE,
+	DIAG_RECORD_SCHED,
+	DIAG_RECORD_MEMORY,
+};
+
+/*
+ * One snapshot shared by all records, taken at offset 0 so long reads
+ * stay consistent. ATT requests are handled one at a time, a long read
+ * of another record in between takes a new snapshot.
+ */
+static uint8_t record[DIAG_RECORD_LEN];
+static size_t record_len;
+static enum diag_record record_id;
+
+static size_t encode_energy(uint8_t *p)
+{
+	struct diag_energy energy;
+	struct diag_stack stacks[DIAG_MAX_THREADS];
+	uint64_t total_cycles;
+	uint16_t active_permille = 0;
+	size_t min_unused = UINT16_MAX;
+	size_t count;
+
+	diag_get_energy(&energy);
+
+	total_cycles = energy.cpu_active_cycles + energy.cpu_idle_cycles;
+	if (total_cycles > 0) {
+		active_permille = (uint16_t)(energy.cpu_active_cycles * 1000 / total_cycles);
+	}
+
+	count = diag_get_stacks(stacks, ARRAY_SIZE(stacks));
+	for (size_t i = 0; i < count; i++) {
+		min_unused = MIN(min_unused, stacks[i].unused);
+	}
+
+	*p++ = DIAG_ENERGY_VERSION;
+	sys_put_le32(energy.uptime_s, p);
+	p += 4;
+	sys_put_le32(energy.adv_events, p);
+	p += 4;
+	sys_put_le32(energy.conn_events, p);
+	p += 4;
+	sys_put_le32(energy.display_refreshes, p);
+	p += 4;
+	sys_put_le32(energy.display_busy_ms, p);
+	p += 4;
+	sys_put_le32(energy.adc_conversions, p);
+	p += 4;
+	sys_put_le16(active_permille, p);
+	p += 2;
+	sys_put_le32(energy.avg_current_na, p);
+	p += 4;
+	sys_put_le16((uint16_t)min_unused, p);
+
+	return DIAG_ENERGY_LEN;
+}
+
+static uint8_t *put_le32(uint8_t *p, uint32_t val)
+{
+	sys_put_le32(val, p);
+	return p + 4;
+}
+
+static size_t encode_ble(uint8_t *p)
+{
+	struct ble_metrics m;
+
+	ble_metrics_get(&m);
+
+	*p++ = DIAG_BLE_VERSION;
+	p = put_le32(p, m.adv_to_conn_ms);
+	p = put_le32(p, m.conn_to_first_op_ms);
+	p = put_le32(p, m.connections);
+	p = put_le32(p, m.connected_ms);
+	p = put_le32(p, m.notifications);
+	p = put_le32(p, m.notify_bytes);
+
+	for (int i = 0; i < BLE_METRIC_OP_COUNT; i++) {
+		const struct ble_metric_stat *stat = &m.ops[i];
+
+		p = put_le32(p, stat->count);
+		p = put_le32(p, stat->count ? stat->total_us / stat->count : 0);
+		p = put_le32(p, stat->max_us);
+		p = put_le32(p, stat->bytes);
+	}
+
+	return DIAG_BLE_LEN;
+}
+
+static size_t encode_sched(uint8_t *p)
+{
+	struct sched_state st;
+
+	adaptive_sched_get(&st);
+
+	*p++ = DIAG_SCHED_VERSION;
+	sys_put_le16(st.activity_permille, p);
+	p += 2;
+
+	for (int i = 0; i < SCHED_OUT_COUNT; i++) {
+		p = put_le32(p, st.interval_ms[i]);
+		p = put_le32(p, st.runs[i]);
+		p = put_le32(p, st.skipped[i]);
+	}
+
+	return DIAG_SCHED_LEN;
+}
+
+static size_t encode_memory(uint8_t *p)
+{
+	struct diag_memory mem;
+	struct diag_stack stacks[DIAG_MAX_THREADS];
+	size_t count;
+	uint8_t *start = p;
+
+	diag_get_memory(&mem);
+	count = diag_get_stacks(stacks, ARRAY_SIZE(stacks));
+
+	*p++ = DIAG_MEMORY_VERSION;
+	p = put_le32(p, mem.heap_size);
+	p = put_le32(p, mem.heap_used);
+	p = put_le32(p, mem.heap_max_used);
+	p = put_le32(p, mem.stack_size);
+	p = put_le32(p, mem.stack_unused);
+	p = put_le32(p, mem.buffer_bytes);
+	*p++ = (uint8_t)count;
+
+	for (size_t i = 0; i < count; i++) {
+		sys_put_le16((uint16_t)stacks[i].size, p);
+		p += 2;
+		sys_put_le16((uint16_t)stacks[i].unused, p);
+		p += 2;
+	}
+
+	return p - start;
+}
+
+static ssize_t read_record(struct bt_conn *conn, const struct bt_gatt_attr *attr,
+			   void *buf, uint16_t len, uint16_t offset,
+			   enum diag_record id, size_t (*encode)(uint8_t *p))
+{
+	if (offset == 0 || record_id != id) {
+		record_len = encode(record);
+		record_id = id;
+	}
+
+	return bt_gatt_attr_read(conn, attr, buf, len, offset, record, record_len);
+}
+
+/* Memory Characteristic Read Callback */
+static ssize_t read_memory(struct bt_conn *conn,
+			   const struct bt_gatt_attr *attr,
+			   void *buf, uint16_t len, uint16_t offset)
+{
+	return read_record(conn, attr, buf, len, offset, DIAG_RECORD_MEMORY, encode_memory);
+}
+
+/* Scheduler Characteristic Read Callback */
+static ssize_t read_sched(struct bt_conn *conn,
+			  const struct bt_gatt_attr *attr,
+			  void *buf, uint16_t len, uint16_t offset)
+{
+	return read_record(conn, attr, buf, len, offset, DIAG_RECORD_SCHED, encode_sched);
+}
+
+/* BLE Metrics Characteristic Read Callback */
+static ssize_t read_ble(struct bt_conn *conn,
+			const struct bt_gatt_attr *attr,
+			void *buf, uint16_t len, uint16_t offset)
+{
+	return read_record(conn, attr, buf, len, offset, DIAG_RECORD_BLE, encode_ble);
+}
+
+/* Energy Characteristic Read Callback */
+static ssize_t read_energy(struct bt_conn *conn,
+			   const struct bt_gatt_attr *attr,
+			   void *buf, uint16_t len, uint16_t offset)
+{
+	return read_record(conn, attr, buf, len, offset, DIAG_RECORD_ENERGY, encode_energy);
+}
+
+#if defined(CONFIG_APP_TRACE) || defined(CONFIG_APP_RECORD_LOG)
+/*
+ * Bulk exports are larger than an attribute value may be, and centrals
+ * stop long reads at BT_ATT_MAX_ATTRIBUTE_LEN. They are read in pages:
+ * writing a u32 byte offset selects a page, a read returns up to
+ * DIAG_PAGE_SIZE bytes from there (long reads work within the page). A
+ * page shorter than DIAG_PAGE_SIZE, or an empty one, ends the export.
+ *
+ * Offset 0, or a plain read, holds the source still. It is released
+ * once the last byte has been read, when no page was accessed for
+ * DIAG_EXPORT_TIMEOUT_S, or when the central disconnects.
+ */
+#define DIAG_PAGE_SIZE 512
+#define DIAG_EXPORT_TIMEOUT_S 10
+
+BUILD_ASSERT(DIAG_PAGE_SIZE <= BT_ATT_MAX_ATTRIBUTE_LEN,
+	     "Export page must fit an attribute value");
+
+struct diag_export {
+	size_t (*size)(void);
+	size_t (*copy)(size_t offset, uint8_t *buf, size_t len);
+	void (*hold)(bool hold);
+	struct k_work_delayable timeout;
+	struct wq_stamp timeout_stamp;
+	uint32_t page;  /* Byte offset of the selected page */
+	bool active;    /* Source held for the export */
+};
+
+static K_MUTEX_DEFINE(export_lock);
+
+/* Caller holds export_lock */
+static void export_touch(struct diag_export *ex)
+{
+	wq_reschedule(WQ_SENSING, &ex->timeout, &ex->timeout_stamp,
+		      K_SECONDS(DIAG_EXPORT_TIMEOUT_S));
+}
+
+/* Caller holds export_lock */
+static void export_begin(struct diag_export *ex)
+{
+	ex->hold(true);
+	ex->active = true;
+	ex->page = 0;
+	export_touch(ex);
+}
+
+/* Caller holds export_lock */
+static void export_end(struct diag_export *ex)
+{
+	if (ex->active) {
+		ex->hold(false);
+		ex->active = false;
+	}
+	ex->page = 0;
+	k_work_cancel_delayable(&ex->timeout);
+}
+
+static void export_timeout(struct k_work *work)
+{
+	struct k_work_delayable *dwork = k_work_delayable_from_work(work);
+	struct diag_export *ex = CONTAINER_OF(dwork, struct diag_export, timeout);
+
+	wq_started(WQ_SENSING, &ex->timeout_stamp);
+
+	k_mutex_lock(&export_lock, K_FOREVER);
+
+	if (ex->active) {
+		LOG_WRN("Export abandoned, released after %d s", DIAG_EXPORT_TIMEOUT_S);
+	}
+	export_end(ex);
+
+	k_mutex_unlock(&export_lock);
+}
+
+static ssize_t export_read(struct diag_export *ex, void *buf, uint16_t len, uint16_t offset)
+{
+	size_t written = 0;
+
+	if (offset > DIAG_PAGE_SIZE) {
+		return BT_GATT_ERR(BT_ATT_ERR_INVALID_OFFSET);
+	}
+
+	k_mutex_lock(&export_lock, K_FOREVER);
+
+	/* A plain read starts an export with its first page */
+	if (!ex->active && ex->page == 0 && offset == 0) {
+		export_begin(ex);
+	}
+
+	/* Pages past the end, or selected after it, read empty */
+	if (ex->active) {
+		size_t pos = ex->page + offset;
+
+		written = ex->copy(pos, buf, MIN(len, DIAG_PAGE_SIZE - offset));
+		if (pos + written >= ex->size()) {
+			export_end(ex);
+		} else {
+			export_touch(ex);
+		}
+	}
+
+	k_mutex_unlock(&export_lock);
+
+	return written;
+}
+
+static ssize_t export_write(struct diag_export *ex, const void *buf, uint16_t len,
+			    uint16_t offset)
+{
+	uint32_t page;
+
+	if (offset != 0 || len != sizeof(page)) {
+		return BT_GATT_ERR(BT_ATT_ERR_INVALID_ATTRIBUTE_LEN);
+	}
+
+	page = sys_get_le32(buf);
+
+	k_mutex_lock(&export_lock, K_FOREVER);
+
+	if (page == 0) {
+		/* Start over with a fresh window */
+		export_end(ex);
+		export_begin(ex);
+	} else {
+		ex->page = page;
+		if (ex->active) {
+			export_touch(ex);
+		}
+	}
+
+	k_mutex_unlock(&export_lock);
+
+	return len;
+}
+
+#endif /* CONFIG_APP_TRACE || CONFIG_APP_RECORD_LOG */
+
+#if defined(CONFIG_APP_RECORD_LOG)
+static struct diag_export records_export = {
+	.size = record_log_size,
+	.copy = record_log_export,
+	.hold = record_log_set_frozen,
+};
+
+/* Records Characteristic Read Callback - one page of the sensor records */
+static ssize_t read_records(struct bt_conn *conn,
+			    const struct bt_gatt_attr *attr,
+			    void *buf, uint16_t len, uint16_t offset)
+{
+	return export_read(&records_export, buf, len, offset);
+}
+
+/* Records Characteristic Write Callback - select the page to read */
+static ssize_t write_records(struct bt_conn *conn,
+			     const struct bt_gatt_attr *attr,
+			     const void *buf, uint16_t len, uint16_t offset,
+			     uint8_t flags)
+{
+	return export_write(&records_export, buf, len, offset);
+}
+#endif /* CONFIG_APP_RECORD_LOG */
+
+#if defined(CONFIG_APP_TRACE)
+static struct diag_export trace_export = {
+	.size = trace_ctf_size,
+	.copy = trace_ctf_export,
+	.hold = trace_set_paused,
+};
+
+/* Trace Characteristic Read Callback - one page of the CTF event stream */
+static ssize_t read_trace(struct bt_conn *conn,
+			  const struct bt_gatt_attr *attr,
+			  void *buf, uint16_t len, uint16_t offset)
+{
+	return export_read(&trace_export, buf, len, offset);
+}
+
+/* Trace Characteristic Write Callback - select the page to read */
+static ssize_t write_trace(struct bt_conn *conn,
+			   const struct bt_gatt_attr *attr,
+			   const void *buf, uint16_t len, uint16_t offset,
+			   uint8_t flags)
+{
+	return export_write(&trace_export, buf, len, offset);
+}
+#endif /* CONFIG_APP_TRACE */
+
+#if defined(CONFIG_APP_TRACE) || defined(CONFIG_APP_RECORD_LOG)
+static void diag_disconnected(struct bt_conn *conn, uint8_t reason)
+{
+	k_mutex_lock(&export_lock, K_FOREVER);
+#if defined(CONFIG_APP_TRACE)
+	export_end(&trace_export);
+#endif
+#if defined(CONFIG_APP_RECORD_LOG)
+	export_end(&records_export);
+#endif
+	k_mutex_unlock(&export_lock);
+}
+
+BT_CONN_CB_DEFINE(diag_svc_conn_callbacks) = {
+	.disconnected = diag_disconnected,
+};
+#endif
+
+/* Diagnostics Service Declaration */
+BT_GATT_SERVICE_DEFINE(diag_svc,
+	BT_GATT_PRIMARY_SERVICE(BT_UUID_DIAG_SERVICE),
+
+	/* Energy Characteristic - energy and duty-cycle accounting */
+	BT_GATT_CHARACTERISTIC(BT_UUID_DIAG_ENERGY,
+			       BT_GATT_CHRC_READ,
+			       BT_GATT_PERM_READ,
+			       read_energy, NULL, NULL),
+
+	/* BLE Metrics Characteristic - connection and GATT timing */
+	BT_GATT_CHARACTERISTIC(BT_UUID_DIAG_BLE,
+			       BT_GATT_CHRC_READ,
+			       BT_GATT_PERM_READ,
+			       read_ble, NULL, NULL),
+
+	/* Scheduler Characteristic - adaptive interval decisions */
+	BT_GATT_CHARACTERISTIC(BT_UUID_DIAG_SCHED,
+			       BT_GATT_CHRC_READ,
+			       BT_GATT_PERM_READ,
+			       read_sched, NULL, NULL),
+
+	/* Memory Characteristic - heap, stack and static buffer usage */
+	BT_GATT_CHARACTERISTIC(BT_UUID_DIAG_MEMORY,
+			       BT_GATT_CHRC_READ,
+			       BT_GATT_PERM_READ,
+			       read_memory, NULL, NULL),
+
+#if defined(CONFIG_APP_TRACE)
+	/* Trace Characteristic - hot-path trace as a paged CTF stream */
+	BT_GATT_CHARACTERISTIC(BT_UUID_DIAG_TRACE,
+			       BT_GATT_CHRC_READ | BT_GATT_CHRC_WRITE,
+			       BT_GATT_PERM_READ | BT_GATT_PERM_WRITE,
+			       read_trace, write_trace, NULL),
+#endif
+
+#if defined(CONFIG_APP_RECORD_LOG)
+	/* Records Characteristic - sensor record log, paged bulk transfer */
+	BT_GATT_CHARACTERISTIC(BT_UUID_DIAG_RECORDS,
+			       BT_GATT_CHRC_READ | BT_GATT_CHRC_WRITE,
+			       BT_GATT_PERM_READ | BT_GATT_PERM_WRITE,
+			       read_records, write_records, NULL),
+#endif
+);
+
+int ble_diag_service_init(void)
+{
+	diag_register_buffer("diag.record", sizeof(record));
+
+#if defined(CONFIG_APP_TRACE)
+	k_work_init_delayable(&trace_export.timeout, export_timeout);
+#endif
+#if defined(CONFIG_APP_RECORD_LOG)
+	k_work_init_delayable(&records_export.timeout, export_timeout);
+#endif
+
+	LOG_INF("Diagnostics Service initialized");
+	return 0;
+}
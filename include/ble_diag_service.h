@@ -0,0 +1,13 @@
+#ifndef BLE_DIAG_SERVICE_H
+#define BLE_DIAG_SERVICE_H
+
+#include <zephyr/kernel.h>
+
+/**
+ * @brief Initialize the Diagnostics Service
+ *
+ * @return 0 on success, negative errno on failure
+ */
+int ble_diag_service_init(void);
+
+#endif /* BLE_DIAG_SERVICE_H */
@@ -1,13 +1,25 @@
 #include "ble_ess_service.h"
 #include "display_epaper.h"
 #include "battery.h"
+#include "ble_bas_service.h"
+#include "trace.h"
+#include "log_ratelimit.h"
+#include "ble_metrics.h"
+#include "advertising.h"
+#include "neighbours.h"
+#include "mesh_sensor.h"
+#include "boot.h"
+#include "adaptive_sched.h"
+#include "workqueues.h"
+#include "record_log.h"
+#include "sensor_emul.h"
 #include <zephyr/bluetooth/bluetooth.h>
 #include <zephyr/bluetooth/gatt.h>
 #include <zephyr/bluetooth/uuid.h>
 #include <zephyr/sys/byteorder.h>
 #include <zephyr/logging/log.h>
 
-LOG_MODULE_REGISTER(ble_ess, LOG_LEVEL_INF);
+LOG_MODULE_REGISTER(ble_ess, CONFIG_APP_BLE_ESS_LOG_LEVEL);
 
 /* Environmental Sensing Service UUID */
 #define ESS_UUID_VAL 0x181A
@@ -18,10 +30,30 @@ LOG_MODULE_REGISTER(ble_ess, LOG_LEVEL_INF);
 #define BT_UUID_TEMPERATURE   BT_UUID_DECLARE_16(TEMPERATURE_UUID_VAL)
 #define BT_UUID_HUMIDITY      BT_UUID_DECLARE_16(HUMIDITY_UUID_VAL)
 
+/* Minimum spacing of the per-read log messages */
+#define READ_LOG_INTERVAL_MS 5000
+
+/* Attribute indices of the characteristic values in ess_svc */
+#define ESS_ATTR_TEMPERATURE 2
+#define ESS_ATTR_HUMIDITY 5
+
 /* Sensor data (dummy values) */
 static int16_t temperature = 2250;  /* 22.50°C (value * 0.01) */
 static uint16_t humidity = 5500;     /* 55.00% (value * 0.01) */
 
+/* Readings of the last sample came from the sensor emulator */
+static bool emulated;
+
+/* Records until the first one carries SENSOR_RECORD_FLAG_BOOT */
+static bool recorded;
+
+static bool temperature_notify_enabled;
+static bool humidity_notify_enabled;
+
+/* Outputs due at the current sample, decided by the adaptive scheduler */
+static bool display_due;
+static bool adv_due;
+
 /* Update functions */
 void ess_update_temperature(int16_t temp_celsius)
 {
@@ -35,17 +67,46 @@ void ess_update_humidity(uint16_t humidity_percent)
 	LOG_DBG("Humidity updated: %d.%02d%%", humidity / 100, humidity % 100);
 }
 
+int16_t ess_get_temperature(void)
+{
+	return temperature;
+}
+
+uint16_t ess_get_humidity(void)
+{
+	return humidity;
+}
+
+static void temperature_ccc_changed(const struct bt_gatt_attr *attr, uint16_t value)
+{
+	temperature_notify_enabled = (value == BT_GATT_CCC_NOTIFY);
+}
+
+static void humidity_ccc_changed(const struct bt_gatt_attr *attr, uint16_t value)
+{
+	humidity_notify_enabled = (value == BT_GATT_CCC_NOTIFY);
+}
+
 /* Temperature Characteristic Read Callback */
 static ssize_t read_temperature(struct bt_conn *conn,
 				const struct bt_gatt_attr *attr,
 				void *buf, uint16_t len, uint16_t offset)
 {
 	int16_t temp_value = sys_cpu_to_le16(temperature);
+	ssize_t ret;
+	uint64_t start = ble_metrics_op_begin();
+
+	TRACE_BEGIN(TRACE_SPAN_GATT_READ, TEMPERATURE_UUID_VAL);
+
+	APP_LOG_INF_RATELIMIT(READ_LOG_INTERVAL_MS, "Temperature read: %d.%02d°C",
+			      temperature / 100, temperature % 100);
 
-	LOG_INF("Temperature read: %d.%02d°C", temperature / 100, temperature % 100);
+	ret = bt_gatt_attr_read(conn, attr, buf, len, offset,
+				&temp_value, sizeof(temp_value));
 
-	return bt_gatt_attr_read(conn, attr, buf, len, offset,
-				 &temp_value, sizeof(temp_value));
+	TRACE_END(TRACE_SPAN_GATT_READ, TEMPERATURE_UUID_VAL);
+	ble_metrics_op_end(BLE_METRIC_READ_TEMPERATURE, start, MAX(ret, 0));
+	return ret;
 }
 
 /* Humidity Characteristic Read Callback */
@@ -54,11 +115,20 @@ static ssize_t read_humidity(struct bt_conn *conn,
 			     void *buf, uint16_t len, uint16_t offset)
 {
 	uint16_t humidity_value = sys_cpu_to_le16(humidity);
+	ssize_t ret;
+	uint64_t start = ble_metrics_op_begin();
 
-	LOG_INF("Humidity read: %d.%02d%%", humidity / 100, humidity % 100);
+	TRACE_BEGIN(TRACE_SPAN_GATT_READ, HUMIDITY_UUID_VAL);
 
-	return bt_gatt_attr_read(conn, attr, buf, len, offset,
-				 &humidity_value, sizeof(humidity_value));
+	APP_LOG_INF_RATELIMIT(READ_LOG_INTERVAL_MS, "Humidity read: %d.%02d%%",
+			      humidity / 100, humidity % 100);
+
+	ret = bt_gatt_attr_read(conn, attr, buf, len, offset,
+				&humidity_value, sizeof(humidity_value));
+
+	TRACE_END(TRACE_SPAN_GATT_READ, HUMIDITY_UUID_VAL);
+	ble_metrics_op_end(BLE_METRIC_READ_HUMIDITY, start, MAX(ret, 0));
+	return ret;
 }
 
 /* Environmental Sensing Service Declaration */
@@ -70,52 +140,168 @@ BT_GATT_SERVICE_DEFINE(ess_svc,
 			       BT_GATT_CHRC_READ | BT_GATT_CHRC_NOTIFY,
 			       BT_GATT_PERM_READ,
 			       read_temperature, NULL, NULL),
-	BT_GATT_CCC(NULL, BT_GATT_PERM_READ | BT_GATT_PERM_WRITE),
+	BT_GATT_CCC(temperature_ccc_changed, BT_GATT_PERM_READ | BT_GATT_PERM_WRITE),
 
 	/* Humidity Characteristic */
 	BT_GATT_CHARACTERISTIC(BT_UUID_HUMIDITY,
 			       BT_GATT_CHRC_READ | BT_GATT_CHRC_NOTIFY,
 			       BT_GATT_PERM_READ,
 			       read_humidity, NULL, NULL),
-	BT_GATT_CCC(NULL, BT_GATT_PERM_READ | BT_GATT_PERM_WRITE),
+	BT_GATT_CCC(humidity_ccc_changed, BT_GATT_PERM_READ | BT_GATT_PERM_WRITE),
 );
 
-/* Auto-update timer and work */
+/* Auto-update work on the sensing queue, rendering on the display queue */
 static void update_sensor_data(struct k_work *work);
 static K_WORK_DELAYABLE_DEFINE(sensor_update_work, update_sensor_data);
+static struct wq_stamp sensor_update_stamp;
 
-static void update_sensor_data(struct k_work *work)
+static void render_readings(struct k_work *work);
+static K_WORK_DEFINE(render_work, render_readings);
+static struct wq_stamp render_stamp;
+static uint16_t render_voltage;
+
+/* Notify subscribed centrals of the new readings */
+static void notify_sensors(void)
 {
-	/* Generate dummy temperature: 20.00°C to 25.00°C */
-	static int16_t temp_offset = 0;
-	temperature = 2200 + (temp_offset % 500);
-	temp_offset += 50;
+	int16_t temp_value = sys_cpu_to_le16(temperature);
+	uint16_t humidity_value = sys_cpu_to_le16(humidity);
+
+	if (temperature_notify_enabled &&
+	    bt_gatt_notify(NULL, &ess_svc.attrs[ESS_ATTR_TEMPERATURE],
+			   &temp_value, sizeof(temp_value)) == 0) {
+		ble_metrics_notified(sizeof(temp_value));
+	}
 
-	/* Generate dummy humidity: 45.00% to 65.00% */
+	if (humidity_notify_enabled &&
+	    bt_gatt_notify(NULL, &ess_svc.attrs[ESS_ATTR_HUMIDITY],
+			   &humidity_value, sizeof(humidity_value)) == 0) {
+		ble_metrics_notified(sizeof(humidity_value));
+	}
+}
+
+/* Redraw the panel with the latest readings, may take seconds */
+static void render_readings(struct k_work *work)
+{
+	uint8_t battery_pct = battery_get_level();
+	struct neighbour neighbours[DISPLAY_NEIGHBOURS_MAX];
+	size_t count;
+
+	wq_started(WQ_DISPLAY, &render_stamp);
+
+	count = neighbours_get(neighbours, ARRAY_SIZE(neighbours));
+	if (count > 0) {
+		/* Multi-sensor view once neighbours are heard */
+		display_update_neighbours(temperature, humidity, battery_pct,
+					  neighbours, count);
+	} else {
+		/* Readings and battery level in a single refresh */
+		display_update_dashboard(temperature, humidity, render_voltage, battery_pct);
+	}
+}
+
+/* Battery measurement done - hand the new readings to their outputs */
+static void battery_measured(int err, uint16_t voltage)
+{
+	uint8_t battery_pct = battery_get_level();
+	struct sensor_record rec;
+
+	ess_record(voltage, err ? SENSOR_RECORD_FLAG_BATTERY_STALE : 0, &rec);
+
+	/* Until the display thread drew its first frame only BLE is updated */
+	if (display_due && boot_reached(BOOT_PHASE_DISPLAY_READY)) {
+		render_voltage = voltage;
+		wq_submit(WQ_DISPLAY, &render_work, &render_stamp);
+	}
+
+	/* Refresh cached Battery Service values */
+	bas_update_battery(voltage, battery_pct);
+
+	/* Share the readings with neighbouring nodes */
+	if (adv_due) {
+		advertising_set_record(&rec);
+	}
+}
+
+void ess_sample(void)
+{
+	static int16_t temp_offset = 0;
 	static int16_t hum_offset = 0;
-	humidity = 5000 + (hum_offset % 2000);
-	hum_offset += 200;
+
+	emulated = sensor_emul_next(&temperature, &humidity);
+	if (!emulated) {
+		/* Generate dummy temperature: 20.00°C to 25.00°C */
+		temperature = 2200 + (temp_offset % 500);
+		temp_offset += 50;
+
+		/* Generate dummy humidity: 45.00% to 65.00% */
+		humidity = 5000 + (hum_offset % 2000);
+		hum_offset += 200;
+	}
 
 	LOG_INF("Sensor updated - Temp: %d.%02d°C, Humidity: %d.%02d%%",
 		temperature / 100, temperature % 100,
 		humidity / 100, humidity % 100);
 
-	/* Update display */
-	display_update_sensors(temperature, humidity);
+	adaptive_sched_observe(temperature, humidity);
+
+	notify_sensors();
+	boot_mark(BOOT_PHASE_FIRST_READING);
+
+	/* Publish on change to the mesh, if enabled */
+	mesh_sensor_update();
+}
+
+void ess_record(uint16_t battery_mv, uint8_t flags, struct sensor_record *rec)
+{
+	rec->timestamp_s = (uint32_t)(k_uptime_get() / MSEC_PER_SEC);
+	rec->temperature = temperature;
+	rec->humidity = humidity;
+	rec->battery_mv = battery_mv;
+	rec->flags = flags;
+
+	if (!recorded) {
+		rec->flags |= SENSOR_RECORD_FLAG_BOOT;
+		recorded = true;
+	}
+	if (emulated) {
+		rec->flags |= SENSOR_RECORD_FLAG_EMULATED;
+	}
+
+	record_log_append(rec);
+}
+
+static void update_sensor_data(struct k_work *work)
+{
+	struct sensor_record rec;
+
+	wq_started(WQ_SENSING, &sensor_update_stamp);
+	TRACE_BEGIN(TRACE_SPAN_WORK, TRACE_WORK_SENSOR_UPDATE);
+
+	ess_sample();
+
+	/* Panel and broadcast follow the readings at their own pace */
+	display_due = adaptive_sched_due(SCHED_OUT_DISPLAY);
+	adv_due = adaptive_sched_due(SCHED_OUT_ADV);
+
+	/* Measure battery first so the divider window never overlaps the refresh */
+	if (!display_due && !adv_due) {
+		/* Recorded with the last battery reading, no measurement due */
+		ess_record(battery_get_voltage(), SENSOR_RECORD_FLAG_BATTERY_STALE, &rec);
+	} else if (battery_measure_async(battery_measured) != 0) {
+		battery_measured(-EBUSY, battery_get_voltage());
+	}
 
-	/* Update battery display */
-	uint16_t voltage = battery_read_voltage();
-	uint8_t battery_pct = battery_get_percentage(voltage);
-	display_update_battery(voltage, battery_pct);
+	/* Next sample as decided from the rate of change */
+	wq_schedule(WQ_SENSING, &sensor_update_work, &sensor_update_stamp,
+		    K_MSEC(adaptive_sched_interval_ms(SCHED_OUT_SAMPLE)));
 
-	/* Schedule next update in 10 seconds */
-	k_work_schedule(&sensor_update_work, K_SECONDS(10));
+	TRACE_END(TRACE_SPAN_WORK, TRACE_WORK_SENSOR_UPDATE);
 }
 
 void ess_start_auto_update(void)
 {
 	LOG_INF("Starting automatic sensor updates");
-	k_work_schedule(&sensor_update_work, K_SECONDS(10));
+	wq_schedule(WQ_SENSING, &sensor_update_work, &sensor_update_stamp, K_NO_WAIT);
 }
 
 int ble_ess_service_init(void)
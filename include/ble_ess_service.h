@@ -2,6 +2,7 @@
 #define BLE_ESS_SERVICE_H
 
 #include <zephyr/kernel.h>
+#include "sensor_record.h"
 
 /**
  * @brief Initialize the Environmental Sensing Service
@@ -24,10 +25,48 @@ void ess_update_temperature(int16_t temp_celsius);
  */
 void ess_update_humidity(uint16_t humidity_percent);
 
+/**
+ * @brief Get the current temperature
+ *
+ * @return Temperature in Celsius * 100
+ */
+int16_t ess_get_temperature(void);
+
+/**
+ * @brief Get the current humidity
+ *
+ * @return Humidity in percent * 100
+ */
+uint16_t ess_get_humidity(void);
+
+/**
+ * @brief Take one sensor sample (dummy data)
+ *
+ * Updates the values, notifies subscribed centrals and feeds the
+ * adaptive scheduler and the mesh. Panel and advertising are left to
+ * the caller. With CONFIG_APP_SENSOR_EMUL the values come from the
+ * replayed trace instead.
+ */
+void ess_sample(void);
+
+/**
+ * @brief Record the latest sample
+ *
+ * Packs the current values and the battery voltage into a sensor record
+ * and stores it in the record log.
+ *
+ * @param battery_mv Battery voltage (mV)
+ * @param flags enum sensor_record_flag to set on this record
+ * @param rec Record to fill, e.g. for the broadcast
+ */
+void ess_record(uint16_t battery_mv, uint8_t flags, struct sensor_record *rec);
+
 /**
  * @brief Start automatic sensor data updates (dummy data)
  *
- * This will update the sensor values every 10 seconds with dummy data
+ * Updates the sensor values right away and then at the interval chosen
+ * by the adaptive scheduler, with dummy data. The panel is only redrawn
+ * once the display is ready.
  */
 void ess_start_auto_update(void);
 
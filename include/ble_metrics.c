@@ -0,0 +1,179 @@
+#include "ble_metrics.h"
+#include <zephyr/bluetooth/bluetooth.h>
+#include <zephyr/bluetooth/conn.h>
+#include <zephyr/timing/timing.h>
+#include <zephyr/logging/log.h>
+#if defined(CONFIG_SHELL)
+#include <zephyr/shell/shell.h>
+#endif
+
+LOG_MODULE_REGISTER(ble_metrics, CONFIG_APP_BLE_METRICS_LOG_LEVEL);
+
+static struct k_spinlock metrics_lock;
+static struct ble_metrics metrics;
+static int64_t adv_start_ms;
+static int64_t conn_start_ms;
+static bool first_op_pending;
+
+static void metrics_connected(struct bt_conn *conn, uint8_t err)
+{
+	if (err) {
+		return;
+	}
+
+	k_spinlock_key_t key = k_spin_lock(&metrics_lock);
+
+	conn_start_ms = k_uptime_get();
+	metrics.connections++;
+	metrics.adv_to_conn_ms = (uint32_t)(conn_start_ms - adv_start_ms);
+	first_op_pending = true;
+
+	k_spin_unlock(&metrics_lock, key);
+}
+
+static void metrics_disconnected(struct bt_conn *conn, uint8_t reason)
+{
+	k_spinlock_key_t key = k_spin_lock(&metrics_lock);
+	int64_t now = k_uptime_get();
+
+	metrics.connected_ms += (uint32_t)(now - conn_start_ms);
+	conn_start_ms = 0;
+
+	/* Connectable advertising resumes right after the disconnect */
+	adv_start_ms = now;
+
+	k_spin_unlock(&metrics_lock, key);
+}
+
+BT_CONN_CB_DEFINE(metrics_conn_callbacks) = {
+	.connected = metrics_connected,
+	.disconnected = metrics_disconnected,
+};
+
+void ble_metrics_adv_started(void)
+{
+	k_spinlock_key_t key = k_spin_lock(&metrics_lock);
+
+	adv_start_ms = k_uptime_get();
+
+	k_spin_unlock(&metrics_lock, key);
+}
+
+uint64_t ble_metrics_op_begin(void)
+{
+	return timing_counter_get();
+}
+
+void ble_metrics_op_end(enum ble_metric_op op, uint64_t start, uint16_t bytes)
+{
+	timing_t begin = start;
+	timing_t end = timing_counter_get();
+	uint32_t us = (uint32_t)(timing_cycles_to_ns(timing_cycles_get(&begin, &end)) / 1000);
+
+	k_spinlock_key_t key = k_spin_lock(&metrics_lock);
+	struct ble_metric_stat *stat = &metrics.ops[op];
+
+	stat->count++;
+	stat->total_us += us;
+	stat->max_us = MAX(stat->max_us, us);
+	stat->bytes += bytes;
+
+	if (first_op_pending && conn_start_ms != 0) {
+		metrics.conn_to_first_op_ms = (uint32_t)(k_uptime_get() - conn_start_ms);
+		first_op_pending = false;
+	}
+
+	k_spin_unlock(&metrics_lock, key);
+}
+
+void ble_metrics_notified(uint16_t bytes)
+{
+	k_spinlock_key_t key = k_spin_lock(&metrics_lock);
+
+	metrics.notifications++;
+	metrics.notify_bytes += bytes;
+
+	k_spin_unlock(&metrics_lock, key);
+}
+
+void ble_metrics_get(struct ble_metrics *out)
+{
+	k_spinlock_key_t key = k_spin_lock(&metrics_lock);
+
+	*out = metrics;
+
+	/* Include the running connection */
+	if (conn_start_ms != 0) {
+		out->connected_ms += (uint32_t)(k_uptime_get() - conn_start_ms);
+	}
+
+	k_spin_unlock(&metrics_lock, key);
+}
+
+#if defined(CONFIG_SHELL)
+static const char *const op_names[BLE_METRIC_OP_COUNT] = {
+	[BLE_METRIC_READ_TEMPERATURE] = "read_temperature",
+	[BLE_METRIC_READ_HUMIDITY] = "read_humidity",
+	[BLE_METRIC_WRITE_RGB] = "write_rgb",
+	[BLE_METRIC_WRITE_TEXT] = "write_text",
+	[BLE_METRIC_WRITE_IMAGE] = "write_image",
+};
+
+/*
+ * One JSON object per line so host tooling can diff runs. Everything is
+ * seen from the device: the *_service_us fields time the GATT callbacks,
+ * not the round trip a central sees.
+ * The averages over connected time are not link throughput, idle time
+ * of the connection counts too.
+ */
+static int cmd_diag_ble(const struct shell *sh, size_t argc, char **argv)
+{
+	struct ble_metrics m;
+	uint32_t bytes = 0;
+
+	ble_metrics_get(&m);
+
+	for (int i = 0; i < BLE_METRIC_OP_COUNT; i++) {
+		bytes += m.ops[i].bytes;
+	}
+	bytes += m.notify_bytes;
+
+	shell_fprintf(sh, SHELL_NORMAL,
+		      "{\"adv_to_conn_ms\":%u,\"conn_to_first_op_ms\":%u,"
+		      "\"connections\":%u,\"connected_ms\":%u,"
+		      "\"notifications\":%u,\"notify_per_connected_ks\":%u,"
+		      "\"payload_bps_per_connected_s\":%u",
+		      m.adv_to_conn_ms, m.conn_to_first_op_ms, m.connections,
+		      m.connected_ms, m.notifications,
+		      m.connected_ms ? (uint32_t)((uint64_t)m.notifications * 1000000 /
+						  m.connected_ms) : 0,
+		      m.connected_ms ? (uint32_t)((uint64_t)bytes * 8000 / m.connected_ms) : 0);
+
+	for (int i = 0; i < BLE_METRIC_OP_COUNT; i++) {
+		const struct ble_metric_stat *stat = &m.ops[i];
+
+		shell_fprintf(sh, SHELL_NORMAL,
+			      ",\"%s\":{\"count\":%u,\"avg_service_us\":%u,"
+			      "\"max_service_us\":%u,\"bytes\":%u}",
+			      op_names[i], stat->count,
+			      stat->count ? stat->total_us / stat->count : 0,
+			      stat->max_us, stat->bytes);
+	}
+
+	shell_fprintf(sh, SHELL_NORMAL, "}\n");
+
+	return 0;
+}
+
+SHELL_SUBCMD_ADD((diag), ble, NULL, "BLE performance metrics (JSON)",
+		 cmd_diag_ble, 1, 0);
+#endif /* CONFIG_SHELL */
+
+int ble_metrics_init(void)
+{
+	timing_init();
+	timing_start();
+
+	LOG_INF("BLE metrics collection started");
+	return 0;
+}
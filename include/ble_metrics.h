@@ -0,0 +1,83 @@
+#ifndef BLE_METRICS_H
+#define BLE_METRICS_H
+
+#include <zephyr/kernel.h>
+
+/**
+ * @brief GATT operations with timing statistics
+ */
+enum ble_metric_op {
+	BLE_METRIC_READ_TEMPERATURE = 0,
+	BLE_METRIC_READ_HUMIDITY,
+	BLE_METRIC_WRITE_RGB,
+	BLE_METRIC_WRITE_TEXT,
+	BLE_METRIC_WRITE_IMAGE,
+	BLE_METRIC_OP_COUNT,
+};
+
+/**
+ * @brief Service time statistics of one GATT operation
+ */
+struct ble_metric_stat {
+	uint32_t count;     /* Completed operations */
+	uint32_t total_us;  /* Sum of callback service times */
+	uint32_t max_us;    /* Worst callback service time */
+	uint32_t bytes;     /* Payload bytes transferred */
+};
+
+/**
+ * @brief BLE performance metrics snapshot
+ */
+struct ble_metrics {
+	uint32_t adv_to_conn_ms;       /* Last advertising start to connection */
+	uint32_t conn_to_first_op_ms;  /* Last connection to first GATT operation */
+	uint32_t connections;          /* Connections since boot */
+	uint32_t connected_ms;         /* Total time connected */
+	uint32_t notifications;        /* Notifications sent */
+	uint32_t notify_bytes;         /* Notification payload bytes */
+	struct ble_metric_stat ops[BLE_METRIC_OP_COUNT];
+};
+
+/**
+ * @brief Initialize BLE metrics collection
+ *
+ * @return 0 on success, negative errno on failure
+ */
+int ble_metrics_init(void);
+
+/**
+ * @brief Record that advertising (re)started
+ */
+void ble_metrics_adv_started(void);
+
+/**
+ * @brief Start timing a GATT operation
+ *
+ * @return Opaque start timestamp for ble_metrics_op_end()
+ */
+uint64_t ble_metrics_op_begin(void);
+
+/**
+ * @brief Finish timing a GATT operation
+ *
+ * @param op Operation
+ * @param start Value returned by ble_metrics_op_begin()
+ * @param bytes Payload bytes transferred
+ */
+void ble_metrics_op_end(enum ble_metric_op op, uint64_t start, uint16_t bytes);
+
+/**
+ * @brief Record a sent notification
+ *
+ * @param bytes Notification payload size
+ */
+void ble_metrics_notified(uint16_t bytes);
+
+/**
+ * @brief Take a metrics snapshot
+ *
+ * @param out Snapshot to fill
+ */
+void ble_metrics_get(struct ble_metrics *out);
+
+#endif /* BLE_METRICS_H */
@@ -1,51 +1,47 @@
 #include "ble_rgb_service.h"
-#include "display_epaper.h"
+#include "trace.h"
+#include "ble_metrics.h"
+#include "led_effects.h"
+#include "image_upload.h"
+#include "text_pages.h"
 #include <zephyr/bluetooth/bluetooth.h>
 #include <zephyr/bluetooth/gatt.h>
 #include <zephyr/bluetooth/uuid.h>
-#include <zephyr/drivers/pwm.h>
+#include <zephyr/sys/byteorder.h>
 #include <zephyr/logging/log.h>
+#if defined(CONFIG_SHELL)
+#include <zephyr/shell/shell.h>
+#endif
 
-LOG_MODULE_REGISTER(ble_rgb, LOG_LEVEL_INF);
+LOG_MODULE_REGISTER(ble_rgb, CONFIG_APP_BLE_RGB_LOG_LEVEL);
 
 /* Custom RGB LED Service UUID */
 #define RGB_SERVICE_UUID_VAL 0xFFE0
 #define RGB_CHAR_UUID_VAL 0xFFE1
 #define TEXT_CHAR_UUID_VAL 0xFFE2
+#define PATTERN_CHAR_UUID_VAL 0xFFE3
+#define IMAGE_CHAR_UUID_VAL 0xFFE4
+#define TEXT_PAGE_CHAR_UUID_VAL 0xFFE5
 
 #define BT_UUID_RGB_SERVICE   BT_UUID_DECLARE_16(RGB_SERVICE_UUID_VAL)
 #define BT_UUID_RGB_CHAR      BT_UUID_DECLARE_16(RGB_CHAR_UUID_VAL)
 #define BT_UUID_TEXT_CHAR     BT_UUID_DECLARE_16(TEXT_CHAR_UUID_VAL)
+#define BT_UUID_PATTERN_CHAR  BT_UUID_DECLARE_16(PATTERN_CHAR_UUID_VAL)
+#define BT_UUID_IMAGE_CHAR    BT_UUID_DECLARE_16(IMAGE_CHAR_UUID_VAL)
+#define BT_UUID_TEXT_PAGE_CHAR BT_UUID_DECLARE_16(TEXT_PAGE_CHAR_UUID_VAL)
 
 /* RGB LED data */
 static uint8_t rgb_values[3] = {0, 0, 0}; /* R, G, B */
 
-/* Text buffer for display */
-#define TEXT_BUFFER_SIZE 128
-static char text_buffer[TEXT_BUFFER_SIZE];
-
-/* PWM devices */
-#if DT_NODE_EXISTS(DT_NODELABEL(red_pwm_led))
-static const struct pwm_dt_spec pwm_led_red = PWM_DT_SPEC_GET(DT_NODELABEL(red_pwm_led));
-static const struct pwm_dt_spec pwm_led_green = PWM_DT_SPEC_GET(DT_NODELABEL(green_pwm_led));
-static const struct pwm_dt_spec pwm_led_blue = PWM_DT_SPEC_GET(DT_NODELABEL(blue_pwm_led));
-#else
-#error "PWM LED nodes not found in device tree"
-#endif
-
 /* Set RGB LED color */
 void rgb_led_set_color(uint8_t red, uint8_t green, uint8_t blue)
 {
-	uint32_t pulse_red, pulse_green, pulse_blue;
+	struct led_pattern pattern = {
+		.type = LED_PATTERN_STATIC,
+		.from = {red, green, blue},
+	};
 
-	/* Convert 0-255 to PWM pulse width (0-100% of period) */
-	pulse_red = (pwm_led_red.period * red) / 255;
-	pulse_green = (pwm_led_green.period * green) / 255;
-	pulse_blue = (pwm_led_blue.period * blue) / 255;
-
-	pwm_set_pulse_dt(&pwm_led_red, pulse_red);
-	pwm_set_pulse_dt(&pwm_led_green, pulse_green);
-	pwm_set_pulse_dt(&pwm_led_blue, pulse_blue);
+	led_effects_play(&pattern);
 
 	LOG_INF("RGB LED: R=%d, G=%d, B=%d", red, green, blue);
 }
@@ -60,12 +56,31 @@ static ssize_t write_rgb(struct bt_conn *conn,
 		return BT_GATT_ERR(BT_ATT_ERR_INVALID_OFFSET);
 	}
 
+	uint64_t start = ble_metrics_op_begin();
+
+	/* Write without response: colour stream, latest value wins */
+	if (flags & BT_GATT_WRITE_FLAG_CMD) {
+		if (offset != 0 || len != sizeof(rgb_values)) {
+			return BT_GATT_ERR(BT_ATT_ERR_INVALID_ATTRIBUTE_LEN);
+		}
+
+		/* Latched by the LED engine at the next PWM period */
+		memcpy(rgb_values, buf, sizeof(rgb_values));
+		led_effects_stream(buf);
+		ble_metrics_op_end(BLE_METRIC_WRITE_RGB, start, len);
+		return len;
+	}
+
+	TRACE_BEGIN(TRACE_SPAN_GATT_WRITE, RGB_CHAR_UUID_VAL);
+
 	memcpy(rgb_values + offset, buf, len);
 
 	if (len >= 3) {
 		rgb_led_set_color(rgb_values[0], rgb_values[1], rgb_values[2]);
 	}
 
+	TRACE_END(TRACE_SPAN_GATT_WRITE, RGB_CHAR_UUID_VAL);
+	ble_metrics_op_end(BLE_METRIC_WRITE_RGB, start, len);
 	return len;
 }
 
@@ -78,24 +93,138 @@ static ssize_t read_rgb(struct bt_conn *conn,
 				 rgb_values, sizeof(rgb_values));
 }
 
+/* LED Pattern Characteristic Write Callback */
+static ssize_t write_pattern(struct bt_conn *conn,
+			     const struct bt_gatt_attr *attr,
+			     const void *buf, uint16_t len, uint16_t offset,
+			     uint8_t flags)
+{
+	struct led_pattern pattern;
+
+	if (offset != 0) {
+		return BT_GATT_ERR(BT_ATT_ERR_INVALID_OFFSET);
+	}
+
+	if (led_pattern_decode(buf, len, &pattern) != 0) {
+		return BT_GATT_ERR(BT_ATT_ERR_VALUE_NOT_ALLOWED);
+	}
+
+	TRACE_BEGIN(TRACE_SPAN_GATT_WRITE, PATTERN_CHAR_UUID_VAL);
+
+	led_effects_play(&pattern);
+
+	TRACE_END(TRACE_SPAN_GATT_WRITE, PATTERN_CHAR_UUID_VAL);
+
+	LOG_INF("LED pattern %u, period %u ms, repeat %u",
+		pattern.type, pattern.period_ms, pattern.repeat);
+
+	return len;
+}
+
+/* Image Characteristic Write Callback */
+static ssize_t write_image(struct bt_conn *conn,
+			   const struct bt_gatt_attr *attr,
+			   const void *buf, uint16_t len, uint16_t offset,
+			   uint8_t flags)
+{
+	const uint8_t *data = buf;
+	int ret;
+
+	if (offset != 0 || len < 1) {
+		return BT_GATT_ERR(BT_ATT_ERR_INVALID_ATTRIBUTE_LEN);
+	}
+
+	uint64_t start = ble_metrics_op_begin();
+
+	switch (data[0]) {
+	case IMAGE_UPLOAD_BEGIN:
+		if (len != 10) {
+			return BT_GATT_ERR(BT_ATT_ERR_INVALID_ATTRIBUTE_LEN);
+		}
+		ret = image_upload_begin(sys_get_le16(&data[1]), sys_get_le16(&data[3]),
+					 sys_get_le16(&data[5]), sys_get_le16(&data[7]),
+					 data[9]);
+		break;
+	case IMAGE_UPLOAD_DATA:
+		ret = image_upload_data(&data[1], len - 1);
+		break;
+	case IMAGE_UPLOAD_COMMIT:
+		ret = image_upload_commit();
+		break;
+	default:
+		ret = -ENOTSUP;
+		break;
+	}
+
+	ble_metrics_op_end(BLE_METRIC_WRITE_IMAGE, start, len);
+
+	if (ret == -EBUSY) {
+		return BT_GATT_ERR(BT_ATT_ERR_WRITE_REQ_REJECTED);
+	} else if (ret == -ENOMEM) {
+		return BT_GATT_ERR(BT_ATT_ERR_INSUFFICIENT_RESOURCES);
+	} else if (ret != 0) {
+		return BT_GATT_ERR(BT_ATT_ERR_VALUE_NOT_ALLOWED);
+	}
+
+	return len;
+}
+
+/* Image Characteristic Read Callback - upload progress */
+static ssize_t read_image(struct bt_conn *conn,
+			  const struct bt_gatt_attr *attr,
+			  void *buf, uint16_t len, uint16_t offset)
+{
+	struct image_upload_status status;
+	uint8_t value[9];
+
+	image_upload_get_status(&status);
+
+	value[0] = status.state;
+	sys_put_le16(status.received, &value[1]);
+	sys_put_le16(status.expected, &value[3]);
+	sys_put_le32(status.elapsed_ms, &value[5]);
+
+	return bt_gatt_attr_read(conn, attr, buf, len, offset, value, sizeof(value));
+}
+
 /* Text Characteristic Write Callback */
 static ssize_t write_text(struct bt_conn *conn,
 			  const struct bt_gatt_attr *attr,
 			  const void *buf, uint16_t len, uint16_t offset,
 			  uint8_t flags)
 {
-	if (offset + len > TEXT_BUFFER_SIZE - 1) {
+	int ret;
+
+	/* Write without response appends, so long texts stream in MTU chunks */
+	if (flags & BT_GATT_WRITE_FLAG_CMD) {
+		offset = text_pages_copy(NULL, 0, 0);
+	}
+
+	if (offset + len > CONFIG_APP_TEXT_MAX_LEN) {
 		return BT_GATT_ERR(BT_ATT_ERR_INVALID_OFFSET);
 	}
 
-	memcpy(text_buffer + offset, buf, len);
-	text_buffer[offset + len] = '\0'; /* Null terminate */
+	/* Prepare requests are only validated, the data comes with execute */
+	if (flags & BT_GATT_WRITE_FLAG_PREPARE) {
+		return 0;
+	}
+
+	uint64_t start = ble_metrics_op_begin();
 
-	LOG_INF("Received text (%d bytes): %s", len, text_buffer);
+	TRACE_BEGIN(TRACE_SPAN_GATT_WRITE, TEXT_CHAR_UUID_VAL);
 
-	/* Update the display with the received text */
-	display_show_message(text_buffer);
+	/* Lays out the new part and shows the first page once the parts stop */
+	ret = text_pages_write(buf, len, offset);
 
+	TRACE_END(TRACE_SPAN_GATT_WRITE, TEXT_CHAR_UUID_VAL);
+
+	if (ret != 0) {
+		return BT_GATT_ERR(BT_ATT_ERR_INVALID_OFFSET);
+	}
+
+	LOG_DBG("Received text (%d bytes at offset %d)", len, offset);
+
+	ble_metrics_op_end(BLE_METRIC_WRITE_TEXT, start, len);
 	return len;
 }
 
@@ -104,49 +233,141 @@ static ssize_t read_text(struct bt_conn *conn,
 			 const struct bt_gatt_attr *attr,
 			 void *buf, uint16_t len, uint16_t offset)
 {
-	size_t text_len = strlen(text_buffer);
-	return bt_gatt_attr_read(conn, attr, buf, len, offset,
-				 text_buffer, text_len);
+	/* Copied under the pager lock, a write may change the text meanwhile */
+	size_t text_len = text_pages_copy(buf, len, offset);
+
+	if (offset > text_len) {
+		return BT_GATT_ERR(BT_ATT_ERR_INVALID_OFFSET);
+	}
+
+	return MIN(len, text_len - offset);
+}
+
+/* Text Page Characteristic Write Callback - page navigation */
+static ssize_t write_text_page(struct bt_conn *conn,
+			       const struct bt_gatt_attr *attr,
+			       const void *buf, uint16_t len, uint16_t offset,
+			       uint8_t flags)
+{
+	const uint8_t *data = buf;
+	uint16_t page = 0;
+
+	if (offset != 0 || len < 1) {
+		return BT_GATT_ERR(BT_ATT_ERR_INVALID_ATTRIBUTE_LEN);
+	}
+
+	if (data[0] == TEXT_PAGE_GOTO) {
+		if (len < 3) {
+			return BT_GATT_ERR(BT_ATT_ERR_INVALID_ATTRIBUTE_LEN);
+		}
+		page = sys_get_le16(&data[1]);
+	}
+
+	if (text_pages_navigate(data[0], page) != 0) {
+		return BT_GATT_ERR(BT_ATT_ERR_VALUE_NOT_ALLOWED);
+	}
+
+	return len;
+}
+
+/* Text Page Characteristic Read Callback - page, pages, lines, length */
+static ssize_t read_text_page(struct bt_conn *conn,
+			      const struct bt_gatt_attr *attr,
+			      void *buf, uint16_t len, uint16_t offset)
+{
+	struct text_pages_state state;
+	uint8_t value[9];
+
+	text_pages_get_state(&state);
+
+	sys_put_le16(state.page, &value[0]);
+	sys_put_le16(state.pages, &value[2]);
+	sys_put_le16(state.lines, &value[4]);
+	sys_put_le16(state.length, &value[6]);
+	value[8] = state.truncated;
+
+	return bt_gatt_attr_read(conn, attr, buf, len, offset, value, sizeof(value));
 }
 
 /* RGB LED Service Declaration */
 BT_GATT_SERVICE_DEFINE(rgb_svc,
 	BT_GATT_PRIMARY_SERVICE(BT_UUID_RGB_SERVICE),
 
-	/* RGB Characteristic - Write RGB values (3 bytes: R, G, B) */
+	/* RGB Characteristic - Write RGB values (3 bytes: R, G, B), streamed without response */
 	BT_GATT_CHARACTERISTIC(BT_UUID_RGB_CHAR,
-			       BT_GATT_CHRC_READ | BT_GATT_CHRC_WRITE,
+			       BT_GATT_CHRC_READ | BT_GATT_CHRC_WRITE |
+			       BT_GATT_CHRC_WRITE_WITHOUT_RESP,
 			       BT_GATT_PERM_READ | BT_GATT_PERM_WRITE,
 			       read_rgb, write_rgb, NULL),
 
-	/* Text Characteristic - Write text to display (up to 127 chars) */
+	/* Text Characteristic - Write text to display, wrapped and paged (writes without response append) */
 	BT_GATT_CHARACTERISTIC(BT_UUID_TEXT_CHAR,
+			       BT_GATT_CHRC_READ | BT_GATT_CHRC_WRITE |
+			       BT_GATT_CHRC_WRITE_WITHOUT_RESP,
+			       BT_GATT_PERM_READ | BT_GATT_PERM_WRITE |
+			       BT_GATT_PERM_PREPARE_WRITE,
+			       read_text, write_text, NULL),
+
+	/* LED Pattern Characteristic - Play an effect (10 byte descriptor) */
+	BT_GATT_CHARACTERISTIC(BT_UUID_PATTERN_CHAR,
+			       BT_GATT_CHRC_WRITE,
+			       BT_GATT_PERM_WRITE,
+			       NULL, write_pattern, NULL),
+
+	/* Image Characteristic - Chunked region upload, read for progress */
+	BT_GATT_CHARACTERISTIC(BT_UUID_IMAGE_CHAR,
+			       BT_GATT_CHRC_READ | BT_GATT_CHRC_WRITE |
+			       BT_GATT_CHRC_WRITE_WITHOUT_RESP,
+			       BT_GATT_PERM_READ | BT_GATT_PERM_WRITE,
+			       read_image, write_image, NULL),
+
+	/* Text Page Characteristic - Navigate pages, read the paging state */
+	BT_GATT_CHARACTERISTIC(BT_UUID_TEXT_PAGE_CHAR,
 			       BT_GATT_CHRC_READ | BT_GATT_CHRC_WRITE,
 			       BT_GATT_PERM_READ | BT_GATT_PERM_WRITE,
-			       read_text, write_text, NULL),
+			       read_text_page, write_text_page, NULL),
 );
 
+#if defined(CONFIG_SHELL)
+static int cmd_diag_rgb(const struct shell *sh, size_t argc, char **argv)
+{
+	struct led_stream_stats st;
+
+	led_effects_stream_stats(&st);
+
+	shell_print(sh, "{\"frame_us\":%u,\"received\":%u,\"applied\":%u,\"dropped\":%u,"
+		    "\"latency_avg_us\":%u,\"latency_max_us\":%u,"
+		    "\"jitter_avg_us\":%u,\"jitter_max_us\":%u}",
+		    st.frame_us, st.frames_received, st.frames_applied,
+		    st.frames_dropped, st.latency_avg_us, st.latency_max_us,
+		    st.jitter_avg_us, st.jitter_max_us);
+
+	return 0;
+}
+
+SHELL_SUBCMD_ADD((diag), rgb, NULL, "RGB colour stream pacing (JSON)",
+		 cmd_diag_rgb, 1, 0);
+#endif /* CONFIG_SHELL */
+
 int ble_rgb_service_init(void)
 {
-	/* Check PWM devices */
-	if (!pwm_is_ready_dt(&pwm_led_red)) {
-		LOG_ERR("Red PWM device not ready");
-		return -ENODEV;
-	}
-	if (!pwm_is_ready_dt(&pwm_led_green)) {
-		LOG_ERR("Green PWM device not ready");
-		return -ENODEV;
-	}
-	if (!pwm_is_ready_dt(&pwm_led_blue)) {
-		LOG_ERR("Blue PWM device not ready");
-		return -ENODEV;
+	int ret;
+
+	/* Start the LED engine, the LED stays off */
+	ret = led_effects_init();
+	if (ret != 0) {
+		return ret;
 	}
 
-	/* Turn off RGB LED initially */
-	rgb_led_set_color(0, 0, 0);
+	ret = text_pages_init();
+	if (ret != 0) {
+		return ret;
+	}
 
-	/* Initialize text buffer */
-	memset(text_buffer, 0, TEXT_BUFFER_SIZE);
+	ret = image_upload_init();
+	if (ret != 0) {
+		return ret;
+	}
 
 	LOG_INF("RGB LED service initialized");
 	LOG_INF("Text display characteristic available (UUID: 0x%04X)", TEXT_CHAR_UUID_VAL);
@@ -6,7 +6,7 @@
 /**
  * @brief Initialize the RGB LED service
  *
- * This initializes the PWM hardware and sets up the RGB LED
+ * This starts the LED effects engine and turns the RGB LED off
  *
  * @return 0 on success, negative errno on failure
  */
@@ -15,6 +15,8 @@ int ble_rgb_service_init(void);
 /**
  * @brief Set RGB LED color directly
  *
+ * Replaces any running effect with a static, gamma corrected colour.
+ *
  * @param red Red value (0-255)
  * @param green Green value (0-255)
  * @param blue Blue value (0-255)
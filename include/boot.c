@@ -0,0 +1,72 @@
+#include "boot.h"
+#include <zephyr/logging/log.h>
+#if defined(CONFIG_SHELL)
+#include <zephyr/shell/shell.h>
+#endif
+
+LOG_MODULE_REGISTER(boot, CONFIG_APP_BOOT_LOG_LEVEL);
+
+static K_EVENT_DEFINE(boot_events);
+static uint32_t phase_us[BOOT_PHASE_COUNT];
+
+static const char *const phase_names[BOOT_PHASE_COUNT] = {
+	[BOOT_PHASE_MAIN] = "main",
+	[BOOT_PHASE_BT_READY] = "bt_ready",
+	[BOOT_PHASE_ADVERTISING] = "advertising",
+	[BOOT_PHASE_BATTERY_READY] = "battery_ready",
+	[BOOT_PHASE_FIRST_READING] = "first_reading",
+	[BOOT_PHASE_DISPLAY_READY] = "display_ready",
+};
+
+void boot_mark(enum boot_phase phase)
+{
+	uint32_t now_us = (uint32_t)k_ticks_to_us_near64(k_uptime_ticks());
+
+	/* Phases are marked once from their own thread, no lock needed */
+	if (phase >= BOOT_PHASE_COUNT || phase_us[phase] != 0) {
+		return;
+	}
+
+	phase_us[phase] = now_us;
+	k_event_post(&boot_events, BIT(phase));
+
+	LOG_INF("Boot phase %s at %u ms", phase_names[phase], now_us / 1000);
+}
+
+bool boot_reached(enum boot_phase phase)
+{
+	return k_event_test(&boot_events, BIT(phase)) != 0;
+}
+
+int boot_wait(enum boot_phase phase, k_timeout_t timeout)
+{
+	if (k_event_wait(&boot_events, BIT(phase), false, timeout) == 0) {
+		return -EAGAIN;
+	}
+
+	return 0;
+}
+
+uint32_t boot_phase_us(enum boot_phase phase)
+{
+	return (phase < BOOT_PHASE_COUNT) ? phase_us[phase] : 0;
+}
+
+#if defined(CONFIG_SHELL)
+static int cmd_diag_boot(const struct shell *sh, size_t argc, char **argv)
+{
+	shell_fprintf(sh, SHELL_NORMAL, "{");
+
+	for (size_t i = 0; i < BOOT_PHASE_COUNT; i++) {
+		shell_fprintf(sh, SHELL_NORMAL, "%s\"%s_us\":%u",
+			      i ? "," : "", phase_names[i], phase_us[i]);
+	}
+
+	shell_fprintf(sh, SHELL_NORMAL, "}\n");
+
+	return 0;
+}
+
+SHELL_SUBCMD_ADD((diag), boot, NULL, "Boot phase timestamps (JSON)",
+		 cmd_diag_boot, 1, 0);
+#endif /* CONFIG_SHELL */
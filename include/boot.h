@@ -0,0 +1,57 @@
+#ifndef BOOT_H
+#define BOOT_H
+
+#include <zephyr/kernel.h>
+
+/**
+ * @brief Boot milestones, in the order they are usually reached
+ *
+ * Display and battery bring-up run as work items on their own queues, so
+ * the phases after BOOT_PHASE_ADVERTISING may complete in any order.
+ */
+enum boot_phase {
+	BOOT_PHASE_MAIN = 0,        /* main() entered */
+	BOOT_PHASE_BT_READY,        /* bt_enable() returned */
+	BOOT_PHASE_ADVERTISING,     /* Connectable advertising (or mesh) started */
+	BOOT_PHASE_BATTERY_READY,   /* First battery level known */
+	BOOT_PHASE_FIRST_READING,   /* First sensor update published */
+	BOOT_PHASE_DISPLAY_READY,   /* Panel shows the sensor layout */
+	BOOT_PHASE_COUNT,
+};
+
+/**
+ * @brief Record that a boot phase was reached
+ *
+ * Only the first call per phase is recorded. Wakes threads waiting in
+ * boot_wait().
+ *
+ * @param phase Phase reached
+ */
+void boot_mark(enum boot_phase phase);
+
+/**
+ * @brief Check whether a boot phase was reached
+ *
+ * @param phase Phase to check
+ * @return true once boot_mark() was called for @p phase
+ */
+bool boot_reached(enum boot_phase phase);
+
+/**
+ * @brief Wait until a boot phase is reached
+ *
+ * @param phase Phase to wait for
+ * @param timeout Maximum time to wait
+ * @return 0 once reached, -EAGAIN on timeout
+ */
+int boot_wait(enum boot_phase phase, k_timeout_t timeout);
+
+/**
+ * @brief Get the uptime at which a boot phase was reached
+ *
+ * @param phase Phase to query
+ * @return Microseconds since kernel start, 0 if not reached yet
+ */
+uint32_t boot_phase_us(enum boot_phase phase);
+
+#endif /* BOOT_H */
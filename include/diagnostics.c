@@ -0,0 +1,352 @@
+#include "diagnostics.h"
+#include <zephyr/bluetooth/bluetooth.h>
+#include <zephyr/bluetooth/conn.h>
+#include <zephyr/bluetooth/gap.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/sys_heap.h>
+#include <zephyr/logging/log.h>
+#include <string.h>
+#if defined(CONFIG_SHELL)
+#include <zephyr/shell/shell.h>
+#endif
+
+LOG_MODULE_REGISTER(diag, CONFIG_APP_DIAG_LOG_LEVEL);
+
+/*
+ * Energy model for nRF52840 (DC/DC) and SSD1680 panel at 3.0V.
+ * Charges are in nC (1 uA for 1 ms = 1 nC).
+ */
+#define MODEL_SLEEP_UA           3     /* System ON, RTC running, RAM retained */
+#define MODEL_CPU_ACTIVE_UA      3300  /* CPU at 64 MHz running from flash */
+#define MODEL_DISPLAY_BUSY_UA    4000  /* Panel charge pump during refresh */
+#define MODEL_ADV_EVENT_NC       15000 /* Connectable legacy adv, 3 channels, 0 dBm */
+#define MODEL_CONN_EVENT_NC      5000  /* Empty connection event, 0 dBm */
+#define MODEL_ADC_SAMPLE_NC      30    /* SAADC 40us acquisition + conversion */
+#define MODEL_ADC_CONVERSION_NC  10    /* Divider current during settle window */
+
+/* Advertising interval used by main (BT_GAP_ADV_FAST_INT_MIN_2) */
+#define MODEL_ADV_INTERVAL_MS    100
+
+/* Registered static buffers, written once from module init */
+#define DIAG_MAX_BUFFERS 12
+
+static struct diag_buffer buffers[DIAG_MAX_BUFFERS];
+static atomic_t buffer_count;
+
+#if defined(CONFIG_SYS_HEAP_RUNTIME_STATS) && (CONFIG_HEAP_MEM_POOL_SIZE > 0)
+extern struct k_heap _system_heap;
+#endif
+
+/* Counters updated from ISR and workqueue context */
+static atomic_t display_refreshes;
+static atomic_t display_busy_ms;
+static atomic_t adc_conversions;
+static atomic_t adc_samples;
+
+/* Connection bookkeeping for the radio event model */
+static struct k_spinlock conn_lock;
+static int64_t init_time_ms;
+static int64_t conn_start_ms;
+static uint32_t conn_interval_us;
+static uint64_t conn_events;
+static uint64_t conn_time_ms;
+static bool conn_active;
+
+/* Fold the running connection into the totals, caller holds conn_lock */
+static void conn_account(int64_t now)
+{
+	if (!conn_active || conn_interval_us == 0) {
+		return;
+	}
+
+	uint64_t elapsed_ms = now - conn_start_ms;
+
+	conn_events += (elapsed_ms * 1000) / conn_interval_us;
+	conn_time_ms += elapsed_ms;
+	conn_start_ms = now;
+}
+
+static void diag_connected(struct bt_conn *conn, uint8_t err)
+{
+	struct bt_conn_info info;
+
+	if (err || bt_conn_get_info(conn, &info) != 0) {
+		return;
+	}
+
+	k_spinlock_key_t key = k_spin_lock(&conn_lock);
+
+	conn_active = true;
+	conn_start_ms = k_uptime_get();
+	conn_interval_us = BT_CONN_INTERVAL_TO_US(info.le.interval);
+
+	k_spin_unlock(&conn_lock, key);
+}
+
+static void diag_disconnected(struct bt_conn *conn, uint8_t reason)
+{
+	k_spinlock_key_t key = k_spin_lock(&conn_lock);
+
+	conn_account(k_uptime_get());
+	conn_active = false;
+
+	k_spin_unlock(&conn_lock, key);
+}
+
+static void diag_le_param_updated(struct bt_conn *conn, uint16_t interval,
+				  uint16_t latency, uint16_t timeout)
+{
+	k_spinlock_key_t key = k_spin_lock(&conn_lock);
+
+	conn_account(k_uptime_get());
+	conn_interval_us = BT_CONN_INTERVAL_TO_US(interval);
+
+	k_spin_unlock(&conn_lock, key);
+}
+
+BT_CONN_CB_DEFINE(diag_conn_callbacks) = {
+	.connected = diag_connected,
+	.disconnected = diag_disconnected,
+	.le_param_updated = diag_le_param_updated,
+};
+
+void diag_record_display_refresh(void)
+{
+	atomic_inc(&display_refreshes);
+}
+
+void diag_record_display_busy(uint32_t busy_ms)
+{
+	atomic_add(&display_busy_ms, busy_ms);
+}
+
+void diag_record_adc_conversion(uint16_t samples)
+{
+	atomic_inc(&adc_conversions);
+	atomic_add(&adc_samples, samples);
+}
+
+void diag_get_energy(struct diag_energy *out)
+{
+	k_thread_runtime_stats_t stats;
+	int64_t now = k_uptime_get();
+	uint64_t adv_time_ms;
+	uint64_t cpu_active_ms = 0;
+	uint64_t charge_nc;
+
+	k_spinlock_key_t key = k_spin_lock(&conn_lock);
+
+	conn_account(now);
+	out->conn_events = (uint32_t)conn_events;
+	adv_time_ms = (now - init_time_ms) - conn_time_ms;
+
+	k_spin_unlock(&conn_lock, key);
+
+	/* Advertising runs whenever no central is connected */
+	out->adv_events = (uint32_t)(adv_time_ms / MODEL_ADV_INTERVAL_MS);
+	out->uptime_s = (uint32_t)(now / 1000);
+	out->display_refreshes = atomic_get(&display_refreshes);
+	out->display_busy_ms = atomic_get(&display_busy_ms);
+	out->adc_conversions = atomic_get(&adc_conversions);
+
+	out->cpu_active_cycles = 0;
+	out->cpu_idle_cycles = 0;
+	if (k_thread_runtime_stats_all_get(&stats) == 0) {
+		out->cpu_active_cycles = stats.total_cycles;
+		out->cpu_idle_cycles = stats.idle_cycles;
+		cpu_active_ms = (stats.total_cycles * 1000) / sys_clock_hw_cycles_per_sec();
+	}
+
+	charge_nc = (uint64_t)MODEL_SLEEP_UA * now +
+		    (uint64_t)MODEL_CPU_ACTIVE_UA * cpu_active_ms +
+		    (uint64_t)MODEL_DISPLAY_BUSY_UA * out->display_busy_ms +
+		    (uint64_t)MODEL_ADV_EVENT_NC * out->adv_events +
+		    (uint64_t)MODEL_CONN_EVENT_NC * out->conn_events +
+		    (uint64_t)MODEL_ADC_SAMPLE_NC * (uint32_t)atomic_get(&adc_samples) +
+		    (uint64_t)MODEL_ADC_CONVERSION_NC * out->adc_conversions;
+
+	/* nC per ms is uA, scale to nA */
+	out->avg_current_na = (now > 0) ? (uint32_t)((charge_nc * 1000) / now) : 0;
+}
+
+struct stack_walk {
+	struct diag_stack *out;
+	size_t max;
+	size_t count;
+};
+
+static void stack_walk_cb(const struct k_thread *cthread, void *user_data)
+{
+	struct k_thread *thread = (struct k_thread *)cthread;
+	struct stack_walk *walk = user_data;
+	size_t unused;
+
+	if (walk->count >= walk->max) {
+		return;
+	}
+
+	if (k_thread_stack_space_get(thread, &unused) != 0) {
+		return;
+	}
+
+	struct diag_stack *entry = &walk->out[walk->count++];
+
+	entry->name = k_thread_name_get(thread);
+	entry->size = thread->stack_info.size;
+	entry->unused = unused;
+}
+
+size_t diag_get_stacks(struct diag_stack *out, size_t max)
+{
+	struct stack_walk walk = {
+		.out = out,
+		.max = max,
+		.count = 0,
+	};
+
+	/* Stack scans are slow, keep interrupts enabled while walking */
+	k_thread_foreach_unlocked(stack_walk_cb, &walk);
+
+	return walk.count;
+}
+
+void diag_register_buffer(const char *name, size_t size)
+{
+	atomic_val_t idx = atomic_inc(&buffer_count);
+
+	if (idx >= DIAG_MAX_BUFFERS) {
+		atomic_dec(&buffer_count);
+		LOG_WRN("No slot for buffer %s", name);
+		return;
+	}
+
+	buffers[idx].name = name;
+	buffers[idx].size = size;
+}
+
+size_t diag_get_buffers(struct diag_buffer *out, size_t max)
+{
+	size_t count = MIN((size_t)atomic_get(&buffer_count), max);
+
+	memcpy(out, buffers, count * sizeof(*out));
+
+	return count;
+}
+
+static void memory_walk_cb(const struct k_thread *cthread, void *user_data)
+{
+	struct k_thread *thread = (struct k_thread *)cthread;
+	struct diag_memory *out = user_data;
+	size_t unused;
+
+	if (k_thread_stack_space_get(thread, &unused) != 0) {
+		return;
+	}
+
+	out->stack_size += thread->stack_info.size;
+	out->stack_unused += unused;
+}
+
+void diag_get_memory(struct diag_memory *out)
+{
+	size_t count = MIN((size_t)atomic_get(&buffer_count), DIAG_MAX_BUFFERS);
+
+	memset(out, 0, sizeof(*out));
+
+#if defined(CONFIG_SYS_HEAP_RUNTIME_STATS) && (CONFIG_HEAP_MEM_POOL_SIZE > 0)
+	struct sys_memory_stats stats;
+
+	if (sys_heap_runtime_stats_get(&_system_heap.heap, &stats) == 0) {
+		out->heap_size = CONFIG_HEAP_MEM_POOL_SIZE;
+		out->heap_used = stats.allocated_bytes;
+		out->heap_max_used = stats.max_allocated_bytes;
+	}
+#endif
+
+	k_thread_foreach_unlocked(memory_walk_cb, out);
+
+	for (size_t i = 0; i < count; i++) {
+		out->buffer_bytes += buffers[i].size;
+	}
+}
+
+#if defined(CONFIG_SHELL)
+#define DIAG_SHELL_MAX_THREADS 16
+
+static int cmd_diag_energy(const struct shell *sh, size_t argc, char **argv)
+{
+	struct diag_energy energy;
+	uint64_t total_cycles;
+
+	diag_get_energy(&energy);
+	total_cycles = energy.cpu_active_cycles + energy.cpu_idle_cycles;
+
+	shell_print(sh, "Uptime:           %u s", energy.uptime_s);
+	shell_print(sh, "Radio events:     %u adv, %u conn (modelled)",
+		    energy.adv_events, energy.conn_events);
+	shell_print(sh, "Display:          %u refreshes, %u ms busy",
+		    energy.display_refreshes, energy.display_busy_ms);
+	shell_print(sh, "ADC conversions:  %u", energy.adc_conversions);
+	shell_print(sh, "CPU active:       %u.%u%%",
+		    total_cycles ? (uint32_t)(energy.cpu_active_cycles * 100 / total_cycles) : 0,
+		    total_cycles ? (uint32_t)(energy.cpu_active_cycles * 1000 / total_cycles % 10) : 0);
+	shell_print(sh, "Modelled charge:  %u.%03u uAh/h",
+		    energy.avg_current_na / 1000, energy.avg_current_na % 1000);
+
+	return 0;
+}
+
+static int cmd_diag_stacks(const struct shell *sh, size_t argc, char **argv)
+{
+	struct diag_stack stacks[DIAG_SHELL_MAX_THREADS];
+	size_t count = diag_get_stacks(stacks, ARRAY_SIZE(stacks));
+
+	shell_print(sh, "%-20s %6s %6s", "Thread", "Size", "Unused");
+	for (size_t i = 0; i < count; i++) {
+		shell_print(sh, "%-20s %6u %6u", stacks[i].name,
+			    (uint32_t)stacks[i].size, (uint32_t)stacks[i].unused);
+	}
+
+	return 0;
+}
+
+static int cmd_diag_memory(const struct shell *sh, size_t argc, char **argv)
+{
+	struct diag_memory mem;
+	struct diag_buffer list[DIAG_MAX_BUFFERS];
+	size_t count = diag_get_buffers(list, ARRAY_SIZE(list));
+
+	diag_get_memory(&mem);
+
+	shell_print(sh, "Heap:    %u used, %u peak of %u",
+		    (uint32_t)mem.heap_used, (uint32_t)mem.heap_max_used,
+		    (uint32_t)mem.heap_size);
+	shell_print(sh, "Stacks:  %u used of %u",
+		    (uint32_t)(mem.stack_size - mem.stack_unused), (uint32_t)mem.stack_size);
+	shell_print(sh, "Buffers: %u", (uint32_t)mem.buffer_bytes);
+	for (size_t i = 0; i < count; i++) {
+		shell_print(sh, "  %-20s %6u", list[i].name, (uint32_t)list[i].size);
+	}
+
+	return 0;
+}
+
+/* Other modules add their own 'diag' subcommands with SHELL_SUBCMD_ADD((diag), ...) */
+SHELL_SUBCMD_SET_CREATE(diag_cmds, (diag));
+SHELL_CMD_REGISTER(diag, &diag_cmds, "Device diagnostics", NULL);
+
+SHELL_SUBCMD_ADD((diag), energy, NULL, "Energy and duty-cycle accounting",
+		 cmd_diag_energy, 1, 0);
+SHELL_SUBCMD_ADD((diag), stacks, NULL, "Per-thread stack high-water marks",
+		 cmd_diag_stacks, 1, 0);
+SHELL_SUBCMD_ADD((diag), memory, NULL, "Heap, stack and static buffer usage",
+		 cmd_diag_memory, 1, 0);
+#endif /* CONFIG_SHELL */
+
+int diagnostics_init(void)
+{
+	init_time_ms = k_uptime_get();
+
+	LOG_INF("Diagnostics accounting started");
+	return 0;
+}
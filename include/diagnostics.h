@@ -0,0 +1,124 @@
+#ifndef DIAGNOSTICS_H
+#define DIAGNOSTICS_H
+
+#include <zephyr/kernel.h>
+
+/**
+ * @brief Energy and duty-cycle accounting snapshot
+ *
+ * Counters are cumulative since boot. The average current is modelled
+ * from the counters and per-event charge estimates, so 1 nA average
+ * equals 0.001 uAh per hour.
+ */
+struct diag_energy {
+	uint32_t uptime_s;           /* Time since boot */
+	uint32_t adv_events;         /* Modelled advertising events */
+	uint32_t conn_events;        /* Modelled connection events */
+	uint32_t display_refreshes;  /* Panel refreshes started */
+	uint32_t display_busy_ms;    /* Time the panel held BUSY */
+	uint32_t adc_conversions;    /* Battery ADC conversions */
+	uint64_t cpu_active_cycles;  /* Non-idle CPU cycles */
+	uint64_t cpu_idle_cycles;    /* Idle thread CPU cycles */
+	uint32_t avg_current_na;     /* Modelled average current (nA) */
+};
+
+/**
+ * @brief Stack usage of one thread
+ */
+struct diag_stack {
+	const char *name;  /* Thread name */
+	size_t size;       /* Stack size in bytes */
+	size_t unused;     /* Bytes never touched (high-water mark) */
+};
+
+/**
+ * @brief Static RAM buffer owned by an application module
+ */
+struct diag_buffer {
+	const char *name;  /* Module and buffer, e.g. "rgb.text" */
+	size_t size;       /* Size in bytes */
+};
+
+/**
+ * @brief RAM usage snapshot
+ *
+ * Heap figures are 0 without CONFIG_SYS_HEAP_RUNTIME_STATS.
+ */
+struct diag_memory {
+	size_t heap_size;      /* System heap (CONFIG_HEAP_MEM_POOL_SIZE) */
+	size_t heap_used;      /* Currently allocated */
+	size_t heap_max_used;  /* Allocation high-water mark */
+	size_t stack_size;     /* Stacks of all threads */
+	size_t stack_unused;   /* Never touched bytes of all stacks */
+	size_t buffer_bytes;   /* Registered static buffers */
+};
+
+/**
+ * @brief Initialize diagnostics accounting
+ *
+ * @return 0 on success, negative errno on failure
+ */
+int diagnostics_init(void);
+
+/**
+ * @brief Record the start of a panel refresh
+ */
+void diag_record_display_refresh(void);
+
+/**
+ * @brief Record time spent with the panel BUSY line asserted
+ *
+ * @param busy_ms Duration of the busy period in milliseconds
+ */
+void diag_record_display_busy(uint32_t busy_ms);
+
+/**
+ * @brief Record one battery ADC conversion
+ *
+ * @param samples Number of SAADC samples taken (oversampling included)
+ */
+void diag_record_adc_conversion(uint16_t samples);
+
+/**
+ * @brief Take an energy accounting snapshot
+ *
+ * @param out Snapshot to fill
+ */
+void diag_get_energy(struct diag_energy *out);
+
+/**
+ * @brief Collect per-thread stack high-water marks
+ *
+ * @param out Array to fill
+ * @param max Capacity of @p out
+ * @return Number of threads written
+ */
+size_t diag_get_stacks(struct diag_stack *out, size_t max);
+
+/**
+ * @brief Register a static buffer for the memory report
+ *
+ * Called once from the owning module's init. The name must stay valid.
+ *
+ * @param name Module and buffer name
+ * @param size Buffer size in bytes
+ */
+void diag_register_buffer(const char *name, size_t size);
+
+/**
+ * @brief Collect the registered static buffers
+ *
+ * @param out Array to fill
+ * @param max Capacity of @p out
+ * @return Number of buffers written
+ */
+size_t diag_get_buffers(struct diag_buffer *out, size_t max);
+
+/**
+ * @brief Take a RAM usage snapshot
+ *
+ * @param out Snapshot to fill
+ */
+void diag_get_memory(struct diag_memory *out);
+
+#endif /* DIAGNOSTICS_H */
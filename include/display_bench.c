@@ -0,0 +1,134 @@
+#include "display_bench.h"
+#include "display_epaper.h"
+#include "icons.h"
+#include "numfmt.h"
+#include <zephyr/timing/timing.h>
+#include <zephyr/sys/printk.h>
+#include <zephyr/logging/log.h>
+
+LOG_MODULE_REGISTER(display_bench, CONFIG_APP_DISPLAY_LOG_LEVEL);
+
+#define BENCH_ITERATIONS CONFIG_APP_RENDER_BENCH_ITERATIONS
+#define BENCH_GRAPH_POINTS 50  /* Fill the whole graph history */
+
+struct bench_result {
+	uint64_t total;
+	uint64_t min;
+	uint64_t max;
+};
+
+typedef void (*bench_fn_t)(void);
+
+static void bench_draw_image(void)
+{
+	display_draw_image(icon_thermometer, 0, 7,
+			   ICON_THERMOMETER_WIDTH, ICON_THERMOMETER_HEIGHT);
+}
+
+static void bench_draw_graph(void)
+{
+	display_draw_graph();
+}
+
+static void bench_update_sensors(void)
+{
+	display_update_sensors(2250, 5500);
+}
+
+/* The dashboard value strings, as draw_dashboard() formats them */
+static void bench_format(void)
+{
+	char buf[16];
+	struct numfmt f;
+
+	numfmt_init(&f, buf, sizeof(buf));
+	numfmt_fixed(&f, -1234, 2, 2);
+	numfmt_str(&f, " C");
+
+	numfmt_init(&f, buf, sizeof(buf));
+	numfmt_fixed(&f, 5500, 2, 2);
+	numfmt_str(&f, " %");
+}
+
+static void bench_finalize(void)
+{
+	display_flush();
+}
+
+static bool bench_measure(const char *name, bench_fn_t fn, uint32_t budget_us)
+{
+	struct bench_result res = {
+		.total = 0,
+		.min = UINT64_MAX,
+		.max = 0,
+	};
+	uint64_t avg;
+	const char *result;
+	bool pass;
+
+	for (int i = 0; i < BENCH_ITERATIONS; i++) {
+		timing_t start = timing_counter_get();
+
+		fn();
+
+		timing_t end = timing_counter_get();
+		uint64_t us = timing_cycles_to_ns(timing_cycles_get(&start, &end)) / NSEC_PER_USEC;
+
+		res.total += us;
+		res.min = MIN(res.min, us);
+		res.max = MAX(res.max, us);
+	}
+
+	avg = res.total / BENCH_ITERATIONS;
+
+	if (IS_ENABLED(CONFIG_APP_RENDER_BENCH_REPORT_ONLY)) {
+		pass = true;
+		result = "REPORT";
+	} else {
+		/* A missing budget fails, so a new measurement cannot slip through */
+		pass = (budget_us != 0) && (avg <= budget_us);
+		result = pass ? "PASS" : "FAIL";
+	}
+
+	printk("RENDER-BENCH %s avg=%llu min=%llu max=%llu budget=%u %s\n",
+	       name, avg, res.min, res.max, budget_us, result);
+
+	return pass;
+}
+
+int display_bench_run(void)
+{
+	bool pass = true;
+	int ret;
+
+	ret = display_epaper_init();
+	if (ret != 0) {
+		LOG_ERR("Display init failed (err %d)", ret);
+		return ret;
+	}
+
+	/* Graph needs history to draw anything */
+	for (int i = 0; i < BENCH_GRAPH_POINTS; i++) {
+		display_add_temp_reading(2000 + (i * 37) % 600);
+	}
+
+	timing_init();
+	timing_start();
+
+	pass &= bench_measure("display_draw_image", bench_draw_image,
+			      CONFIG_APP_RENDER_BENCH_BUDGET_DRAW_IMAGE);
+	pass &= bench_measure("display_draw_graph", bench_draw_graph,
+			      CONFIG_APP_RENDER_BENCH_BUDGET_DRAW_GRAPH);
+	pass &= bench_measure("display_update_sensors", bench_update_sensors,
+			      CONFIG_APP_RENDER_BENCH_BUDGET_UPDATE_SENSORS);
+	pass &= bench_measure("numfmt_dashboard", bench_format,
+			      CONFIG_APP_RENDER_BENCH_BUDGET_FORMAT);
+	pass &= bench_measure("cfb_framebuffer_finalize", bench_finalize,
+			      CONFIG_APP_RENDER_BENCH_BUDGET_FINALIZE);
+
+	timing_stop();
+
+	printk("RENDER-BENCH-RESULT %s\n", pass ? "PASS" : "FAIL");
+
+	return pass ? 0 : -ERANGE;
+}
@@ -0,0 +1,20 @@
+#ifndef DISPLAY_BENCH_H
+#define DISPLAY_BENCH_H
+
+#include <zephyr/kernel.h>
+
+/**
+ * @brief Run the render benchmark
+ *
+ * Initializes the display, times the drawing primitives and a full-frame
+ * finalize, and prints one machine readable line per measurement:
+ *
+ *   RENDER-BENCH <name> avg=<us> min=<us> max=<us> budget=<us> PASS|FAIL|REPORT
+ *
+ * followed by RENDER-BENCH-RESULT PASS|FAIL.
+ *
+ * @return 0 if every measurement is within budget, -ERANGE otherwise
+ */
+int display_bench_run(void);
+
+#endif /* DISPLAY_BENCH_H */
@@ -0,0 +1,138 @@
+#define DT_DRV_COMPAT bleink_capture_display
+
+#include <zephyr/device.h>
+#include <zephyr/drivers/display.h>
+#include <zephyr/sys/crc.h>
+#include <zephyr/sys/printk.h>
+#include <zephyr/logging/log.h>
+#include <string.h>
+
+LOG_MODULE_REGISTER(display_capture, CONFIG_DISPLAY_LOG_LEVEL);
+
+/*
+ * Same framebuffer layout as the SSD16xx driver: vertically tiled,
+ * MSB first, 1 = black (MONO10).
+ */
+#define CAPTURE_WIDTH DT_INST_PROP(0, width)
+#define CAPTURE_HEIGHT DT_INST_PROP(0, height)
+#define CAPTURE_PAGES DIV_ROUND_UP(CAPTURE_HEIGHT, 8)
+
+static uint8_t capture_fb[CAPTURE_PAGES * CAPTURE_WIDTH];
+static uint32_t frame_count;
+static enum display_orientation capture_orientation;
+
+static bool capture_pixel(uint16_t x, uint16_t y)
+{
+	return capture_fb[(y / 8) * CAPTURE_WIDTH + x] & BIT(7 - (y % 8));
+}
+
+/* Emit the frame as plain PBM (P1) between markers */
+static void capture_emit(void)
+{
+	char row[CAPTURE_WIDTH + 1];
+	uint32_t crc = crc32_ieee(capture_fb, sizeof(capture_fb));
+
+	printk("FRAME-BEGIN %u crc32=%08x\n", frame_count, crc);
+
+	if (IS_ENABLED(CONFIG_APP_CAPTURE_DISPLAY_PBM)) {
+		printk("P1\n%d %d\n", CAPTURE_WIDTH, CAPTURE_HEIGHT);
+		for (uint16_t y = 0; y < CAPTURE_HEIGHT; y++) {
+			for (uint16_t x = 0; x < CAPTURE_WIDTH; x++) {
+				row[x] = capture_pixel(x, y) ? '1' : '0';
+			}
+			row[CAPTURE_WIDTH] = '\0';
+			printk("%s\n", row);
+		}
+	}
+
+	printk("FRAME-END %u\n", frame_count);
+	frame_count++;
+}
+
+static int capture_write(const struct device *dev, const uint16_t x, const uint16_t y,
+			 const struct display_buffer_descriptor *desc, const void *buf)
+{
+	const uint8_t *src = buf;
+	uint16_t pages = DIV_ROUND_UP(desc->height, 8);
+
+	if ((y % 8) != 0 || x + desc->width > CAPTURE_WIDTH ||
+	    y + desc->height > CAPTURE_HEIGHT + 7) {
+		LOG_ERR("Unsupported write region %ux%u at (%u,%u)",
+			desc->width, desc->height, x, y);
+		return -EINVAL;
+	}
+
+	/*
+	 * CFB sizes its buffer as width * height / 8, which is shorter than
+	 * the last partial page, so copy no further than buf_size.
+	 */
+	for (uint16_t page = 0; page < pages && (y / 8 + page) < CAPTURE_PAGES; page++) {
+		size_t offset = (size_t)page * desc->pitch;
+
+		if (offset >= desc->buf_size) {
+			break;
+		}
+
+		memcpy(&capture_fb[(y / 8 + page) * CAPTURE_WIDTH + x], &src[offset],
+		       MIN(desc->width, desc->buf_size - offset));
+	}
+
+	capture_emit();
+
+	return 0;
+}
+
+static int capture_blanking_off(const struct device *dev)
+{
+	return 0;
+}
+
+static int capture_blanking_on(const struct device *dev)
+{
+	return 0;
+}
+
+static void capture_get_capabilities(const struct device *dev,
+				     struct display_capabilities *caps)
+{
+	memset(caps, 0, sizeof(*caps));
+	caps->x_resolution = CAPTURE_WIDTH;
+	caps->y_resolution = CAPTURE_HEIGHT;
+	caps->supported_pixel_formats = PIXEL_FORMAT_MONO10;
+	caps->current_pixel_format = PIXEL_FORMAT_MONO10;
+	caps->screen_info = SCREEN_INFO_MONO_VTILED | SCREEN_INFO_MONO_MSB_FIRST |
+			    SCREEN_INFO_EPD;
+	caps->current_orientation = capture_orientation;
+}
+
+static int capture_set_pixel_format(const struct device *dev,
+				    const enum display_pixel_format pf)
+{
+	return (pf == PIXEL_FORMAT_MONO10) ? 0 : -ENOTSUP;
+}
+
+/* Orientation is only recorded, frames are captured as written */
+static int capture_set_orientation(const struct device *dev,
+				   const enum display_orientation orientation)
+{
+	capture_orientation = orientation;
+	return 0;
+}
+
+static int capture_init(const struct device *dev)
+{
+	memset(capture_fb, 0, sizeof(capture_fb));
+	return 0;
+}
+
+static const struct display_driver_api capture_api = {
+	.blanking_on = capture_blanking_on,
+	.blanking_off = capture_blanking_off,
+	.write = capture_write,
+	.get_capabilities = capture_get_capabilities,
+	.set_pixel_format = capture_set_pixel_format,
+	.set_orientation = capture_set_orientation,
+};
+
+DEVICE_DT_INST_DEFINE(0, capture_init, NULL, NULL, NULL,
+		      POST_KERNEL, CONFIG_DISPLAY_INIT_PRIORITY, &capture_api);
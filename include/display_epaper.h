@@ -2,6 +2,7 @@
 #define DISPLAY_EPAPER_H
 
 #include <zephyr/kernel.h>
+#include "neighbours.h"
 
 /**
  * @brief Display rotation angles
@@ -20,6 +21,16 @@ enum display_rotation {
  */
 int display_epaper_init(void);
 
+/**
+ * @brief Check whether init found the dashboard still on the panel
+ *
+ * After a warm reset the last dashboard and graph history are restored
+ * from retained RAM instead of drawing the logo and the labels.
+ *
+ * @return true if display_epaper_init() restored the dashboard
+ */
+bool display_is_restored(void);
+
 /**
  * @brief Initialize sensor display with static labels
  */
@@ -33,6 +44,39 @@ void display_init_sensor_labels(void);
  */
 void display_update_sensors(int16_t temp_celsius, uint16_t humidity_percent);
 
+/**
+ * @brief Redraw the sensor dashboard with the battery level
+ *
+ * Same frame as display_update_sensors() followed by
+ * display_update_battery(), but composed first and flushed once, so the
+ * panel refreshes a single time.
+ *
+ * @param temp_celsius Temperature in Celsius * 100
+ * @param humidity_percent Humidity in percent * 100
+ * @param voltage_mv Battery voltage in millivolts
+ * @param percentage Battery percentage (0-100)
+ */
+void display_update_dashboard(int16_t temp_celsius, uint16_t humidity_percent,
+			      uint16_t voltage_mv, uint8_t percentage);
+
+/* Neighbours listed below the own reading, fewer on low panels */
+#define DISPLAY_NEIGHBOURS_MAX 6
+
+/**
+ * @brief Show own and neighbouring readings as a compact table
+ *
+ * One line per node: address suffix, temperature, humidity, RSSI and
+ * age. The own node comes first.
+ *
+ * @param temp_celsius Own temperature in Celsius * 100
+ * @param humidity_percent Own humidity in percent * 100
+ * @param battery_pct Own battery level in percent
+ * @param list Neighbours, most recently heard first
+ * @param count Number of entries in @p list
+ */
+void display_update_neighbours(int16_t temp_celsius, uint16_t humidity_percent,
+			       uint8_t battery_pct, const struct neighbour *list, size_t count);
+
 /**
  * @brief Update battery display
  *
@@ -44,10 +88,30 @@ void display_update_battery(uint16_t voltage_mv, uint8_t percentage);
 /**
  * @brief Show a message on the display
  *
+ * The message is word wrapped and split into pages, see text_pages.h.
+ * Rendering happens on the display work queue.
+ *
  * @param message Message to display
  */
 void display_show_message(const char *message);
 
+/**
+ * @brief Get the text grid of the panel in the current font
+ *
+ * @param cols Set to the characters per line
+ * @param rows Set to the lines per page
+ * @return 0 on success, -ENODEV before display_epaper_init()
+ */
+int display_text_geometry(uint16_t *cols, uint16_t *rows);
+
+/**
+ * @brief Show lines of text, one per font row
+ *
+ * @param lines Lines as consecutive NUL terminated strings
+ * @param count Number of lines
+ */
+void display_show_lines(const char *lines, uint16_t count);
+
 /**
  * @brief Set display rotation
  *
@@ -81,4 +145,56 @@ void display_add_temp_reading(int16_t temp_celsius);
  */
 void display_draw_graph(void);
 
+/**
+ * @brief Push the framebuffer to the panel
+ *
+ * @return 0 on success, negative errno on failure
+ */
+int display_flush(void);
+
+/**
+ * @brief Write a region straight to the panel
+ *
+ * Bypasses the character framebuffer, so only the region is refreshed.
+ * The buffer uses the panel layout: vertically tiled, one byte per
+ * 8-pixel column of a page, MSB on top, 1 = black.
+ *
+ * @param x Region X coordinate
+ * @param y Region Y coordinate (multiple of 8)
+ * @param width Region width in pixels
+ * @param height Region height in pixels (multiple of 8)
+ * @param buf Region data, width * height / 8 bytes
+ * @return 0 on success, negative errno on failure
+ */
+int display_write_region(uint16_t x, uint16_t y, uint16_t width, uint16_t height,
+			 const uint8_t *buf);
+
+/**
+ * @brief Keep a region on top of every later frame
+ *
+ * display_write_region() leaves the framebuffer alone, so the next
+ * flush would overwrite the region. The overlay is copied into the
+ * framebuffer before each flush instead. The buffer is not copied and
+ * must stay valid until the overlay is replaced or removed. Views that
+ * take the whole panel (dashboard, text lines, neighbour table) remove it.
+ *
+ * @param x Region X coordinate
+ * @param y Region Y coordinate
+ * @param width Region width in pixels
+ * @param height Region height in pixels (multiple of 8)
+ * @param buf Region data in the display_write_region() layout, NULL removes
+ *            the overlay
+ */
+void display_set_overlay(uint16_t x, uint16_t y, uint16_t width, uint16_t height,
+			 const uint8_t *buf);
+
+/**
+ * @brief Check whether the panel is currently refreshing
+ *
+ * Reads the controller BUSY line.
+ *
+ * @return true while a refresh is in progress
+ */
+bool display_is_busy(void);
+
 #endif /* DISPLAY_EPAPER_H */
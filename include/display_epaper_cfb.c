@@ -1,55 +1,324 @@
 #include "display_epaper.h"
-#include "ble_rgb_service.h"
+#include "led_effects.h"
+#include "diagnostics.h"
+#include "trace.h"
 #include "icons.h"
+#include "display_layout.h"
+#include "numfmt.h"
+#include "text_pages.h"
 #include <zephyr/device.h>
 #include <zephyr/drivers/display.h>
+#include <zephyr/drivers/gpio.h>
 #include <zephyr/display/cfb.h>
 #include <zephyr/logging/log.h>
-#include <stdio.h>
+#include <zephyr/sys/crc.h>
+#include <stddef.h>
+#include <stdlib.h>
 #include <string.h>
 
-LOG_MODULE_REGISTER(display, LOG_LEVEL_INF);
+LOG_MODULE_REGISTER(display, CONFIG_APP_DISPLAY_LOG_LEVEL);
 
 static const struct device *display_dev;
-static enum display_rotation current_rotation = DISPLAY_ROTATION_180;
-
-/* Temperature graph data */
+/* Panels without a BUSY line (e.g. the native_sim capture display) report idle */
+static const struct gpio_dt_spec busy_gpio =
+	GPIO_DT_SPEC_GET_OR(DT_CHOSEN(zephyr_display), busy_gpios, {0});
+static struct gpio_callback busy_cb;
+static uint32_t busy_start_ms;
+static enum display_rotation current_rotation = LAYOUT_ROTATION;
+
+/* Temperature graph data, geometry from display_layout.h */
 #define GRAPH_MAX_POINTS 50  /* Number of data points to store */
-#define GRAPH_LABEL_WIDTH 24 /* Width reserved for Y-axis labels */
-#define GRAPH_X 24           /* Graph X position (leave space for labels) */
-#define GRAPH_Y 72           /* Graph Y position (below icons) */
-#define GRAPH_WIDTH 226      /* Graph width (250 - 24 for labels) */
-#define GRAPH_HEIGHT 48      /* Graph height (72 to 120) */
+#define GRAPH_X      LAYOUT_GRAPH_X
+#define GRAPH_Y      LAYOUT_GRAPH_Y
+#define GRAPH_WIDTH  LAYOUT_GRAPH_WIDTH
+#define GRAPH_HEIGHT LAYOUT_GRAPH_HEIGHT
+
+/*
+ * Dashboard state kept in RAM that a warm reset (soft reset, watchdog,
+ * fault) does not clear. The panel keeps its image without power, so a
+ * valid fingerprint means the panel still shows exactly this dashboard.
+ * The graph history lives here directly instead of in a second copy.
+ */
+#define RETAINED_MAGIC 0x424c4b31  /* "BLK1" */
+
+struct display_retained {
+	uint32_t magic;
+	int16_t temperature;
+	uint16_t humidity;
+	uint8_t battery_pct;
+	uint8_t history_count;
+	uint8_t history_index;
+	int16_t history[GRAPH_MAX_POINTS];
+	uint32_t fingerprint;  /* CRC32 of the fields above */
+};
+
+static __noinit struct display_retained retained;
+static bool restored;
+
+static uint32_t retained_crc(void)
+{
+	return crc32_ieee((const uint8_t *)&retained,
+			  offsetof(struct display_retained, fingerprint));
+}
+
+/* Record the dashboard just pushed to the panel */
+static void retained_save(void)
+{
+	retained.magic = RETAINED_MAGIC;
+	retained.fingerprint = retained_crc();
+}
+
+/* The panel shows something else than the dashboard */
+static void retained_invalidate(void)
+{
+	retained.magic = 0;
+}
+
+static bool retained_valid(void)
+{
+	return retained.magic == RETAINED_MAGIC &&
+	       retained.fingerprint == retained_crc() &&
+	       retained.history_count <= GRAPH_MAX_POINTS &&
+	       retained.history_index < GRAPH_MAX_POINTS;
+}
+
+/* Measure how long the panel holds BUSY for energy accounting */
+static void busy_changed(const struct device *port, struct gpio_callback *cb,
+			 gpio_port_pins_t pins)
+{
+	if (gpio_pin_get_dt(&busy_gpio) > 0) {
+		busy_start_ms = k_uptime_get_32();
+	} else if (busy_start_ms != 0) {
+		diag_record_display_busy(k_uptime_get_32() - busy_start_ms);
+		busy_start_ms = 0;
+	}
+}
+
+/*
+ * Uploaded image kept on top of the framebuffer. The region is written
+ * to the panel directly, CFB keeps its own copy of the frame, so without
+ * this the next dashboard flush would paint over the image.
+ */
+static K_MUTEX_DEFINE(overlay_lock);
+static const uint8_t *overlay_buf;
+static uint16_t overlay_x, overlay_y, overlay_w, overlay_h;
+
+/* Copy the overlay into the framebuffer, white pixels included */
+static void overlay_draw(void)
+{
+	struct cfb_position pos;
+
+	k_mutex_lock(&overlay_lock, K_FOREVER);
+
+	if (overlay_buf == NULL) {
+		k_mutex_unlock(&overlay_lock);
+		return;
+	}
+
+	/* CFB only draws foreground, so fill the region and invert it to clear */
+	for (uint16_t row = 0; row < overlay_h; row++) {
+		for (uint16_t col = 0; col < overlay_w; col++) {
+			pos.x = overlay_x + col;
+			pos.y = overlay_y + row;
+			cfb_draw_point(display_dev, &pos);
+		}
+	}
+	cfb_invert_area(display_dev, overlay_x, overlay_y, overlay_w, overlay_h);
+
+	/* Panel layout: vertically tiled, MSB on top, 1 = black */
+	for (uint16_t row = 0; row < overlay_h; row++) {
+		const uint8_t *page = &overlay_buf[(row / 8) * overlay_w];
+
+		for (uint16_t col = 0; col < overlay_w; col++) {
+			if (!(page[col] & BIT(7 - (row % 8)))) {
+				continue;
+			}
+
+			pos.x = overlay_x + col;
+			pos.y = overlay_y + row;
+			cfb_draw_point(display_dev, &pos);
+		}
+	}
+
+	k_mutex_unlock(&overlay_lock);
+}
+
+int display_flush(void)
+{
+	int ret;
+
+	diag_record_display_refresh();
+
+	overlay_draw();
+
+	TRACE_BEGIN(TRACE_SPAN_FB_FINALIZE, 0);
+	ret = cfb_framebuffer_finalize(display_dev);
+	TRACE_END(TRACE_SPAN_FB_FINALIZE, 0);
+
+	return ret;
+}
+
+int display_write_region(uint16_t x, uint16_t y, uint16_t width, uint16_t height,
+			 const uint8_t *buf)
+{
+	struct display_buffer_descriptor desc = {
+		.buf_size = width * height / 8,
+		.width = width,
+		.height = height,
+		.pitch = width,
+	};
+	int ret;
+
+	if ((y % 8) != 0 || (height % 8) != 0) {
+		return -EINVAL;
+	}
+
+	retained_invalidate();
+	diag_record_display_refresh();
+
+	TRACE_BEGIN(TRACE_SPAN_FB_FINALIZE, width);
+	ret = display_write(display_dev, x, y, &desc, buf);
+	TRACE_END(TRACE_SPAN_FB_FINALIZE, width);
+
+	return ret;
+}
+
+void display_set_overlay(uint16_t x, uint16_t y, uint16_t width, uint16_t height,
+			 const uint8_t *buf)
+{
+	k_mutex_lock(&overlay_lock, K_FOREVER);
+
+	overlay_buf = buf;
+	overlay_x = x;
+	overlay_y = y;
+	overlay_w = width;
+	overlay_h = height;
+
+	k_mutex_unlock(&overlay_lock);
+}
+
+/* Sensor dashboard without the battery level, not flushed */
+static void draw_dashboard(int16_t temp_celsius, uint16_t humidity_percent)
+{
+	char temp_buf[16];
+	char humid_buf[16];
+	struct numfmt f;
+
+	/* Clear entire framebuffer to redraw everything fresh */
+	cfb_framebuffer_clear(display_dev, false);
+	/* The dashboard takes the whole panel, an uploaded image goes away */
+	display_set_overlay(0, 0, 0, 0, NULL);
+
+	/* Redraw icons */
+	display_draw_image(icon_thermometer, LAYOUT_TEMP_ICON_X, LAYOUT_TEMP_ICON_Y,
+			   ICON_THERMOMETER_WIDTH, ICON_THERMOMETER_HEIGHT);
+	display_draw_image(icon_full_battery, LAYOUT_BATT_ICON_X, LAYOUT_BATT_ICON_Y,
+			   ICON_FULL_BATTERY_WIDTH, ICON_FULL_BATTERY_HEIGHT);
+
+	/* Format temperature and humidity values */
+	numfmt_init(&f, temp_buf, sizeof(temp_buf));
+	numfmt_fixed(&f, temp_celsius, 2, 2);
+	numfmt_str(&f, " C");
+
+	numfmt_init(&f, humid_buf, sizeof(humid_buf));
+	numfmt_fixed(&f, humidity_percent, 2, 2);
+	numfmt_str(&f, " %");
+
+	/* Display values to the right of the temp/humidity icon */
+	cfb_print(display_dev, temp_buf, LAYOUT_VALUE_X, LAYOUT_TEMP_VALUE_Y);
+	cfb_print(display_dev, humid_buf, LAYOUT_VALUE_X, LAYOUT_HUMIDITY_VALUE_Y);
+
+	/* Draw the temperature graph at the bottom */
+	display_draw_graph();
+}
+
+static void draw_battery(uint8_t percentage)
+{
+	char batt_buf[8];
+	struct numfmt f;
+
+	/* Format battery percentage only */
+	numfmt_init(&f, batt_buf, sizeof(batt_buf));
+	numfmt_percent(&f, percentage);
+
+	/* Display percentage next to the battery icon */
+	cfb_print(display_dev, batt_buf, LAYOUT_BATT_TEXT_X, LAYOUT_BATT_TEXT_Y);
+}
+
+/*
+ * Warm reset: the panel still shows the retained dashboard. Rebuild it in
+ * the controller RAM while blanked, so the single refresh on unblanking
+ * redraws the same image instead of logo, clear and labels.
+ */
+static int display_restore(void)
+{
+	int ret;
+
+	draw_dashboard(retained.temperature, retained.humidity);
+	draw_battery(retained.battery_pct);
+	display_flush();
 
-static int16_t temp_history[GRAPH_MAX_POINTS];
-static uint8_t temp_history_count = 0;
-static uint8_t temp_history_index = 0;
+	ret = display_blanking_off(display_dev);
+	if (ret != 0) {
+		LOG_ERR("Failed to turn off blanking: %d", ret);
+		led_effects_play_status(LED_STATUS_ERROR);
+		return ret;
+	}
+
+	restored = true;
+	LOG_INF("E-Paper display restored after warm reset");
+
+	led_effects_play_status(LED_STATUS_OK);
+
+	return 0;
+}
+
+bool display_is_restored(void)
+{
+	return restored;
+}
 
 int display_epaper_init(void)
 {
 	int ret;
 	uint16_t rows, cols;
 
-	/* Yellow LED - Display init starting */
-	rgb_led_set_color(255, 255, 0);
-	k_sleep(K_MSEC(500));
+	/* Yellow breathing while the display initializes */
+	led_effects_play_status(LED_STATUS_BOOT);
+
+	diag_register_buffer("display.retained", sizeof(retained));
+
+	/* Cold boot: retained RAM holds garbage, start with an empty graph */
+	if (!retained_valid()) {
+		retained_invalidate();
+		retained.history_count = 0;
+		retained.history_index = 0;
+	}
 
 	display_dev = DEVICE_DT_GET(DT_CHOSEN(zephyr_display));
 
 	if (!device_is_ready(display_dev)) {
 		LOG_ERR("Display device not ready");
-		rgb_led_set_color(255, 0, 0);
+		led_effects_play_status(LED_STATUS_ERROR);
 		return -ENODEV;
 	}
 
-	/* Set rotation to 180 degrees */
-	display_set_rotation(DISPLAY_ROTATION_180);
+	/* Track BUSY edges for refresh time accounting */
+	if (busy_gpio.port != NULL) {
+		gpio_init_callback(&busy_cb, busy_changed, BIT(busy_gpio.pin));
+		if (gpio_add_callback_dt(&busy_gpio, &busy_cb) == 0) {
+			gpio_pin_interrupt_configure_dt(&busy_gpio, GPIO_INT_EDGE_BOTH);
+		}
+	}
+
+	/* Rotation as mounted, from the devicetree */
+	display_set_rotation(LAYOUT_ROTATION);
 
 	/* Initialize CFB */
 	ret = cfb_framebuffer_init(display_dev);
 	if (ret != 0) {
 		LOG_ERR("CFB init failed: %d", ret);
-		rgb_led_set_color(255, 0, 0);
+		led_effects_play_status(LED_STATUS_ERROR);
 		return ret;
 	}
 
@@ -65,126 +334,205 @@ int display_epaper_init(void)
 
 	cfb_framebuffer_clear(display_dev, false);
 
+	/* Invert display for black text on white background */
+	cfb_framebuffer_invert(display_dev);
+
+	if (retained_valid()) {
+		return display_restore();
+	}
+
 	/* Turn off blanking (enable display) */
 	ret = display_blanking_off(display_dev);
 	if (ret != 0) {
 		LOG_ERR("Failed to turn off blanking: %d", ret);
-		rgb_led_set_color(255, 0, 0);
+		led_effects_play_status(LED_STATUS_ERROR);
 		return ret;
 	}
 
-	/* Invert display for black text on white background */
-	cfb_framebuffer_invert(display_dev);
-
 	/* Draw bleink logo in middle of display */
-	/* Logo is 128x128 pixels, center it on 250x120 display */
-	/* X: (250 - 128) / 2 = 61, Y: (120 - 128) / 2 = -4 (clipped to 0, will overflow) */
-	ret = display_draw_image(bleink_logo, 61, 5, ICON_BLEINK_LOGO_WIDTH, ICON_BLEINK_LOGO_HEIGHT);
+	ret = display_draw_image(bleink_logo, LAYOUT_LOGO_X, LAYOUT_LOGO_Y,
+				 ICON_BLEINK_LOGO_WIDTH, LAYOUT_LOGO_HEIGHT);
 	if (ret != 0) {
 		LOG_ERR("Failed to draw logo: %d", ret);
 	}
 
-	cfb_framebuffer_finalize(display_dev);
+	display_flush();
 
 	LOG_INF("E-Paper display initialized with CFB");
 
-	/* GREEN LED - Success! */
-	rgb_led_set_color(0, 255, 0);
-	k_sleep(K_SECONDS(3));
-	rgb_led_set_color(0, 0, 0);
+	/* Green for 3 seconds, played by the LED engine without blocking */
+	led_effects_play_status(LED_STATUS_OK);
 
 	return 0;
 }
 
 void display_show_message(const char *message)
 {
-	uint16_t rows;
-
 	if (!message) {
 		return;
 	}
 
+	/* Wrapped and paged by the text pager, rendered on the display queue */
+	text_pages_show(message);
+}
+
+int display_text_geometry(uint16_t *cols, uint16_t *rows)
+{
+	uint8_t font_width;
+	uint8_t font_height;
+
+	if (display_dev == NULL ||
+	    cfb_get_font_size(display_dev, 0, &font_width, &font_height) != 0 ||
+	    font_width == 0 || font_height == 0) {
+		return -ENODEV;
+	}
+
+	*cols = cfb_get_display_parameter(display_dev, CFB_DISPLAY_WIDTH) / font_width;
+	*rows = cfb_get_display_parameter(display_dev, CFB_DISPLAY_HEIGHT) / font_height;
+
+	return 0;
+}
+
+void display_show_lines(const char *lines, uint16_t count)
+{
+	uint8_t font_width;
+	uint8_t font_height;
+
+	if (cfb_get_font_size(display_dev, 0, &font_width, &font_height) != 0) {
+		return;
+	}
+
 	/* Clear to white and invert for black text */
 	cfb_framebuffer_clear(display_dev, false);
+	display_set_overlay(0, 0, 0, 0, NULL);
+	retained_invalidate();
 
-	/* Get display rows and center text vertically */
-	rows = cfb_get_display_parameter(display_dev, CFB_DISPLAY_ROWS);
-
-	/* Position text in middle of display */
-	cfb_print(display_dev, message, 0, 8);
+	for (uint16_t i = 0; i < count; i++) {
+		cfb_print(display_dev, lines, 0, i * font_height);
+		lines += strlen(lines) + 1;
+	}
 
 	/* Finalize to update display */
-	cfb_framebuffer_finalize(display_dev);
-
-	LOG_INF("Displayed: %s", message);
+	display_flush();
 }
 
 void display_init_sensor_labels(void)
 {
 	/* Clear and setup initial display with icons */
 	cfb_framebuffer_clear(display_dev, false);
+	display_set_overlay(0, 0, 0, 0, NULL);
 
-	/* Draw temp/humidity icon on the left (0, 0) */
-	display_draw_image(icon_thermometer, 0, 7,
+	/* Draw temp/humidity icon on the left */
+	display_draw_image(icon_thermometer, LAYOUT_TEMP_ICON_X, LAYOUT_TEMP_ICON_Y,
 			   ICON_THERMOMETER_WIDTH, ICON_THERMOMETER_HEIGHT);
 
-	/* Draw battery icon on the right corner (250-24=226, 0) */
-	display_draw_image(icon_full_battery, 215, 10,
+	/* Draw battery icon in the top right corner */
+	display_draw_image(icon_full_battery, LAYOUT_BATT_ICON_X, LAYOUT_BATT_ICON_Y,
 			   ICON_FULL_BATTERY_WIDTH, ICON_FULL_BATTERY_HEIGHT);
 
-	cfb_framebuffer_finalize(display_dev);
+	display_flush();
 
 	LOG_INF("Sensor icons initialized");
 }
 
 void display_update_sensors(int16_t temp_celsius, uint16_t humidity_percent)
 {
-	char temp_buf[32];
-	char humid_buf[32];
-
 	/* Add temperature reading to graph history */
 	display_add_temp_reading(temp_celsius);
 
-	/* Clear entire framebuffer to redraw everything fresh */
-	cfb_framebuffer_clear(display_dev, false);
+	draw_dashboard(temp_celsius, humidity_percent);
 
-	/* Redraw icons */
-	display_draw_image(icon_thermometer, 0, 7,
-			   ICON_THERMOMETER_WIDTH, ICON_THERMOMETER_HEIGHT);
-	display_draw_image(icon_full_battery, 215, 10,
-			   ICON_FULL_BATTERY_WIDTH, ICON_FULL_BATTERY_HEIGHT);
+	/* Finalize framebuffer - send everything to display at once */
+	display_flush();
 
-	/* Format temperature and humidity values */
-	snprintf(temp_buf, sizeof(temp_buf), "%d.%02d C",
-		 temp_celsius / 100, abs(temp_celsius % 100));
-	snprintf(humid_buf, sizeof(humid_buf), "%d.%02d %%",
-		 humidity_percent / 100, humidity_percent % 100);
+	retained.temperature = temp_celsius;
+	retained.humidity = humidity_percent;
+	retained_save();
 
-	/* Display values to the right of the temp/humidity icon */
-	cfb_print(display_dev, temp_buf, 70, 20);
-	cfb_print(display_dev, humid_buf, 70, 40);
+	LOG_INF("Updated: Temp=%d.%02d C, Humidity=%d.%02d %%",
+		temp_celsius / 100, abs(temp_celsius % 100),
+		humidity_percent / 100, humidity_percent % 100);
+}
 
-	/* Draw the temperature graph at the bottom */
-	display_draw_graph();
+void display_update_dashboard(int16_t temp_celsius, uint16_t humidity_percent,
+			      uint16_t voltage_mv, uint8_t percentage)
+{
+	display_add_temp_reading(temp_celsius);
 
-	/* Finalize framebuffer - send everything to display at once */
-	cfb_framebuffer_finalize(display_dev);
+	/* One frame, one refresh for the readings and the battery level */
+	draw_dashboard(temp_celsius, humidity_percent);
+	draw_battery(percentage);
+	display_flush();
+
+	retained.temperature = temp_celsius;
+	retained.humidity = humidity_percent;
+	retained.battery_pct = percentage;
+	retained_save();
 
-	LOG_INF("Updated: Temp=%s, Humidity=%s", temp_buf, humid_buf);
+	LOG_INF("Updated: Temp=%d.%02d C, Humidity=%d.%02d %%, Battery=%d%% (%d.%02dV)",
+		temp_celsius / 100, abs(temp_celsius % 100),
+		humidity_percent / 100, humidity_percent % 100,
+		percentage, voltage_mv / 1000, (voltage_mv % 1000) / 10);
 }
 
-void display_update_battery(uint16_t voltage_mv, uint8_t percentage)
+/* Neighbour table layout, one text line per node */
+#define NEIGHBOUR_ROW_HEIGHT LAYOUT_TEXT_ROW
+#define NEIGHBOUR_ROWS MIN(DISPLAY_NEIGHBOURS_MAX, LAYOUT_NEIGHBOUR_ROWS)
+
+void display_update_neighbours(int16_t temp_celsius, uint16_t humidity_percent,
+			       uint8_t battery_pct, const struct neighbour *list, size_t count)
 {
-	char batt_buf[16];
+	char line[32];
+	struct numfmt f;
 
-	/* Format battery percentage only */
-	snprintf(batt_buf, sizeof(batt_buf), "%d%%", percentage);
+	cfb_framebuffer_clear(display_dev, false);
+	display_set_overlay(0, 0, 0, 0, NULL);
+	retained_invalidate();
+
+	/* Own reading first, with the battery level instead of RSSI/age */
+	numfmt_init(&f, line, sizeof(line));
+	numfmt_str(&f, "Here ");
+	numfmt_fixed(&f, temp_celsius, 2, 1);
+	numfmt_str(&f, " C ");
+	numfmt_percent(&f, humidity_percent / 100);
+	numfmt_char(&f, ' ');
+	numfmt_percent(&f, battery_pct);
+	cfb_print(display_dev, line, 0, 0);
+
+	for (size_t i = 0; i < count && i < NEIGHBOUR_ROWS; i++) {
+		const struct neighbour *n = &list[i];
+
+		/* Last two address bytes tell the nodes apart */
+		numfmt_init(&f, line, sizeof(line));
+		numfmt_hex(&f, n->addr.a.val[1], 2);
+		numfmt_hex(&f, n->addr.a.val[0], 2);
+		numfmt_char(&f, ' ');
+		numfmt_fixed(&f, n->temperature, 2, 1);
+		numfmt_str(&f, " C ");
+		numfmt_percent(&f, n->humidity / 100);
+		numfmt_char(&f, ' ');
+		numfmt_int(&f, n->rssi);
+		numfmt_char(&f, ' ');
+		numfmt_uint(&f, n->age_s);
+		numfmt_char(&f, 's');
+		cfb_print(display_dev, line, 0, (i + 1) * NEIGHBOUR_ROW_HEIGHT);
+	}
 
-	/* Display percentage below the battery icon */
-	/* Battery icon is at x=226, 24px wide, text centered below it */
-	cfb_print(display_dev, batt_buf, 170, 15);
+	display_flush();
 
-	cfb_framebuffer_finalize(display_dev);
+	LOG_INF("Updated: %u neighbours", count);
+}
+
+void display_update_battery(uint16_t voltage_mv, uint8_t percentage)
+{
+	draw_battery(percentage);
+
+	display_flush();
+
+	retained.battery_pct = percentage;
+	if (retained.magic == RETAINED_MAGIC) {
+		retained_save();
+	}
 
 	LOG_INF("Updated: Battery=%d%% (%d.%02dV)", percentage,
 		voltage_mv / 1000, (voltage_mv % 1000) / 10);
@@ -226,7 +574,7 @@ int display_set_rotation(enum display_rotation rotation)
 
 	/* Re-initialize CFB after rotation change */
 	cfb_framebuffer_clear(display_dev, false);
-	cfb_framebuffer_finalize(display_dev);
+	display_flush();
 
 	return 0;
 }
@@ -241,7 +589,9 @@ int display_draw_image(const uint8_t *image_data, uint16_t x, uint16_t y,
 		return -EINVAL;
 	}
 
-	LOG_INF("Drawing %dx%d image at (%d,%d)", width, height, x, y);
+	LOG_DBG("Drawing %dx%d image at (%d,%d)", width, height, x, y);
+
+	TRACE_BEGIN(TRACE_SPAN_DRAW_IMAGE, width);
 
 	/* Draw bitmap pixel by pixel using CFB draw_point API */
 	/* cfb_draw_point draws foreground pixels (black after inversion) */
@@ -269,53 +619,59 @@ int display_draw_image(const uint8_t *image_data, uint16_t x, uint16_t y,
 			ret = cfb_draw_point(display_dev, &pos);
 			if (ret != 0) {
 				LOG_ERR("Failed to draw point at (%d,%d): %d", pos.x, pos.y, ret);
+				TRACE_END(TRACE_SPAN_DRAW_IMAGE, width);
 				return ret;
 			}
 		}
 	}
 
-	LOG_INF("Image drawn successfully");
+	TRACE_END(TRACE_SPAN_DRAW_IMAGE, width);
+
+	LOG_DBG("Image drawn successfully");
 	return 0;
 }
 
 void display_add_temp_reading(int16_t temp_celsius)
 {
 	/* Add temperature to circular buffer */
-	temp_history[temp_history_index] = temp_celsius;
-	temp_history_index = (temp_history_index + 1) % GRAPH_MAX_POINTS;
+	retained.history[retained.history_index] = temp_celsius;
+	retained.history_index = (retained.history_index + 1) % GRAPH_MAX_POINTS;
 
-	if (temp_history_count < GRAPH_MAX_POINTS) {
-		temp_history_count++;
+	if (retained.history_count < GRAPH_MAX_POINTS) {
+		retained.history_count++;
 	}
 
 	LOG_DBG("Added temp reading: %d.%02d C (count=%d)",
-		temp_celsius / 100, abs(temp_celsius % 100), temp_history_count);
+		temp_celsius / 100, abs(temp_celsius % 100), retained.history_count);
 }
 
 void display_draw_graph(void)
 {
 	struct cfb_position pos;
 	int ret;
-	char label_buf[16];
+	char label_buf[8];
+	struct numfmt f;
 
-	if (temp_history_count < 2) {
+	if (retained.history_count < 2) {
 		LOG_DBG("Not enough data points to draw graph");
 		return;  /* Need at least 2 points to draw a graph */
 	}
 
+	TRACE_BEGIN(TRACE_SPAN_DRAW_GRAPH, retained.history_count);
+
 	/* Clear the graph area by inverting it twice (or use framebuffer clear for region) */
 	/* Since CFB doesn't have partial clear, we'll just overdraw */
 
 	/* Find min and max temperature for scaling */
-	int16_t min_temp = temp_history[0];
-	int16_t max_temp = temp_history[0];
+	int16_t min_temp = retained.history[0];
+	int16_t max_temp = retained.history[0];
 
-	for (uint8_t i = 0; i < temp_history_count; i++) {
-		if (temp_history[i] < min_temp) {
-			min_temp = temp_history[i];
+	for (uint8_t i = 0; i < retained.history_count; i++) {
+		if (retained.history[i] < min_temp) {
+			min_temp = retained.history[i];
 		}
-		if (temp_history[i] > max_temp) {
-			max_temp = temp_history[i];
+		if (retained.history[i] > max_temp) {
+			max_temp = retained.history[i];
 		}
 	}
 
@@ -334,28 +690,28 @@ void display_draw_graph(void)
 		temp_range = max_temp - min_temp;
 	}
 
-	LOG_INF("Drawing graph: min=%d.%02d, max=%d.%02d, points=%d",
+	LOG_DBG("Drawing graph: min=%d.%02d, max=%d.%02d, points=%d",
 		min_temp / 100, abs(min_temp % 100),
 		max_temp / 100, abs(max_temp % 100),
-		temp_history_count);
+		retained.history_count);
 
 	/* Calculate middle temperature */
 	int16_t mid_temp = (max_temp + min_temp) / 2;
 
 	/* Draw Y-axis labels (temperature values) OUTSIDE the graph box */
 	/* Format and display max temperature at top, left of graph box */
-	snprintf(label_buf, sizeof(label_buf), "%d",
-		max_temp / 100);
+	numfmt_init(&f, label_buf, sizeof(label_buf));
+	numfmt_int(&f, max_temp / 100);
 	cfb_print(display_dev, label_buf, 0, GRAPH_Y + 1);
 
 	/* Format and display min temperature at bottom, left of graph box */
-	snprintf(label_buf, sizeof(label_buf), "%d",
-		min_temp / 100);
+	numfmt_init(&f, label_buf, sizeof(label_buf));
+	numfmt_int(&f, min_temp / 100);
 	cfb_print(display_dev, label_buf, 0, GRAPH_Y + GRAPH_HEIGHT - 9);
 
 	/* Display middle temperature value */
-	snprintf(label_buf, sizeof(label_buf), "%d",
-		mid_temp / 100);
+	numfmt_init(&f, label_buf, sizeof(label_buf));
+	numfmt_int(&f, mid_temp / 100);
 	cfb_print(display_dev, label_buf, 0, GRAPH_Y + GRAPH_HEIGHT / 2 - 4);
 
 	/* Draw graph axes (border) */
@@ -413,19 +769,19 @@ void display_draw_graph(void)
 	}
 
 	/* Draw temperature line graph */
-	uint16_t x_step = (GRAPH_WIDTH - 2) / (temp_history_count - 1);
+	uint16_t x_step = (GRAPH_WIDTH - 2) / (retained.history_count - 1);
 	if (x_step == 0) {
 		x_step = 1;
 	}
 
 	/* Calculate the starting index for oldest data in circular buffer */
 	uint8_t oldest_index = 0;
-	if (temp_history_count >= GRAPH_MAX_POINTS) {
-		/* Buffer is full, oldest data is at temp_history_index */
-		oldest_index = temp_history_index;
+	if (retained.history_count >= GRAPH_MAX_POINTS) {
+		/* Buffer is full, oldest data is at retained.history_index */
+		oldest_index = retained.history_index;
 	}
 
-	for (uint8_t i = 0; i < temp_history_count - 1; i++) {
+	for (uint8_t i = 0; i < retained.history_count - 1; i++) {
 		/* Calculate positions */
 		uint16_t x1 = GRAPH_X + 1 + (i * x_step);
 		uint16_t x2 = GRAPH_X + 1 + ((i + 1) * x_step);
@@ -435,8 +791,8 @@ void display_draw_graph(void)
 		uint8_t idx2 = (oldest_index + i + 1) % GRAPH_MAX_POINTS;
 
 		/* Scale temperature to graph height */
-		int16_t temp1 = temp_history[idx1];
-		int16_t temp2 = temp_history[idx2];
+		int16_t temp1 = retained.history[idx1];
+		int16_t temp2 = retained.history[idx2];
 
 		uint16_t y1 = GRAPH_Y + GRAPH_HEIGHT - 2 -
 			      ((temp1 - min_temp) * (GRAPH_HEIGHT - 4) / temp_range);
@@ -477,5 +833,17 @@ void display_draw_graph(void)
 		}
 	}
 
-	LOG_INF("Graph drawn successfully");
+	TRACE_END(TRACE_SPAN_DRAW_GRAPH, retained.history_count);
+
+	LOG_DBG("Graph drawn successfully");
+}
+
+bool display_is_busy(void)
+{
+	if (busy_gpio.port == NULL) {
+		return false;
+	}
+
+	/* BUSY pin is configured as input by the SSD16xx driver */
+	return gpio_pin_get_dt(&busy_gpio) > 0;
 }
@@ -0,0 +1,93 @@
+#ifndef DISPLAY_LAYOUT_H
+#define DISPLAY_LAYOUT_H
+
+#include <zephyr/devicetree.h>
+#include <zephyr/sys/util.h>
+#include "icons.h"
+
+/**
+ * @brief Dashboard layout, computed at compile time from the devicetree
+ *
+ * The chosen zephyr,display node gives the panel size. Its `rotation`
+ * property (0, 90, 180 or 270) turns it into the logical drawing area.
+ * Bindings without one, such as solomon,ssd1680, get 180 as mounted on
+ * the XIAO. Every region below is a constant expression, so coordinates
+ * fold into the drawing code.
+ *
+ * Only for the display driver: this pulls in the icon bitmaps.
+ *
+ *   +-----------------------------------------------+
+ *   | thermometer  temperature     batt %  [battery] |  top band
+ *   |    icon      humidity                          |
+ *   +----+------------------------------------------+
+ *   | Y  |  temperature graph                       |  graph band
+ *   +----+------------------------------------------+
+ */
+
+#define LAYOUT_NODE DT_CHOSEN(zephyr_display)
+
+/* Panel as wired, in controller coordinates */
+#define LAYOUT_PANEL_WIDTH  DT_PROP(LAYOUT_NODE, width)
+#define LAYOUT_PANEL_HEIGHT DT_PROP(LAYOUT_NODE, height)
+
+#define LAYOUT_ROTATION DT_PROP_OR(LAYOUT_NODE, rotation, 180)
+
+BUILD_ASSERT(LAYOUT_ROTATION == 0 || LAYOUT_ROTATION == 90 ||
+	     LAYOUT_ROTATION == 180 || LAYOUT_ROTATION == 270,
+	     "Display rotation must be 0, 90, 180 or 270");
+
+#define LAYOUT_PORTRAIT (LAYOUT_ROTATION == 90 || LAYOUT_ROTATION == 270)
+
+/* Logical drawing area after rotation */
+#define LAYOUT_WIDTH  (LAYOUT_PORTRAIT ? LAYOUT_PANEL_HEIGHT : LAYOUT_PANEL_WIDTH)
+#define LAYOUT_HEIGHT (LAYOUT_PORTRAIT ? LAYOUT_PANEL_WIDTH : LAYOUT_PANEL_HEIGHT)
+
+/* Text row pitch of the CFB font used for values and tables */
+#define LAYOUT_TEXT_ROW 16
+
+/* Top band: thermometer icon with the two values to its right */
+#define LAYOUT_TOP_HEIGHT       (ICON_THERMOMETER_HEIGHT + 8)
+#define LAYOUT_TEMP_ICON_X      0
+#define LAYOUT_TEMP_ICON_Y      (LAYOUT_TOP_HEIGHT - ICON_THERMOMETER_HEIGHT - 1)
+#define LAYOUT_VALUE_X          (ICON_THERMOMETER_WIDTH + 6)
+#define LAYOUT_TEMP_VALUE_Y     (LAYOUT_TEMP_ICON_Y + 13)
+#define LAYOUT_HUMIDITY_VALUE_Y (LAYOUT_TEMP_VALUE_Y + LAYOUT_TEXT_ROW + 4)
+
+/*
+ * Battery icon in the top right corner. Its percentage ("100%", 40 px)
+ * goes to the left of it, or below it on narrow panels such as 1.54".
+ */
+#define LAYOUT_NARROW       (LAYOUT_WIDTH < 240)
+#define LAYOUT_BATT_ICON_X  (LAYOUT_WIDTH - ICON_FULL_BATTERY_WIDTH - 11)
+#define LAYOUT_BATT_ICON_Y  10
+#define LAYOUT_BATT_TEXT_X  (LAYOUT_NARROW ? LAYOUT_WIDTH - 40 : LAYOUT_BATT_ICON_X - 45)
+#define LAYOUT_BATT_TEXT_Y  (LAYOUT_NARROW ? \
+			     LAYOUT_BATT_ICON_Y + ICON_FULL_BATTERY_HEIGHT + 2 : 15)
+
+/* Graph band: Y axis labels, then the plot, in whole text rows */
+#define LAYOUT_GRAPH_LABEL_WIDTH 24
+#define LAYOUT_GRAPH_X      LAYOUT_GRAPH_LABEL_WIDTH
+#define LAYOUT_GRAPH_Y      LAYOUT_TOP_HEIGHT
+#define LAYOUT_GRAPH_WIDTH  (LAYOUT_WIDTH - LAYOUT_GRAPH_X)
+#define LAYOUT_GRAPH_HEIGHT ROUND_DOWN(LAYOUT_HEIGHT - LAYOUT_GRAPH_Y, LAYOUT_TEXT_ROW)
+
+/* Values are up to 8 characters ("-12.34 C") of 10 px */
+BUILD_ASSERT(LAYOUT_VALUE_X + 80 <= MIN(LAYOUT_BATT_ICON_X, LAYOUT_BATT_TEXT_X),
+	     "Panel too narrow for the dashboard");
+BUILD_ASSERT(LAYOUT_HEIGHT >= LAYOUT_GRAPH_Y + LAYOUT_TEXT_ROW,
+	     "Panel too low for the dashboard graph");
+
+/*
+ * Boot logo, centred horizontally, 5 px from the top as it always was.
+ * Panels lower than 133 rows move it up and clip its bottom rows.
+ */
+#define LAYOUT_LOGO_X MAX((LAYOUT_WIDTH - ICON_BLEINK_LOGO_WIDTH) / 2, 0)
+#define LAYOUT_LOGO_Y MIN(5, MAX(LAYOUT_HEIGHT - ICON_BLEINK_LOGO_HEIGHT, 0))
+#define LAYOUT_LOGO_HEIGHT MIN(ICON_BLEINK_LOGO_HEIGHT, LAYOUT_HEIGHT - LAYOUT_LOGO_Y)
+
+BUILD_ASSERT(LAYOUT_WIDTH >= ICON_BLEINK_LOGO_WIDTH, "Panel too narrow for the boot logo");
+
+/* Neighbour table: one text row per node below the own reading */
+#define LAYOUT_NEIGHBOUR_ROWS (LAYOUT_HEIGHT / LAYOUT_TEXT_ROW - 1)
+
+#endif /* DISPLAY_LAYOUT_H */
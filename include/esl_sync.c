@@ -0,0 +1,441 @@
+#include "esl_sync.h"
+#include "display_epaper.h"
+#include "image_upload.h"
+#include "led_effects.h"
+#include "workqueues.h"
+#include "numfmt.h"
+#include <zephyr/bluetooth/bluetooth.h>
+#include <zephyr/bluetooth/gap.h>
+#include <zephyr/bluetooth/uuid.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/logging/log.h>
+#include <string.h>
+
+LOG_MODULE_REGISTER(esl_sync, CONFIG_APP_ESL_LOG_LEVEL);
+
+/* Scan timing in 0.625 ms units */
+#define SCAN_INTERVAL (CONFIG_APP_ESL_SCAN_INTERVAL_MS * 8 / 5)
+#define SCAN_WINDOW   (CONFIG_APP_ESL_SCAN_WINDOW_MS * 8 / 5)
+
+BUILD_ASSERT(CONFIG_APP_ESL_SCAN_WINDOW_MS <= CONFIG_APP_ESL_SCAN_INTERVAL_MS,
+	     "Scan window must not exceed the scan interval");
+
+#ifndef BT_DATA_ESL
+#define BT_DATA_ESL 0x34  /* Electronic Shelf Label AD type */
+#endif
+
+/* ESL Service UUID, advertised by the access point next to its periodic train */
+#define ESL_SERVICE_UUID_VAL 0x184D
+
+#define ESL_CMD_HDR_LEN 4
+#define ESL_CMD_MAX_DATA 244
+#define ESL_MAX_VALUES 4
+
+/* Sync timeout in 10 ms units */
+#define ESL_SYNC_TIMEOUT 500
+
+struct esl_cmd {
+	uint8_t opcode;
+	uint8_t seq;
+	uint8_t len;
+	uint8_t data[ESL_CMD_MAX_DATA];
+};
+
+K_MSGQ_DEFINE(esl_cmd_q, sizeof(struct esl_cmd), CONFIG_APP_ESL_QUEUE_DEPTH, 4);
+
+static struct bt_le_per_adv_sync *esl_sync;
+static bool sync_pending;
+
+/* Supported opcodes, their index keys the duplicate check */
+static const uint8_t esl_opcodes[] = {
+	ESL_OP_TEXT,
+	ESL_OP_VALUES,
+	ESL_OP_LED,
+	ESL_OP_IMAGE_BEGIN,
+	ESL_OP_IMAGE_DATA,
+	ESL_OP_IMAGE_COMMIT,
+};
+
+/* Last sequence number applied, per addressing (own id, broadcast) and opcode */
+static int16_t last_seq[2][ARRAY_SIZE(esl_opcodes)];
+
+/* Acknowledgements collected while parsing one periodic event */
+struct esl_ack_list {
+	uint8_t count;
+	uint8_t entries[8][3]; /* opcode, seq, status */
+};
+
+static void show_values(const uint8_t *data, uint8_t len)
+{
+	char message[ESL_MAX_VALUES * 16];
+	struct numfmt f;
+	uint8_t count;
+
+	if (len < 1) {
+		return;
+	}
+
+	count = MIN(data[0], ESL_MAX_VALUES);
+	if (len < 1 + count * 4) {
+		return;
+	}
+
+	numfmt_init(&f, message, sizeof(message));
+	for (uint8_t i = 0; i < count; i++) {
+		numfmt_fixed(&f, (int32_t)sys_get_le32(&data[1 + i * 4]), 2, 2);
+		numfmt_char(&f, '\n');
+	}
+
+	display_show_message(message);
+}
+
+static void apply_cmd(const struct esl_cmd *cmd)
+{
+	struct led_pattern pattern;
+	char text[ESL_CMD_MAX_DATA + 1];
+	int ret = 0;
+
+	switch (cmd->opcode) {
+	case ESL_OP_TEXT:
+		memcpy(text, cmd->data, cmd->len);
+		text[cmd->len] = '\0';
+		display_show_message(text);
+		break;
+	case ESL_OP_VALUES:
+		show_values(cmd->data, cmd->len);
+		break;
+	case ESL_OP_LED:
+		ret = led_pattern_decode(cmd->data, cmd->len, &pattern);
+		if (ret == 0) {
+			ret = led_effects_play(&pattern);
+		}
+		break;
+	case ESL_OP_IMAGE_BEGIN:
+		if (cmd->len != 9) {
+			ret = -EINVAL;
+			break;
+		}
+		ret = image_upload_begin(sys_get_le16(&cmd->data[0]), sys_get_le16(&cmd->data[2]),
+					 sys_get_le16(&cmd->data[4]), sys_get_le16(&cmd->data[6]),
+					 cmd->data[8]);
+		break;
+	case ESL_OP_IMAGE_DATA:
+		ret = image_upload_data(cmd->data, cmd->len);
+		break;
+	case ESL_OP_IMAGE_COMMIT:
+		ret = image_upload_commit();
+		break;
+	default:
+		break;
+	}
+
+	if (ret != 0) {
+		LOG_WRN("Command 0x%02x (seq %u) failed: %d", cmd->opcode, cmd->seq, ret);
+	} else {
+		LOG_DBG("Applied command 0x%02x (seq %u)", cmd->opcode, cmd->seq);
+	}
+}
+
+static struct wq_stamp esl_apply_stamp;
+
+static void esl_apply_handler(struct k_work *work)
+{
+	struct esl_cmd cmd;
+
+	wq_started(WQ_DISPLAY, &esl_apply_stamp);
+
+	while (k_msgq_get(&esl_cmd_q, &cmd, K_NO_WAIT) == 0) {
+		apply_cmd(&cmd);
+	}
+}
+
+static K_WORK_DEFINE(esl_apply_work, esl_apply_handler);
+
+/* Index into esl_opcodes, -1 if the opcode is not supported */
+static int opcode_index(uint8_t opcode)
+{
+	for (int i = 0; i < ARRAY_SIZE(esl_opcodes); i++) {
+		if (esl_opcodes[i] == opcode) {
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+/*
+ * Queue one command, runs in the Bluetooth RX context so applying it is
+ * left to the display work queue. The access point repeats a command over
+ * several periodic events: a repeat of the last sequence number for the
+ * same opcode and addressing is acknowledged again but not applied twice.
+ * Broadcast and addressed commands, or different opcodes, may share a
+ * sequence number.
+ */
+static uint8_t queue_cmd(bool broadcast, uint8_t opcode, uint8_t seq, const uint8_t *data,
+			 uint8_t len)
+{
+	int16_t *last;
+	struct esl_cmd cmd;
+	int index = opcode_index(opcode);
+
+	if (index < 0) {
+		return ESL_STATUS_UNSUPPORTED;
+	}
+
+	if (len > ESL_CMD_MAX_DATA) {
+		return ESL_STATUS_INVALID;
+	}
+
+	last = &last_seq[broadcast ? 1 : 0][index];
+	if (seq == *last) {
+		return ESL_STATUS_OK;
+	}
+
+	cmd.opcode = opcode;
+	cmd.seq = seq;
+	cmd.len = len;
+	memcpy(cmd.data, data, len);
+
+	if (k_msgq_put(&esl_cmd_q, &cmd, K_NO_WAIT) != 0) {
+		return ESL_STATUS_QUEUE_FULL;
+	}
+
+	*last = seq;
+	wq_submit(WQ_DISPLAY, &esl_apply_work, &esl_apply_stamp);
+
+	return ESL_STATUS_OK;
+}
+
+static void parse_cmds(const uint8_t *data, size_t len, struct esl_ack_list *acks)
+{
+	while (len >= ESL_CMD_HDR_LEN) {
+		uint8_t esl_id = data[0];
+		uint8_t opcode = data[1];
+		uint8_t seq = data[2];
+		uint8_t cmd_len = data[3];
+
+		if (len < ESL_CMD_HDR_LEN + cmd_len) {
+			LOG_WRN("Truncated command 0x%02x", opcode);
+			return;
+		}
+
+		if (esl_id == CONFIG_APP_ESL_ID || esl_id == ESL_ID_BROADCAST) {
+			uint8_t status = queue_cmd(esl_id == ESL_ID_BROADCAST, opcode, seq,
+						   &data[ESL_CMD_HDR_LEN], cmd_len);
+
+			/* Broadcasts are not acknowledged, every node would answer */
+			if (esl_id != ESL_ID_BROADCAST && acks->count < ARRAY_SIZE(acks->entries)) {
+				acks->entries[acks->count][0] = opcode;
+				acks->entries[acks->count][1] = seq;
+				acks->entries[acks->count][2] = status;
+				acks->count++;
+			}
+		}
+
+		data += ESL_CMD_HDR_LEN + cmd_len;
+		len -= ESL_CMD_HDR_LEN + cmd_len;
+	}
+}
+
+static bool parse_ad(struct bt_data *ad, void *user_data)
+{
+	if (ad->type == BT_DATA_ESL) {
+		parse_cmds(ad->data, ad->data_len, user_data);
+	}
+
+	return true;
+}
+
+#if defined(CONFIG_BT_PER_ADV_SYNC_RSP)
+/* Answer in our response slot of the subevent the commands came in */
+static void send_acks(struct bt_le_per_adv_sync *sync,
+		      const struct bt_le_per_adv_sync_recv_info *info,
+		      const struct esl_ack_list *acks)
+{
+	NET_BUF_SIMPLE_DEFINE(rsp, 2 + 1 + sizeof(acks->entries));
+	struct bt_le_per_adv_response_params params = {
+		.request_event = info->periodic_event_counter,
+		.request_subevent = info->subevent,
+		.response_subevent = info->subevent,
+		.response_slot = CONFIG_APP_ESL_ID,
+	};
+	int err;
+
+	net_buf_simple_add_u8(&rsp, 2 + acks->count * 3);
+	net_buf_simple_add_u8(&rsp, BT_DATA_ESL);
+	net_buf_simple_add_u8(&rsp, CONFIG_APP_ESL_ID);
+	net_buf_simple_add_mem(&rsp, acks->entries, acks->count * 3);
+
+	err = bt_le_per_adv_set_response_data(sync, &params, &rsp);
+	if (err) {
+		LOG_WRN("Response data failed (err %d)", err);
+	}
+}
+#endif /* CONFIG_BT_PER_ADV_SYNC_RSP */
+
+static void sync_recv(struct bt_le_per_adv_sync *sync,
+		      const struct bt_le_per_adv_sync_recv_info *info,
+		      struct net_buf_simple *buf)
+{
+	struct esl_ack_list acks = {
+		.count = 0,
+	};
+
+	if (buf == NULL || buf->len == 0) {
+		return;
+	}
+
+	bt_data_parse(buf, parse_ad, &acks);
+
+#if defined(CONFIG_BT_PER_ADV_SYNC_RSP)
+	if (acks.count > 0) {
+		send_acks(sync, info, &acks);
+	}
+#endif
+}
+
+static void sync_synced(struct bt_le_per_adv_sync *sync,
+			struct bt_le_per_adv_sync_synced_info *info)
+{
+	sync_pending = false;
+
+	/* Periodic interval is in 1.25 ms units */
+	LOG_INF("Synced to ESL train, interval %u ms", info->interval * 5 / 4);
+
+	/* The neighbour scanner keeps the scan running */
+	if (!IS_ENABLED(CONFIG_APP_NEIGHBOURS)) {
+		bt_le_scan_stop();
+	}
+
+#if defined(CONFIG_BT_PER_ADV_SYNC_RSP)
+	if (info->num_subevents > 0) {
+		uint8_t subevent = CONFIG_APP_ESL_GROUP;
+		struct bt_le_per_adv_sync_subevent_params params = {
+			.properties = 0,
+			.num_subevents = 1,
+			.subevents = &subevent,
+		};
+		int err;
+
+		/* Only wake up for our group's subevent */
+		err = bt_le_per_adv_sync_subevent(sync, &params);
+		if (err) {
+			LOG_ERR("Subevent select failed (err %d)", err);
+		}
+	}
+#endif
+}
+
+/* Passive scan for the access point, already running when shared */
+static int scan_start(void)
+{
+	struct bt_le_scan_param param = {
+		.type = BT_LE_SCAN_TYPE_PASSIVE,
+		.options = BT_LE_SCAN_OPT_NONE,
+		.interval = SCAN_INTERVAL,
+		.window = SCAN_WINDOW,
+	};
+	int err = bt_le_scan_start(&param, NULL);
+
+	return (err == -EALREADY) ? 0 : err;
+}
+
+static void sync_term(struct bt_le_per_adv_sync *sync,
+		      const struct bt_le_per_adv_sync_term_info *info)
+{
+	int err;
+
+	LOG_WRN("ESL sync lost (reason 0x%02x), scanning again", info->reason);
+
+	esl_sync = NULL;
+	sync_pending = false;
+
+	err = scan_start();
+	if (err) {
+		LOG_ERR("Scan restart failed (err %d)", err);
+	}
+}
+
+static struct bt_le_per_adv_sync_cb sync_callbacks = {
+	.synced = sync_synced,
+	.term = sync_term,
+	.recv = sync_recv,
+};
+
+static bool find_esl_uuid(struct bt_data *ad, void *user_data)
+{
+	bool *found = user_data;
+
+	if (ad->type != BT_DATA_UUID16_ALL && ad->type != BT_DATA_UUID16_SOME) {
+		return true;
+	}
+
+	for (size_t i = 0; i + 1 < ad->data_len; i += 2) {
+		if (sys_get_le16(&ad->data[i]) == ESL_SERVICE_UUID_VAL) {
+			*found = true;
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static void scan_recv(const struct bt_le_scan_recv_info *info, struct net_buf_simple *buf)
+{
+	struct bt_le_per_adv_sync_param param;
+	bool found = false;
+	int err;
+
+	/* Only extended advertisers with a periodic train are of interest */
+	if (info->interval == 0 || sync_pending || esl_sync != NULL) {
+		return;
+	}
+
+	bt_data_parse(buf, find_esl_uuid, &found);
+	if (!found) {
+		return;
+	}
+
+	bt_addr_le_copy(&param.addr, info->addr);
+	param.sid = info->sid;
+	param.options = 0;
+	param.skip = 0;
+	param.timeout = ESL_SYNC_TIMEOUT;
+
+	err = bt_le_per_adv_sync_create(&param, &esl_sync);
+	if (err) {
+		LOG_ERR("Sync create failed (err %d)", err);
+		return;
+	}
+
+	sync_pending = true;
+}
+
+static struct bt_le_scan_cb scan_callbacks = {
+	.recv = scan_recv,
+};
+
+int esl_sync_init(void)
+{
+	int err;
+
+	for (int i = 0; i < ARRAY_SIZE(last_seq); i++) {
+		for (int j = 0; j < ARRAY_SIZE(last_seq[i]); j++) {
+			last_seq[i][j] = -1;
+		}
+	}
+
+	bt_le_per_adv_sync_cb_register(&sync_callbacks);
+	bt_le_scan_cb_register(&scan_callbacks);
+
+	/* Already running when the neighbour scanner started first */
+	err = scan_start();
+	if (err) {
+		LOG_ERR("Scan start failed (err %d)", err);
+		return err;
+	}
+
+	LOG_INF("Looking for ESL train (group %d, id %d, scan %u/%u ms)", CONFIG_APP_ESL_GROUP,
+		CONFIG_APP_ESL_ID, CONFIG_APP_ESL_SCAN_WINDOW_MS, CONFIG_APP_ESL_SCAN_INTERVAL_MS);
+	return 0;
+}
@@ -0,0 +1,51 @@
+#ifndef ESL_SYNC_H
+#define ESL_SYNC_H
+
+#include <zephyr/kernel.h>
+
+/**
+ * @brief Shelf label commands carried in periodic advertising
+ *
+ * Each command is encoded as: esl_id u8, opcode u8, seq u8, len u8,
+ * data[len]. Values are part of the over-the-air format, append only.
+ */
+enum esl_opcode {
+	ESL_OP_TEXT = 0x01,         /* UTF-8 text for the panel */
+	ESL_OP_VALUES = 0x02,       /* count u8, then count x int32 LE (value * 100) */
+	ESL_OP_LED = 0x03,          /* LED pattern descriptor (led_effects.h) */
+	ESL_OP_IMAGE_BEGIN = 0x11,  /* Image upload commands (image_upload.h) */
+	ESL_OP_IMAGE_DATA = 0x12,
+	ESL_OP_IMAGE_COMMIT = 0x13,
+};
+
+/**
+ * @brief Acknowledgement status sent in the response slot
+ */
+enum esl_status {
+	ESL_STATUS_OK = 0x00,
+	ESL_STATUS_QUEUE_FULL = 0x01,
+	ESL_STATUS_UNSUPPORTED = 0x02,
+	ESL_STATUS_INVALID = 0x03,
+};
+
+/* Address reaching every node of the group */
+#define ESL_ID_BROADCAST 0xFF
+
+#if defined(CONFIG_APP_ESL)
+
+/**
+ * @brief Start looking for the shelf label periodic advertising train
+ *
+ * Must be called after bt_enable().
+ *
+ * @return 0 on success, negative errno on failure
+ */
+int esl_sync_init(void);
+
+#else
+
+static inline int esl_sync_init(void) { return 0; }
+
+#endif /* CONFIG_APP_ESL */
+
+#endif /* ESL_SYNC_H */
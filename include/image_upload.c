@@ -0,0 +1,229 @@
+#include "image_upload.h"
+#include "display_epaper.h"
+#include "diagnostics.h"
+#include "workqueues.h"
+#include <zephyr/devicetree.h>
+#include <zephyr/logging/log.h>
+#include <string.h>
+
+LOG_MODULE_REGISTER(image_upload, CONFIG_APP_IMAGE_UPLOAD_LOG_LEVEL);
+
+#define PANEL_NODE   DT_CHOSEN(zephyr_display)
+#define PANEL_WIDTH  DT_PROP(PANEL_NODE, width)
+#define PANEL_HEIGHT DT_PROP(PANEL_NODE, height)
+
+/* Region buffer, capped by Kconfig, never larger than a full frame */
+#define REGION_MAX_BYTES MIN(CONFIG_APP_IMAGE_UPLOAD_MAX_BYTES, \
+			     PANEL_WIDTH * (PANEL_HEIGHT / 8))
+
+static uint8_t region_buf[REGION_MAX_BYTES];
+
+/*
+ * A mutex so BEGIN and the commit can change the display overlay while
+ * holding it, all callers run in thread context.
+ */
+static K_MUTEX_DEFINE(upload_lock);
+static enum image_upload_state state;
+static uint8_t encoding;
+static uint16_t region_x, region_y, region_w, region_h;
+static uint16_t expected;
+static uint16_t received;
+static int64_t begin_ms;
+static uint32_t elapsed_ms;
+
+/* PackBits decoder state, carried across chunks */
+static uint8_t run_header; /* 0 when the next byte is a header */
+static bool run_repeat;
+
+static struct wq_stamp commit_stamp;
+
+static void commit_handler(struct k_work *work)
+{
+	uint16_t x, y, w, h;
+	int ret;
+
+	wq_started(WQ_DISPLAY, &commit_stamp);
+
+	/* BEGIN is refused while committing, so the region cannot change */
+	k_mutex_lock(&upload_lock, K_FOREVER);
+	x = region_x;
+	y = region_y;
+	w = region_w;
+	h = region_h;
+	k_mutex_unlock(&upload_lock);
+
+	ret = display_write_region(x, y, w, h, region_buf);
+
+	k_mutex_lock(&upload_lock, K_FOREVER);
+
+	/*
+	 * Keep the image when the battery level is flushed next. Set while
+	 * still committing, a BEGIN after this point removes it again.
+	 */
+	if (ret == 0) {
+		display_set_overlay(x, y, w, h, region_buf);
+	}
+
+	elapsed_ms = (uint32_t)(k_uptime_get() - begin_ms);
+	state = (ret == 0) ? IMAGE_UPLOAD_IDLE : IMAGE_UPLOAD_ERROR;
+
+	k_mutex_unlock(&upload_lock);
+
+	if (ret != 0) {
+		LOG_ERR("Region refresh failed: %d", ret);
+		return;
+	}
+
+	LOG_INF("Region %ux%u at (%u,%u) shown after %u ms", w, h, x, y, elapsed_ms);
+}
+
+static K_WORK_DEFINE(commit_work, commit_handler);
+
+int image_upload_init(void)
+{
+	diag_register_buffer("upload.region", sizeof(region_buf));
+	return 0;
+}
+
+int image_upload_begin(uint16_t x, uint16_t y, uint16_t width, uint16_t height,
+		       uint8_t enc)
+{
+	if (width == 0 || height == 0 || (y % 8) != 0 || (height % 8) != 0 ||
+	    x + width > PANEL_WIDTH || y + height > PANEL_HEIGHT ||
+	    enc > IMAGE_UPLOAD_PACKBITS) {
+		return -EINVAL;
+	}
+
+	if (width * height / 8 > sizeof(region_buf)) {
+		return -ENOMEM;
+	}
+
+	k_mutex_lock(&upload_lock, K_FOREVER);
+
+	if (state == IMAGE_UPLOAD_COMMITTING) {
+		k_mutex_unlock(&upload_lock);
+		return -EBUSY;
+	}
+
+	/* The new image decodes into the buffer the overlay points at */
+	display_set_overlay(0, 0, 0, 0, NULL);
+
+	region_x = x;
+	region_y = y;
+	region_w = width;
+	region_h = height;
+	encoding = enc;
+	expected = width * height / 8;
+	received = 0;
+	run_header = 0;
+	begin_ms = k_uptime_get();
+	elapsed_ms = 0;
+	state = IMAGE_UPLOAD_RECEIVING;
+
+	k_mutex_unlock(&upload_lock);
+
+	LOG_DBG("Upload %ux%u at (%u,%u), %u bytes", width, height, x, y, expected);
+	return 0;
+}
+
+/*
+ * PackBits: header n < 128 copies n + 1 literal bytes, n > 128 repeats
+ * the next byte 257 - n times, 128 is a no-op. Caller holds upload_lock.
+ */
+static int decode_packbits(const uint8_t *data, size_t len)
+{
+	for (size_t i = 0; i < len; i++) {
+		uint8_t byte = data[i];
+
+		if (run_header == 0) {
+			if (byte < 128) {
+				run_header = byte + 1;
+				run_repeat = false;
+			} else if (byte > 128) {
+				run_header = 257 - byte;
+				run_repeat = true;
+			}
+			continue;
+		}
+
+		if (run_repeat) {
+			if (received + run_header > expected) {
+				return -EINVAL;
+			}
+			memset(&region_buf[received], byte, run_header);
+			received += run_header;
+			run_header = 0;
+		} else {
+			if (received >= expected) {
+				return -EINVAL;
+			}
+			region_buf[received++] = byte;
+			run_header--;
+		}
+	}
+
+	return 0;
+}
+
+int image_upload_data(const uint8_t *data, size_t len)
+{
+	int ret = 0;
+
+	k_mutex_lock(&upload_lock, K_FOREVER);
+
+	if (state != IMAGE_UPLOAD_RECEIVING) {
+		k_mutex_unlock(&upload_lock);
+		return -EINVAL;
+	}
+
+	if (encoding == IMAGE_UPLOAD_PACKBITS) {
+		ret = decode_packbits(data, len);
+	} else if (received + len > expected) {
+		ret = -EINVAL;
+	} else {
+		memcpy(&region_buf[received], data, len);
+		received += len;
+	}
+
+	if (ret != 0) {
+		state = IMAGE_UPLOAD_ERROR;
+	}
+	elapsed_ms = (uint32_t)(k_uptime_get() - begin_ms);
+
+	k_mutex_unlock(&upload_lock);
+
+	if (ret != 0) {
+		LOG_WRN("Upload overflows the %u byte region", expected);
+	}
+
+	return ret;
+}
+
+int image_upload_commit(void)
+{
+	k_mutex_lock(&upload_lock, K_FOREVER);
+
+	if (state != IMAGE_UPLOAD_RECEIVING || received != expected) {
+		k_mutex_unlock(&upload_lock);
+		return -EINVAL;
+	}
+
+	state = IMAGE_UPLOAD_COMMITTING;
+
+	k_mutex_unlock(&upload_lock);
+
+	wq_submit(WQ_DISPLAY, &commit_work, &commit_stamp);
+	return 0;
+}
+
+void image_upload_get_status(struct image_upload_status *out)
+{
+	k_mutex_lock(&upload_lock, K_FOREVER);
+
+	out->state = state;
+	out->received = received;
+	out->expected = expected;
+	out->elapsed_ms = elapsed_ms;
+
+	k_mutex_unlock(&upload_lock);
+}
@@ -0,0 +1,96 @@
+#ifndef IMAGE_UPLOAD_H
+#define IMAGE_UPLOAD_H
+
+#include <zephyr/kernel.h>
+
+/**
+ * @brief Image upload commands (first byte of every write)
+ *
+ * BEGIN:  x u16, y u16, width u16, height u16, encoding u8 (little endian)
+ * DATA:   region bytes in panel layout, raw or PackBits compressed
+ * COMMIT: no payload, refreshes the region once all bytes arrived
+ */
+enum image_upload_cmd {
+	IMAGE_UPLOAD_BEGIN = 0x01,
+	IMAGE_UPLOAD_DATA = 0x02,
+	IMAGE_UPLOAD_COMMIT = 0x03,
+};
+
+/**
+ * @brief Encoding of the DATA payload
+ */
+enum image_upload_encoding {
+	IMAGE_UPLOAD_RAW = 0,
+	IMAGE_UPLOAD_PACKBITS = 1,
+};
+
+/**
+ * @brief Upload state
+ */
+enum image_upload_state {
+	IMAGE_UPLOAD_IDLE = 0,
+	IMAGE_UPLOAD_RECEIVING,
+	IMAGE_UPLOAD_COMMITTING,
+	IMAGE_UPLOAD_ERROR,
+};
+
+/**
+ * @brief Upload progress snapshot
+ */
+struct image_upload_status {
+	uint8_t state;       /* enum image_upload_state */
+	uint16_t received;   /* Decoded region bytes */
+	uint16_t expected;   /* Region size in bytes */
+	uint32_t elapsed_ms; /* BEGIN to last DATA, or to refresh done */
+};
+
+/**
+ * @brief Initialize image uploads
+ *
+ * @return 0 on success, negative errno on failure
+ */
+int image_upload_init(void);
+
+/**
+ * @brief Start an upload
+ *
+ * @param x Region X coordinate
+ * @param y Region Y coordinate (multiple of 8)
+ * @param width Region width in pixels
+ * @param height Region height in pixels (multiple of 8), y + height must
+ *               not pass the panel height
+ * @param encoding enum image_upload_encoding
+ * @return 0 on success, -EINVAL for a bad region, -ENOMEM for a region
+ *         over CONFIG_APP_IMAGE_UPLOAD_MAX_BYTES, -EBUSY while committing
+ */
+int image_upload_begin(uint16_t x, uint16_t y, uint16_t width, uint16_t height,
+		       uint8_t encoding);
+
+/**
+ * @brief Decode a chunk into the region buffer
+ *
+ * Chunks may split compressed runs at any byte.
+ *
+ * @param data Chunk payload
+ * @param len Length of @p data
+ * @return 0 on success, -EINVAL if the data overflows the region
+ */
+int image_upload_data(const uint8_t *data, size_t len);
+
+/**
+ * @brief Refresh the uploaded region on the panel
+ *
+ * The refresh runs on the display work queue (WQ_DISPLAY).
+ *
+ * @return 0 on success, -EINVAL if the region is incomplete
+ */
+int image_upload_commit(void);
+
+/**
+ * @brief Get upload progress
+ *
+ * @param out Snapshot to fill
+ */
+void image_upload_get_status(struct image_upload_status *out);
+
+#endif /* IMAGE_UPLOAD_H */
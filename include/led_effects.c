@@ -0,0 +1,719 @@
+#include "led_effects.h"
+#include <zephyr/devicetree.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/util.h>
+#include <zephyr/logging/log.h>
+#include <string.h>
+#if defined(CONFIG_APP_LED_EFFECTS_NRF_PWM)
+#include <nrfx_pwm.h>
+#include <zephyr/drivers/pinctrl.h>
+#include <zephyr/irq.h>
+#else
+#include <zephyr/drivers/pwm.h>
+#endif
+
+LOG_MODULE_REGISTER(led_effects, CONFIG_APP_LED_EFFECTS_LOG_LEVEL);
+
+#define LED_RED_NODE   DT_NODELABEL(red_pwm_led)
+#define LED_GREEN_NODE DT_NODELABEL(green_pwm_led)
+#define LED_BLUE_NODE  DT_NODELABEL(blue_pwm_led)
+
+#if !DT_NODE_EXISTS(LED_RED_NODE)
+#error "PWM LED nodes not found in device tree"
+#endif
+
+/* PWM period shared by all three channels, counted at 125 kHz (8 us) */
+#define LED_PERIOD_NS    DT_PWMS_PERIOD(LED_RED_NODE)
+#define LED_PERIOD_MS    (LED_PERIOD_NS / NSEC_PER_MSEC)
+#define LED_TOP          (LED_PERIOD_NS / 8000)
+
+BUILD_ASSERT(LED_TOP > 0 && LED_TOP < BIT(15), "PWM period out of range for 125 kHz clock");
+BUILD_ASSERT(LED_PERIOD_MS > 0, "PWM period shorter than 1 ms");
+
+/* Frames per ramp of FADE and BREATHE, bounds the sequence buffer size */
+#define LED_RAMP_STEPS   32
+#define LED_MAX_STEPS    (2 * LED_RAMP_STEPS)
+
+/*
+ * Perceptual brightness table, 0-255 to PWM counts. Blend of a square
+ * and a cube curve (roughly gamma 2.4), evaluated at compile time.
+ */
+#define GAMMA(v) ((uint16_t)(((3ULL * (v) * (v) * 255 + 2ULL * (v) * (v) * (v)) * LED_TOP) / \
+			     (5ULL * 255 * 255 * 255)))
+#define GAMMA_ENTRY(v, _) GAMMA(v)
+
+static const uint16_t gamma_lut[256] = {
+	LISTIFY(256, GAMMA_ENTRY, (,))
+};
+
+BUILD_ASSERT(GAMMA(0) == 0 && GAMMA(255) == LED_TOP, "Gamma table must span the full duty range");
+
+/* Playback plan of a pattern */
+struct led_plan {
+	uint16_t steps;         /* Frames in one cycle */
+	uint16_t step_periods;  /* PWM periods each frame is held */
+	uint8_t repeat;         /* Cycles to play, 0 = forever */
+	uint8_t end[3];         /* Colour held once a finite pattern ends */
+};
+
+static const struct led_pattern status_patterns[] = {
+	[LED_STATUS_OFF] = {
+		.type = LED_PATTERN_STATIC,
+	},
+	[LED_STATUS_BOOT] = {
+		.type = LED_PATTERN_BREATHE,
+		.from = {255, 255, 0},
+		.to = {16, 16, 0},
+		.period_ms = 1200,
+	},
+	[LED_STATUS_OK] = {
+		/* Green for 3 s, then off */
+		.type = LED_PATTERN_BLINK,
+		.from = {0, 255, 0},
+		.period_ms = 6000,
+		.repeat = 1,
+	},
+	[LED_STATUS_ERROR] = {
+		.type = LED_PATTERN_BLINK,
+		.from = {255, 0, 0},
+		.period_ms = 400,
+	},
+	[LED_STATUS_CONNECTED] = {
+		.type = LED_PATTERN_FADE,
+		.from = {0, 0, 255},
+		.period_ms = 1000,
+		.repeat = 1,
+	},
+};
+
+static void plan_pattern(const struct led_pattern *pattern, struct led_plan *plan)
+{
+	uint32_t periods = MAX(1, pattern->period_ms / LED_PERIOD_MS);
+
+	switch (pattern->type) {
+	case LED_PATTERN_FADE:
+		plan->steps = CLAMP(periods, 2, LED_RAMP_STEPS);
+		break;
+	case LED_PATTERN_BREATHE:
+		plan->steps = 2 * CLAMP(periods / 2, 1, LED_RAMP_STEPS);
+		break;
+	case LED_PATTERN_BLINK:
+		plan->steps = 2;
+		break;
+	default:
+		plan->steps = 1;
+		break;
+	}
+
+	plan->step_periods = MAX(1, periods / plan->steps);
+	plan->repeat = (pattern->type == LED_PATTERN_STATIC) ? 0 : pattern->repeat;
+
+	if (pattern->type == LED_PATTERN_FADE) {
+		memcpy(plan->end, pattern->to, sizeof(plan->end));
+	} else {
+		memset(plan->end, 0, sizeof(plan->end));
+	}
+}
+
+/* PWM counts of frame 'index' of a planned pattern */
+static void pattern_frame(const struct led_pattern *pattern, const struct led_plan *plan,
+			  uint16_t index, uint16_t level[3])
+{
+	uint16_t half = plan->steps / 2;
+	uint32_t t;
+
+	switch (pattern->type) {
+	case LED_PATTERN_FADE:
+		t = (index * 255U) / (plan->steps - 1);
+		break;
+	case LED_PATTERN_BREATHE:
+		t = ((index <= half ? index : plan->steps - index) * 255U) / half;
+		break;
+	case LED_PATTERN_BLINK:
+		t = index ? 255 : 0;
+		break;
+	default:
+		t = 0;
+		break;
+	}
+
+	for (int i = 0; i < 3; i++) {
+		int32_t delta = (int32_t)pattern->to[i] - pattern->from[i];
+
+		level[i] = gamma_lut[pattern->from[i] + (delta * (int32_t)t) / 255];
+	}
+}
+
+static void color_level(const uint8_t color[3], uint16_t level[3])
+{
+	for (int i = 0; i < 3; i++) {
+		level[i] = gamma_lut[color[i]];
+	}
+}
+
+static struct k_spinlock led_lock;
+
+/*
+ * Colour stream: only the latest streamed colour is kept, and the backend
+ * latches it at a PWM period boundary. The stream goes quiet after a
+ * second without updates. Accounting is shared by both backends, callers
+ * hold led_lock.
+ */
+#define LED_STREAM_IDLE_FRAMES (MSEC_PER_SEC / LED_PERIOD_MS)
+
+static struct led_stream_stats stream_stats;
+static uint64_t stream_latency_sum_us;
+static uint64_t stream_jitter_sum_us;
+static uint32_t stream_arrival;   /* Cycle count of the pending update */
+static uint32_t stream_last_tick; /* Cycle count of the previous frame, 0 after a pause */
+static uint16_t stream_idle_frames;
+static uint8_t stream_color[3];
+static bool stream_pending;
+static bool stream_running;
+
+/* Store a streamed colour, the next frame latches it */
+static void stream_store(const uint8_t color[3])
+{
+	if (stream_pending) {
+		stream_stats.frames_dropped++;
+	}
+
+	memcpy(stream_color, color, sizeof(stream_color));
+	stream_arrival = k_cycle_get_32();
+	stream_pending = true;
+	stream_stats.frames_received++;
+}
+
+/* Deviation of this frame from the PWM period */
+static void stream_tick(uint32_t now)
+{
+	if (stream_last_tick != 0) {
+		int32_t error_us = (int32_t)k_cyc_to_us_floor32(now - stream_last_tick) -
+				   LED_PERIOD_MS * USEC_PER_MSEC;
+		uint32_t jitter_us = (uint32_t)ABS(error_us);
+
+		stream_stats.ticks++;
+		stream_jitter_sum_us += jitter_us;
+		stream_stats.jitter_max_us = MAX(stream_stats.jitter_max_us, jitter_us);
+	}
+	stream_last_tick = now;
+}
+
+/* Take the pending colour as PWM counts, false if there is none */
+static bool stream_take(uint32_t now, uint16_t level[3])
+{
+	uint32_t latency_us;
+
+	if (!stream_pending) {
+		return false;
+	}
+
+	latency_us = k_cyc_to_us_floor32(now - stream_arrival);
+	stream_pending = false;
+	stream_idle_frames = 0;
+
+	stream_stats.frames_applied++;
+	stream_latency_sum_us += latency_us;
+	stream_stats.latency_max_us = MAX(stream_stats.latency_max_us, latency_us);
+
+	color_level(stream_color, level);
+	return true;
+}
+
+#if defined(CONFIG_APP_LED_EFFECTS_NRF_PWM)
+
+/*
+ * PWM0 is driven directly through nrfx: the pattern is rendered once into
+ * a sequence buffer and EasyDMA replays it, so the CPU sleeps for the
+ * whole effect. Only finite patterns take one interrupt at the end.
+ */
+#define LED_PWM_NODE DT_NODELABEL(pwm0)
+
+BUILD_ASSERT(DT_SAME_NODE(DT_PWMS_CTLR(LED_RED_NODE), LED_PWM_NODE) &&
+	     DT_SAME_NODE(DT_PWMS_CTLR(LED_GREEN_NODE), LED_PWM_NODE) &&
+	     DT_SAME_NODE(DT_PWMS_CTLR(LED_BLUE_NODE), LED_PWM_NODE),
+	     "All LED channels must be on pwm0");
+BUILD_ASSERT(DT_PWMS_PERIOD(LED_GREEN_NODE) == LED_PERIOD_NS &&
+	     DT_PWMS_PERIOD(LED_BLUE_NODE) == LED_PERIOD_NS,
+	     "All LED channels must share one period");
+
+PINCTRL_DT_DEFINE(LED_PWM_NODE);
+
+/* Same encoding as the Zephyr driver: bit 15 selects the edge polarity */
+#define LED_CH_VALUE(node, counts) \
+	((counts) | ((DT_PWMS_FLAGS(node) & PWM_POLARITY_INVERTED) ? 0 : BIT(15)))
+
+static const nrfx_pwm_t pwm = NRFX_PWM_INSTANCE(0);
+
+/* Double buffered so a new pattern never overwrites the one being played */
+static nrf_pwm_values_individual_t seq_buf[2][LED_MAX_STEPS];
+static uint8_t seq_active;
+static bool pwm_running;
+static bool finite_pending;
+static uint8_t end_color[3];
+
+static void seq_set(nrf_pwm_values_individual_t *value, const uint16_t level[3])
+{
+	uint16_t *ch = (uint16_t *)value;
+
+	memset(value, 0, sizeof(*value));
+	ch[DT_PWMS_CHANNEL(LED_RED_NODE)] = LED_CH_VALUE(LED_RED_NODE, level[0]);
+	ch[DT_PWMS_CHANNEL(LED_GREEN_NODE)] = LED_CH_VALUE(LED_GREEN_NODE, level[1]);
+	ch[DT_PWMS_CHANNEL(LED_BLUE_NODE)] = LED_CH_VALUE(LED_BLUE_NODE, level[2]);
+}
+
+/* Hold one colour, caller holds led_lock */
+static void play_hold(const uint8_t color[3])
+{
+	uint16_t level[3];
+
+	finite_pending = false;
+
+	/* Stopped, the pins idle in the off state and HFCLK can be released */
+	if (color[0] == 0 && color[1] == 0 && color[2] == 0) {
+		if (pwm_running) {
+			nrfx_pwm_stop(&pwm, false);
+			pwm_running = false;
+		}
+		return;
+	}
+
+	seq_active ^= 1;
+	color_level(color, level);
+	seq_set(&seq_buf[seq_active][0], level);
+
+	nrf_pwm_sequence_t seq = {
+		.values.p_individual = seq_buf[seq_active],
+		.length = NRF_PWM_VALUES_LENGTH(seq_buf[seq_active][0]),
+		.repeats = 0,
+		.end_delay = 0,
+	};
+
+	/* The last value keeps being generated after the sequence ends */
+	nrfx_pwm_simple_playback(&pwm, &seq, 1, NRFX_PWM_FLAG_NO_EVT_FINISHED);
+	pwm_running = true;
+}
+
+/*
+ * The stream loops two one-period sequences. SEQEND[n] fires once the
+ * value of sequence n is loaded into the wave counter, so its RAM can be
+ * rewritten until n plays again two periods later. A new colour is
+ * written into each sequence at its own event and never changes a value
+ * that is being loaded; the colour switches on a period boundary.
+ */
+static nrf_pwm_values_individual_t stream_buf[2];
+static uint16_t stream_level[3];
+static uint8_t stream_writes; /* Sequences still holding an older colour */
+static bool stream_events;    /* SEQEND interrupts enabled */
+
+#define STREAM_INT_MASK (NRF_PWM_INT_SEQEND0_MASK | NRF_PWM_INT_SEQEND1_MASK)
+
+/* Start the stream loop with stream_level, caller holds led_lock */
+static void stream_start(void)
+{
+	nrf_pwm_sequence_t seq[2];
+
+	for (int i = 0; i < 2; i++) {
+		seq_set(&stream_buf[i], stream_level);
+		seq[i] = (nrf_pwm_sequence_t){
+			.values.p_individual = &stream_buf[i],
+			.length = NRF_PWM_VALUES_LENGTH(stream_buf[i]),
+			.repeats = 0,
+			.end_delay = 0,
+		};
+	}
+
+	finite_pending = false;
+	stream_running = true;
+	stream_events = true;
+	stream_writes = 0;
+	stream_idle_frames = 0;
+	stream_last_tick = 0;
+
+	nrfx_pwm_complex_playback(&pwm, &seq[0], &seq[1], 1,
+				  NRFX_PWM_FLAG_LOOP | NRFX_PWM_FLAG_SIGNAL_END_SEQ0 |
+				  NRFX_PWM_FLAG_SIGNAL_END_SEQ1 | NRFX_PWM_FLAG_NO_EVT_FINISHED);
+	pwm_running = true;
+}
+
+/* Sequence 'done' was just loaded, caller holds led_lock */
+static void stream_frame(uint8_t done)
+{
+	uint32_t now = k_cycle_get_32();
+
+	stream_tick(now);
+
+	if (stream_take(now, stream_level)) {
+		stream_writes = 2;
+	}
+
+	if (stream_writes > 0) {
+		seq_set(&stream_buf[done], stream_level);
+		stream_writes--;
+	} else if (++stream_idle_frames >= LED_STREAM_IDLE_FRAMES) {
+		/* Both sequences hold the colour, keep looping without interrupts */
+		nrf_pwm_int_disable(pwm.p_reg, STREAM_INT_MASK);
+		stream_events = false;
+		stream_last_tick = 0;
+	}
+}
+
+static int backend_stream(const uint8_t color[3])
+{
+	k_spinlock_key_t key = k_spin_lock(&led_lock);
+
+	stream_store(color);
+
+	if (!stream_running) {
+		/* The first colour goes out with the first period */
+		stream_take(k_cycle_get_32(), stream_level);
+		stream_start();
+	} else if (!stream_events) {
+		stream_idle_frames = 0;
+		stream_events = true;
+		nrf_pwm_event_clear(pwm.p_reg, NRF_PWM_EVENT_SEQEND0);
+		nrf_pwm_event_clear(pwm.p_reg, NRF_PWM_EVENT_SEQEND1);
+		nrf_pwm_int_enable(pwm.p_reg, STREAM_INT_MASK);
+	}
+
+	k_spin_unlock(&led_lock, key);
+	return 0;
+}
+
+static void pwm_handler(nrfx_pwm_evt_type_t event_type, void *context)
+{
+	k_spinlock_key_t key = k_spin_lock(&led_lock);
+
+	switch (event_type) {
+	case NRFX_PWM_EVT_END_SEQ0:
+	case NRFX_PWM_EVT_END_SEQ1:
+		if (stream_running) {
+			stream_frame(event_type == NRFX_PWM_EVT_END_SEQ0 ? 0 : 1);
+		}
+		break;
+	case NRFX_PWM_EVT_FINISHED:
+		if (finite_pending) {
+			play_hold(end_color);
+		}
+		break;
+	default:
+		break;
+	}
+
+	k_spin_unlock(&led_lock, key);
+}
+
+static int backend_play(const struct led_pattern *pattern, const struct led_plan *plan)
+{
+	uint16_t level[3];
+
+	k_spinlock_key_t key = k_spin_lock(&led_lock);
+
+	/* A pattern replaces the stream */
+	stream_running = false;
+
+	if (pattern->type == LED_PATTERN_STATIC) {
+		play_hold(pattern->from);
+		k_spin_unlock(&led_lock, key);
+		return 0;
+	}
+
+	seq_active ^= 1;
+	for (uint16_t i = 0; i < plan->steps; i++) {
+		pattern_frame(pattern, plan, i, level);
+		seq_set(&seq_buf[seq_active][i], level);
+	}
+
+	nrf_pwm_sequence_t seq = {
+		.values.p_individual = seq_buf[seq_active],
+		.length = plan->steps * NRF_PWM_VALUES_LENGTH(seq_buf[seq_active][0]),
+		.repeats = plan->step_periods - 1,
+		.end_delay = 0,
+	};
+
+	memcpy(end_color, plan->end, sizeof(end_color));
+	finite_pending = (plan->repeat != 0);
+
+	if (finite_pending) {
+		nrfx_pwm_simple_playback(&pwm, &seq, plan->repeat, 0);
+	} else {
+		nrfx_pwm_simple_playback(&pwm, &seq, 1,
+					 NRFX_PWM_FLAG_LOOP | NRFX_PWM_FLAG_NO_EVT_FINISHED);
+	}
+	pwm_running = true;
+
+	k_spin_unlock(&led_lock, key);
+	return 0;
+}
+
+static int backend_init(void)
+{
+	nrfx_pwm_config_t config = {
+		.output_pins = {
+			NRF_PWM_PIN_NOT_CONNECTED,
+			NRF_PWM_PIN_NOT_CONNECTED,
+			NRF_PWM_PIN_NOT_CONNECTED,
+			NRF_PWM_PIN_NOT_CONNECTED,
+		},
+		.irq_priority = DT_IRQ(LED_PWM_NODE, priority),
+		.base_clock = NRF_PWM_CLK_125kHz,
+		.count_mode = NRF_PWM_MODE_UP,
+		.top_value = LED_TOP,
+		.load_mode = NRF_PWM_LOAD_INDIVIDUAL,
+		.step_mode = NRF_PWM_STEP_AUTO,
+		/* Pins are routed and idle-levelled by pinctrl */
+		.skip_gpio_cfg = true,
+		.skip_psel_cfg = true,
+	};
+	int ret;
+
+	ret = pinctrl_apply_state(PINCTRL_DT_DEV_CONFIG_GET(LED_PWM_NODE),
+				  PINCTRL_STATE_DEFAULT);
+	if (ret != 0) {
+		LOG_ERR("PWM pinctrl failed: %d", ret);
+		return ret;
+	}
+
+	IRQ_CONNECT(DT_IRQN(LED_PWM_NODE), DT_IRQ(LED_PWM_NODE, priority),
+		    nrfx_isr, nrfx_pwm_0_irq_handler, 0);
+
+	if (nrfx_pwm_init(&pwm, &config, pwm_handler, NULL) != NRFX_SUCCESS) {
+		LOG_ERR("PWM0 init failed");
+		return -EBUSY;
+	}
+
+	return 0;
+}
+
+#else /* !CONFIG_APP_LED_EFFECTS_NRF_PWM */
+
+/*
+ * Portable fallback (e.g. native_sim fake PWM): step the pattern from the
+ * system workqueue through the PWM API.
+ */
+static const struct pwm_dt_spec leds[3] = {
+	PWM_DT_SPEC_GET(LED_RED_NODE),
+	PWM_DT_SPEC_GET(LED_GREEN_NODE),
+	PWM_DT_SPEC_GET(LED_BLUE_NODE),
+};
+
+static struct led_pattern sw_pattern;
+static struct led_plan sw_plan;
+static uint16_t sw_index;
+static uint8_t sw_cycle;
+static bool sw_holding;
+
+static void sw_output(const uint16_t level[3])
+{
+	for (int i = 0; i < 3; i++) {
+		pwm_set_pulse_dt(&leds[i], ((uint64_t)leds[i].period * level[i]) / LED_TOP);
+	}
+}
+
+static void sw_step_handler(struct k_work *work)
+{
+	struct k_work_delayable *dwork = k_work_delayable_from_work(work);
+	uint16_t level[3];
+	bool next = true;
+
+	k_spinlock_key_t key = k_spin_lock(&led_lock);
+
+	if (sw_holding) {
+		color_level(sw_plan.end, level);
+		next = false;
+	} else {
+		pattern_frame(&sw_pattern, &sw_plan, sw_index, level);
+
+		if (++sw_index >= sw_plan.steps) {
+			sw_index = 0;
+			if (sw_plan.repeat != 0 && ++sw_cycle >= sw_plan.repeat) {
+				sw_holding = true;
+			}
+		}
+		if (sw_pattern.type == LED_PATTERN_STATIC) {
+			next = false;
+		}
+	}
+
+	k_spin_unlock(&led_lock, key);
+
+	sw_output(level);
+
+	if (next) {
+		k_work_schedule(dwork, K_MSEC(sw_plan.step_periods * LED_PERIOD_MS));
+	}
+}
+
+static K_WORK_DELAYABLE_DEFINE(sw_step_work, sw_step_handler);
+
+/* One stream frame per PWM period, from the system workqueue */
+static void sw_stream_handler(struct k_work *work)
+{
+	struct k_work_delayable *dwork = k_work_delayable_from_work(work);
+	uint32_t now = k_cycle_get_32();
+	uint16_t level[3];
+	bool output;
+	bool next = true;
+
+	k_spinlock_key_t key = k_spin_lock(&led_lock);
+
+	if (!stream_running) {
+		k_spin_unlock(&led_lock, key);
+		return;
+	}
+
+	stream_tick(now);
+	output = stream_take(now, level);
+	if (!output && ++stream_idle_frames >= LED_STREAM_IDLE_FRAMES) {
+		stream_running = false;
+		next = false;
+	}
+
+	k_spin_unlock(&led_lock, key);
+
+	if (output) {
+		sw_output(level);
+	}
+
+	if (next) {
+		k_work_schedule(dwork, K_MSEC(LED_PERIOD_MS));
+	}
+}
+
+static K_WORK_DELAYABLE_DEFINE(sw_stream_work, sw_stream_handler);
+
+static int backend_stream(const uint8_t color[3])
+{
+	bool start;
+
+	k_spinlock_key_t key = k_spin_lock(&led_lock);
+
+	stream_store(color);
+
+	start = !stream_running;
+	if (start) {
+		stream_running = true;
+		stream_idle_frames = 0;
+		stream_last_tick = 0;
+	}
+
+	k_spin_unlock(&led_lock, key);
+
+	if (start) {
+		/* The stream replaces a running pattern */
+		k_work_cancel_delayable(&sw_step_work);
+		k_work_reschedule(&sw_stream_work, K_NO_WAIT);
+	}
+
+	return 0;
+}
+
+static int backend_play(const struct led_pattern *pattern, const struct led_plan *plan)
+{
+	k_spinlock_key_t key = k_spin_lock(&led_lock);
+
+	/* A pattern replaces the stream */
+	stream_running = false;
+	sw_pattern = *pattern;
+	sw_plan = *plan;
+	sw_index = 0;
+	sw_cycle = 0;
+	sw_holding = false;
+
+	k_spin_unlock(&led_lock, key);
+
+	k_work_reschedule(&sw_step_work, K_NO_WAIT);
+	return 0;
+}
+
+static int backend_init(void)
+{
+	for (int i = 0; i < ARRAY_SIZE(leds); i++) {
+		if (!pwm_is_ready_dt(&leds[i])) {
+			LOG_ERR("LED PWM device not ready");
+			return -ENODEV;
+		}
+	}
+
+	return 0;
+}
+
+#endif /* CONFIG_APP_LED_EFFECTS_NRF_PWM */
+
+int led_pattern_decode(const uint8_t *buf, size_t len, struct led_pattern *pattern)
+{
+	if (len != LED_PATTERN_WIRE_SIZE || buf[0] > LED_PATTERN_BLINK) {
+		return -EINVAL;
+	}
+
+	pattern->type = buf[0];
+	memcpy(pattern->from, &buf[1], sizeof(pattern->from));
+	memcpy(pattern->to, &buf[4], sizeof(pattern->to));
+	pattern->period_ms = sys_get_le16(&buf[7]);
+	pattern->repeat = buf[9];
+
+	if (pattern->type != LED_PATTERN_STATIC && pattern->period_ms == 0) {
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+int led_effects_play(const struct led_pattern *pattern)
+{
+	struct led_plan plan;
+
+	if (pattern->type > LED_PATTERN_BLINK) {
+		return -EINVAL;
+	}
+
+	plan_pattern(pattern, &plan);
+
+	LOG_DBG("Pattern %u: %u steps x %u periods, repeat %u", pattern->type,
+		plan.steps, plan.step_periods, plan.repeat);
+
+	return backend_play(pattern, &plan);
+}
+
+int led_effects_stream(const uint8_t color[3])
+{
+	return backend_stream(color);
+}
+
+void led_effects_stream_stats(struct led_stream_stats *out)
+{
+	k_spinlock_key_t key = k_spin_lock(&led_lock);
+
+	*out = stream_stats;
+	out->frame_us = LED_PERIOD_NS / NSEC_PER_USEC;
+	out->latency_avg_us = stream_stats.frames_applied ?
+		(uint32_t)(stream_latency_sum_us / stream_stats.frames_applied) : 0;
+	out->jitter_avg_us = stream_stats.ticks ?
+		(uint32_t)(stream_jitter_sum_us / stream_stats.ticks) : 0;
+
+	k_spin_unlock(&led_lock, key);
+}
+
+int led_effects_play_status(enum led_status status)
+{
+	if (status >= ARRAY_SIZE(status_patterns)) {
+		return -EINVAL;
+	}
+
+	return led_effects_play(&status_patterns[status]);
+}
+
+int led_effects_init(void)
+{
+	int ret;
+
+	ret = backend_init();
+	if (ret != 0) {
+		return ret;
+	}
+
+	LOG_INF("LED effects engine initialized (%s)",
+		IS_ENABLED(CONFIG_APP_LED_EFFECTS_NRF_PWM) ? "PWM sequencer" : "software");
+
+	return led_effects_play_status(LED_STATUS_OFF);
+}
@@ -0,0 +1,121 @@
+#ifndef LED_EFFECTS_H
+#define LED_EFFECTS_H
+
+#include <zephyr/kernel.h>
+
+/**
+ * @brief LED pattern types
+ */
+enum led_pattern_type {
+	LED_PATTERN_STATIC = 0,   /* Hold colour A */
+	LED_PATTERN_FADE = 1,     /* Fade A to B, then hold B */
+	LED_PATTERN_BREATHE = 2,  /* Fade A to B and back */
+	LED_PATTERN_BLINK = 3,    /* A for half the period, B for the other half */
+};
+
+/**
+ * @brief Predefined status patterns
+ */
+enum led_status {
+	LED_STATUS_OFF = 0,
+	LED_STATUS_BOOT,       /* Yellow breathing while initializing */
+	LED_STATUS_OK,         /* Green for 3 seconds */
+	LED_STATUS_ERROR,      /* Fast red blinking */
+	LED_STATUS_CONNECTED,  /* Short blue fade out */
+};
+
+/**
+ * @brief Compact LED pattern descriptor
+ *
+ * Wire format (LED_PATTERN_WIRE_SIZE bytes, little endian):
+ * type u8, colour A r/g/b u8, colour B r/g/b u8, period_ms u16, repeat u8
+ */
+struct led_pattern {
+	uint8_t type;        /* enum led_pattern_type */
+	uint8_t from[3];     /* Colour A (R, G, B) */
+	uint8_t to[3];       /* Colour B (R, G, B) */
+	uint16_t period_ms;  /* Duration of one cycle */
+	uint8_t repeat;      /* Cycles to play, 0 = forever */
+};
+
+#define LED_PATTERN_WIRE_SIZE 10
+
+/**
+ * @brief Colour stream pacing statistics
+ *
+ * Latency is measured from a streamed update to the PWM period boundary
+ * that latched it, jitter as the deviation of those boundaries, as seen
+ * by the CPU, from the PWM period.
+ */
+struct led_stream_stats {
+	uint32_t frame_us;         /* PWM period, one frame */
+	uint32_t frames_received;  /* Streamed colour updates */
+	uint32_t frames_applied;   /* Updates latched to the LED */
+	uint32_t frames_dropped;   /* Updates superseded before their frame */
+	uint32_t ticks;            /* Frames measured for jitter */
+	uint32_t latency_avg_us;   /* Mean update-to-latch latency */
+	uint32_t latency_max_us;   /* Worst update-to-latch latency */
+	uint32_t jitter_avg_us;    /* Mean frame deviation */
+	uint32_t jitter_max_us;    /* Worst frame deviation */
+};
+
+/**
+ * @brief Initialize the LED effects engine
+ *
+ * @return 0 on success, negative errno on failure
+ */
+int led_effects_init(void);
+
+/**
+ * @brief Play a pattern
+ *
+ * On nRF the pattern is rendered once into a PWM sequence and played by
+ * EasyDMA, so the CPU is not woken per step. Finite patterns end with
+ * colour B held (FADE) or the LED off.
+ *
+ * @param pattern Pattern to play
+ * @return 0 on success, negative errno on failure
+ */
+int led_effects_play(const struct led_pattern *pattern);
+
+/**
+ * @brief Stream a colour
+ *
+ * Only the latest colour is kept and latched at the next PWM period
+ * boundary, so updates faster than the PWM rate are dropped. On nRF
+ * the colour is written into the running PWM sequence when its SEQEND
+ * event fires and the output never restarts mid-period. The stream
+ * replaces any running pattern and goes quiet after a second without
+ * updates, holding the last colour.
+ *
+ * @param color Colour (R, G, B)
+ * @return 0 on success, negative errno on failure
+ */
+int led_effects_stream(const uint8_t color[3]);
+
+/**
+ * @brief Get colour stream pacing statistics
+ *
+ * @param out Snapshot to fill
+ */
+void led_effects_stream_stats(struct led_stream_stats *out);
+
+/**
+ * @brief Play a predefined status pattern
+ *
+ * @param status Status to signal
+ * @return 0 on success, negative errno on failure
+ */
+int led_effects_play_status(enum led_status status);
+
+/**
+ * @brief Decode a pattern from its wire format
+ *
+ * @param buf Encoded pattern
+ * @param len Length of @p buf
+ * @param pattern Decoded pattern
+ * @return 0 on success, -EINVAL on malformed input
+ */
+int led_pattern_decode(const uint8_t *buf, size_t len, struct led_pattern *pattern);
+
+#endif /* LED_EFFECTS_H */
@@ -0,0 +1,26 @@
+#ifndef LOG_RATELIMIT_H
+#define LOG_RATELIMIT_H
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+
+/**
+ * @brief Log at INF level at most once per interval
+ *
+ * Each call site keeps its own timestamp. Messages inside the interval
+ * are dropped before any formatting or log packaging takes place.
+ *
+ * @param interval_ms Minimum time between two messages from this call site
+ */
+#define APP_LOG_INF_RATELIMIT(interval_ms, ...)				\
+	do {								\
+		static int64_t _log_last_ms = -(interval_ms);		\
+		int64_t _log_now_ms = k_uptime_get();			\
+									\
+		if (_log_now_ms - _log_last_ms >= (interval_ms)) {	\
+			_log_last_ms = _log_now_ms;			\
+			LOG_INF(__VA_ARGS__);				\
+		}							\
+	} while (0)
+
+#endif /* LOG_RATELIMIT_H */
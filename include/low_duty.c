@@ -0,0 +1,252 @@
+#include "low_duty.h"
+#include "advertising.h"
+#include "battery.h"
+#include "ble_bas_service.h"
+#include "ble_ess_service.h"
+#include "boot.h"
+#include "display_epaper.h"
+#include "workqueues.h"
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/crc.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(CONFIG_SHELL)
+#include <zephyr/shell/shell.h>
+#endif
+
+LOG_MODULE_REGISTER(low_duty, CONFIG_APP_LOW_DUTY_LOG_LEVEL);
+
+#define RETAINED_MAGIC 0x4c445431  /* "LDT1" */
+
+/* Wait for the boot display thread at most this long on the first cycle */
+#define DISPLAY_WAIT_MS 30000
+
+/* Statistics and refresh policy, kept across warm resets */
+struct low_duty_retained {
+	uint32_t magic;
+	struct low_duty_stats stats;
+	uint64_t total_cycle_us;
+	int16_t shown_temp;           /* Readings on the panel */
+	uint16_t shown_humidity;
+	uint16_t cycles_since_refresh;
+	uint32_t crc;                 /* CRC32 of the fields above */
+};
+
+static __noinit struct low_duty_retained retained;
+static struct k_spinlock stats_lock;
+
+/* Panel refresh on the display queue, values guarded by stats_lock */
+static void refresh_panel(struct k_work *work);
+static K_WORK_DEFINE(refresh_work, refresh_panel);
+static struct wq_stamp refresh_stamp;
+static struct {
+	int16_t temp;
+	uint16_t humidity;
+	uint16_t voltage;
+	uint8_t battery_pct;
+} refresh_values;
+
+static uint32_t retained_crc(void)
+{
+	return crc32_ieee((const uint8_t *)&retained,
+			  offsetof(struct low_duty_retained, crc));
+}
+
+static uint32_t elapsed_us(int64_t since_ticks)
+{
+	return (uint32_t)k_ticks_to_us_near64(k_uptime_ticks() - since_ticks);
+}
+
+/* Refresh when a reading moved enough, or after too many skipped cycles */
+static bool refresh_due(int16_t temp, uint16_t humidity)
+{
+	return retained.stats.refreshes == 0 ||
+	       abs(temp - retained.shown_temp) >= CONFIG_APP_LOW_DUTY_TEMP_DELTA ||
+	       abs((int32_t)humidity - retained.shown_humidity) >= CONFIG_APP_LOW_DUTY_HUMIDITY_DELTA ||
+	       retained.cycles_since_refresh >= CONFIG_APP_LOW_DUTY_REFRESH_MAX_CYCLES;
+}
+
+/* Dashboard and battery level in one frame, may take seconds */
+static void refresh_panel(struct k_work *work)
+{
+	int64_t start = k_uptime_ticks();
+	k_spinlock_key_t key;
+	int16_t temp;
+	uint16_t humidity;
+	uint16_t voltage;
+	uint8_t battery_pct;
+	uint32_t display_us;
+
+	wq_started(WQ_DISPLAY, &refresh_stamp);
+
+	key = k_spin_lock(&stats_lock);
+	temp = refresh_values.temp;
+	humidity = refresh_values.humidity;
+	voltage = refresh_values.voltage;
+	battery_pct = refresh_values.battery_pct;
+	k_spin_unlock(&stats_lock, key);
+
+	display_update_dashboard(temp, humidity, voltage, battery_pct);
+	display_us = elapsed_us(start);
+
+	key = k_spin_lock(&stats_lock);
+	retained.stats.last_display_us = display_us;
+	retained.crc = retained_crc();
+	k_spin_unlock(&stats_lock, key);
+
+	LOG_DBG("Panel refreshed in %u us", display_us);
+}
+
+static void low_duty_cycle(void)
+{
+	int64_t wake = k_uptime_ticks();
+	int64_t phase;
+	int16_t temp;
+	uint16_t humidity;
+	uint16_t voltage;
+	uint8_t battery_pct;
+	struct sensor_record rec;
+	bool refresh = false;
+	uint32_t sample_us;
+	uint32_t burst_us;
+	uint32_t cycle_us;
+	int err;
+
+	/* Sample and read the battery synchronously, the radio is off */
+	ess_sample();
+	voltage = battery_read_voltage();
+	battery_pct = battery_get_percentage(voltage);
+	temp = ess_get_temperature();
+	humidity = ess_get_humidity();
+	bas_update_battery(voltage, battery_pct);
+	ess_record(voltage, SENSOR_RECORD_FLAG_LOW_DUTY, &rec);
+	advertising_set_record(&rec);
+	sample_us = elapsed_us(wake);
+
+	/*
+	 * Redraw the dashboard only when the values moved. This is a full
+	 * framebuffer clear and flush, so skipped cycles save the refresh.
+	 * The display queue draws it while the burst goes out.
+	 */
+	if (boot_reached(BOOT_PHASE_DISPLAY_READY) && refresh_due(temp, humidity)) {
+		k_spinlock_key_t key = k_spin_lock(&stats_lock);
+
+		refresh_values.temp = temp;
+		refresh_values.humidity = humidity;
+		refresh_values.voltage = voltage;
+		refresh_values.battery_pct = battery_pct;
+
+		k_spin_unlock(&stats_lock, key);
+
+		err = wq_submit(WQ_DISPLAY, &refresh_work, &refresh_stamp);
+		if (err < 0) {
+			LOG_ERR("Panel refresh not queued (err %d)", err);
+		} else {
+			refresh = true;
+		}
+	}
+
+	/* Non-connectable burst carrying the sensor broadcast */
+	phase = k_uptime_ticks();
+	err = advertising_burst(CONFIG_APP_LOW_DUTY_BURST_MS);
+	if (err) {
+		LOG_ERR("Advertising burst failed (err %d)", err);
+	}
+	burst_us = elapsed_us(phase);
+
+	cycle_us = elapsed_us(wake);
+
+	k_spinlock_key_t key = k_spin_lock(&stats_lock);
+
+	if (refresh) {
+		retained.shown_temp = temp;
+		retained.shown_humidity = humidity;
+		retained.cycles_since_refresh = 0;
+		retained.stats.refreshes++;
+	} else {
+		retained.cycles_since_refresh++;
+		retained.stats.last_display_us = 0;
+	}
+	retained.stats.cycles++;
+	retained.stats.last_cycle_us = cycle_us;
+	retained.stats.max_cycle_us = MAX(retained.stats.max_cycle_us, cycle_us);
+	retained.total_cycle_us += cycle_us;
+	retained.stats.avg_cycle_us = (uint32_t)(retained.total_cycle_us / retained.stats.cycles);
+	retained.stats.last_sample_us = sample_us;
+	retained.stats.last_burst_us = burst_us;
+	retained.crc = retained_crc();
+
+	k_spin_unlock(&stats_lock, key);
+
+	LOG_INF("Cycle %u: %u us awake (sample %u, burst %u)%s",
+		retained.stats.cycles, cycle_us, sample_us, burst_us,
+		refresh ? ", panel refresh queued" : "");
+}
+
+static void low_duty_thread(void *p1, void *p2, void *p3)
+{
+	int64_t next_ms = k_uptime_get();
+
+	/* Let the boot display thread finish the first frame */
+	boot_wait(BOOT_PHASE_DISPLAY_READY, K_MSEC(DISPLAY_WAIT_MS));
+
+	while (1) {
+		low_duty_cycle();
+
+		/* Periods stay aligned, however long the cycle took */
+		next_ms += CONFIG_APP_LOW_DUTY_PERIOD_S * MSEC_PER_SEC;
+		k_sleep(K_MSEC(MAX(next_ms - k_uptime_get(), 0)));
+	}
+}
+
+K_THREAD_DEFINE(low_duty_tid, CONFIG_APP_LOW_DUTY_STACK_SIZE, low_duty_thread,
+		NULL, NULL, NULL, K_LOWEST_APPLICATION_THREAD_PRIO, 0, SYS_FOREVER_MS);
+
+int low_duty_start(void)
+{
+	if (retained.magic != RETAINED_MAGIC || retained.crc != retained_crc()) {
+		memset(&retained, 0, sizeof(retained));
+		retained.magic = RETAINED_MAGIC;
+		retained.crc = retained_crc();
+	} else {
+		LOG_INF("Low-duty state restored after %u cycles", retained.stats.cycles);
+	}
+
+	k_thread_start(low_duty_tid);
+
+	LOG_INF("Low-duty mode: wake every %u s, %u ms burst",
+		CONFIG_APP_LOW_DUTY_PERIOD_S, CONFIG_APP_LOW_DUTY_BURST_MS);
+	return 0;
+}
+
+void low_duty_get_stats(struct low_duty_stats *out)
+{
+	k_spinlock_key_t key = k_spin_lock(&stats_lock);
+
+	*out = retained.stats;
+
+	k_spin_unlock(&stats_lock, key);
+}
+
+#if defined(CONFIG_SHELL)
+static int cmd_diag_lowduty(const struct shell *sh, size_t argc, char **argv)
+{
+	struct low_duty_stats s;
+
+	low_duty_get_stats(&s);
+
+	shell_fprintf(sh, SHELL_NORMAL,
+		      "{\"period_s\":%u,\"cycles\":%u,\"refreshes\":%u,"
+		      "\"last_cycle_us\":%u,\"max_cycle_us\":%u,\"avg_cycle_us\":%u,"
+		      "\"sample_us\":%u,\"display_us\":%u,\"burst_us\":%u}\n",
+		      CONFIG_APP_LOW_DUTY_PERIOD_S, s.cycles, s.refreshes,
+		      s.last_cycle_us, s.max_cycle_us, s.avg_cycle_us,
+		      s.last_sample_us, s.last_display_us, s.last_burst_us);
+
+	return 0;
+}
+
+SHELL_SUBCMD_ADD((diag), lowduty, NULL, "Low-duty cycle timing (JSON)",
+		 cmd_diag_lowduty, 1, 0);
+#endif /* CONFIG_SHELL */
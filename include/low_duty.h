@@ -0,0 +1,47 @@
+#ifndef LOW_DUTY_H
+#define LOW_DUTY_H
+
+#include <zephyr/kernel.h>
+
+/**
+ * @brief Timing of the low-duty wake cycles
+ */
+struct low_duty_stats {
+	uint32_t cycles;           /* Wake cycles since the last cold boot */
+	uint32_t refreshes;        /* Cycles that refreshed the panel */
+	uint32_t last_cycle_us;    /* Wake to sleep of the last cycle */
+	uint32_t max_cycle_us;     /* Longest cycle */
+	uint32_t avg_cycle_us;     /* Average cycle */
+	uint32_t last_sample_us;   /* Sampling and battery read */
+	uint32_t last_display_us;  /* Panel refresh on WQ_DISPLAY, 0 when skipped */
+	uint32_t last_burst_us;    /* Advertising burst */
+};
+
+#if defined(CONFIG_APP_LOW_DUTY)
+
+/**
+ * @brief Start the low-duty cycle instead of connectable advertising
+ *
+ * Every CONFIG_APP_LOW_DUTY_PERIOD_S the node wakes, samples, updates
+ * the panel when the readings moved, broadcasts a short non-connectable
+ * advertising burst and sleeps again. Must be called after bt_enable().
+ *
+ * @return 0 on success, negative errno on failure
+ */
+int low_duty_start(void);
+
+/**
+ * @brief Get the wake cycle timing
+ *
+ * @param out Destination snapshot
+ */
+void low_duty_get_stats(struct low_duty_stats *out);
+
+#else
+
+static inline int low_duty_start(void) { return -ENOTSUP; }
+static inline void low_duty_get_stats(struct low_duty_stats *out) { *out = (struct low_duty_stats){0}; }
+
+#endif /* CONFIG_APP_LOW_DUTY */
+
+#endif /* LOW_DUTY_H */
@@ -0,0 +1,569 @@
+#include "mesh_sensor.h"
+#include "ble_ess_service.h"
+#include "battery.h"
+#include <zephyr/bluetooth/bluetooth.h>
+#include <zephyr/bluetooth/mesh.h>
+#include <zephyr/drivers/hwinfo.h>
+#include <zephyr/settings/settings.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/logging/log.h>
+#include <stdlib.h>
+#include <string.h>
+
+LOG_MODULE_REGISTER(mesh_sensor, CONFIG_APP_MESH_LOG_LEVEL);
+
+/* Sensor Server / Sensor Setup Server opcodes */
+#define OP_SENSOR_DESCRIPTOR_GET   BT_MESH_MODEL_OP_2(0x82, 0x30)
+#define OP_SENSOR_DESCRIPTOR_STATUS BT_MESH_MODEL_OP_1(0x51)
+#define OP_SENSOR_GET              BT_MESH_MODEL_OP_2(0x82, 0x31)
+#define OP_SENSOR_STATUS           BT_MESH_MODEL_OP_1(0x52)
+#define OP_SENSOR_CADENCE_GET      BT_MESH_MODEL_OP_2(0x82, 0x34)
+#define OP_SENSOR_CADENCE_SET      BT_MESH_MODEL_OP_1(0x55)
+#define OP_SENSOR_CADENCE_SET_UNACK BT_MESH_MODEL_OP_1(0x56)
+#define OP_SENSOR_CADENCE_STATUS   BT_MESH_MODEL_OP_1(0x57)
+#define OP_SENSOR_SETTINGS_GET     BT_MESH_MODEL_OP_2(0x82, 0x35)
+#define OP_SENSOR_SETTINGS_STATUS  BT_MESH_MODEL_OP_1(0x58)
+
+/* Generic Battery Server opcodes */
+#define OP_GEN_BATTERY_GET         BT_MESH_MODEL_OP_2(0x82, 0x23)
+#define OP_GEN_BATTERY_STATUS      BT_MESH_MODEL_OP_2(0x82, 0x24)
+
+/* Mesh device properties, both 2-byte values in 0.01 units */
+#define PROP_PRECISE_PRESENT_AMB_TEMP  0x0075  /* Temperature, sint16 0.01 C */
+#define PROP_PRESENT_AMB_REL_HUMIDITY  0x0076  /* Humidity, uint16 0.01 % */
+
+#define SENSOR_VALUE_LEN 2
+#define SENSOR_COUNT 2
+
+/* Marshalled sensor data: Format A header (2) + value */
+#define SENSOR_DATA_LEN (2 + SENSOR_VALUE_LEN)
+#define SENSOR_STATUS_LEN (SENSOR_COUNT * SENSOR_DATA_LEN)
+
+/* Descriptor: property, tolerances (3), sampling, measurement period, update interval */
+#define SENSOR_DESCRIPTOR_LEN 8
+#define SAMPLING_INSTANTANEOUS 0x01
+/* Update interval is 1.1^(n - 64) s, 88 is about 10 s (ESS update period) */
+#define SENSOR_UPDATE_INTERVAL 88
+
+/* Cadence: property, divisor/type, delta down, delta up, min interval, fast low, fast high */
+#define CADENCE_LEN (2 + 1 + 4 * SENSOR_VALUE_LEN + 1)
+#define CADENCE_MAX_DIVISOR 15
+#define CADENCE_MAX_MIN_INTERVAL 26
+#define TRIGGER_TYPE_PERCENT BIT(7)
+
+struct mesh_sensor {
+	uint16_t prop_id;
+	bool is_signed;
+	/* Sensor Cadence state */
+	uint8_t period_div;
+	bool trigger_percent;    /* Deltas in 0.01 % of the value instead of units */
+	uint16_t delta_down;
+	uint16_t delta_up;
+	uint8_t min_interval;    /* 2^n ms between change-triggered publications */
+	int32_t fast_low;
+	int32_t fast_high;
+	/* Last published value */
+	int32_t published;
+	int64_t published_ms;
+};
+
+static struct mesh_sensor sensors[SENSOR_COUNT] = {
+	{
+		.prop_id = PROP_PRECISE_PRESENT_AMB_TEMP,
+		.is_signed = true,
+		.delta_down = 50,  /* 0.5 C */
+		.delta_up = 50,
+		.min_interval = 10, /* ~1 s */
+		.fast_low = 1,
+		.fast_high = 0,     /* Empty fast range */
+	},
+	{
+		.prop_id = PROP_PRESENT_AMB_REL_HUMIDITY,
+		.is_signed = false,
+		.delta_down = 200, /* 2 % */
+		.delta_up = 200,
+		.min_interval = 10,
+		.fast_low = 1,
+		.fast_high = 0,
+	},
+};
+
+static uint8_t dev_uuid[16];
+
+static int32_t sensor_value(const struct mesh_sensor *sensor)
+{
+	switch (sensor->prop_id) {
+	case PROP_PRECISE_PRESENT_AMB_TEMP:
+		return ess_get_temperature();
+	case PROP_PRESENT_AMB_REL_HUMIDITY:
+		return ess_get_humidity();
+	default:
+		return 0;
+	}
+}
+
+static struct mesh_sensor *sensor_find(uint16_t prop_id)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(sensors); i++) {
+		if (sensors[i].prop_id == prop_id) {
+			return &sensors[i];
+		}
+	}
+
+	return NULL;
+}
+
+static int32_t get_value(struct net_buf_simple *buf, bool is_signed)
+{
+	uint16_t raw = net_buf_simple_pull_le16(buf);
+
+	return is_signed ? (int16_t)raw : raw;
+}
+
+/* Fast cadence applies inside [low, high], or outside (high, low) if inverted */
+static bool in_fast_range(const struct mesh_sensor *sensor, int32_t value)
+{
+	if (sensor->fast_low <= sensor->fast_high) {
+		return value >= sensor->fast_low && value <= sensor->fast_high;
+	}
+
+	return value >= sensor->fast_low || value <= sensor->fast_high;
+}
+
+/* Format A marshalled sensor data: format 0, length - 1, 11-bit property */
+static void add_sensor_data(struct net_buf_simple *msg, const struct mesh_sensor *sensor,
+			    int32_t value)
+{
+	net_buf_simple_add_le16(msg, (sensor->prop_id << 5) | ((SENSOR_VALUE_LEN - 1) << 1));
+	net_buf_simple_add_le16(msg, (uint16_t)value);
+}
+
+static void add_descriptor(struct net_buf_simple *msg, const struct mesh_sensor *sensor)
+{
+	net_buf_simple_add_le16(msg, sensor->prop_id);
+	/* Positive and negative tolerance unspecified (2 x 12 bits) */
+	net_buf_simple_add_u8(msg, 0);
+	net_buf_simple_add_le16(msg, 0);
+	net_buf_simple_add_u8(msg, SAMPLING_INSTANTANEOUS);
+	net_buf_simple_add_u8(msg, 0); /* Measurement period not applicable */
+	net_buf_simple_add_u8(msg, SENSOR_UPDATE_INTERVAL);
+}
+
+static void add_cadence(struct net_buf_simple *msg, const struct mesh_sensor *sensor)
+{
+	net_buf_simple_add_le16(msg, sensor->prop_id);
+	net_buf_simple_add_u8(msg, sensor->period_div |
+			      (sensor->trigger_percent ? TRIGGER_TYPE_PERCENT : 0));
+	net_buf_simple_add_le16(msg, sensor->delta_down);
+	net_buf_simple_add_le16(msg, sensor->delta_up);
+	net_buf_simple_add_u8(msg, sensor->min_interval);
+	net_buf_simple_add_le16(msg, (uint16_t)sensor->fast_low);
+	net_buf_simple_add_le16(msg, (uint16_t)sensor->fast_high);
+}
+
+/*
+ * Only writer of the publication message. The stack calls it for
+ * periodic publications and publish_handler() for triggered ones, both
+ * on the system work queue, so they never fill the message at once.
+ */
+static int sensor_pub_update(const struct bt_mesh_model *model)
+{
+	struct bt_mesh_model_pub *pub = model->pub;
+	int64_t now = k_uptime_get();
+	uint8_t period_div = 0;
+	bool fast = false;
+
+	bt_mesh_model_msg_init(pub->msg, OP_SENSOR_STATUS);
+	for (size_t i = 0; i < ARRAY_SIZE(sensors); i++) {
+		sensors[i].published = sensor_value(&sensors[i]);
+		sensors[i].published_ms = now;
+		add_sensor_data(pub->msg, &sensors[i], sensors[i].published);
+
+		if (in_fast_range(&sensors[i], sensors[i].published)) {
+			fast = true;
+			period_div = MAX(period_div, sensors[i].period_div);
+		}
+	}
+
+	/* Publish period / 2^divisor while a value is in its fast range */
+	pub->fast_period = fast;
+	pub->period_div = period_div;
+
+	return 0;
+}
+
+BT_MESH_MODEL_PUB_DEFINE(sensor_pub, sensor_pub_update,
+			 BT_MESH_MODEL_OP_LEN(OP_SENSOR_STATUS) + SENSOR_STATUS_LEN);
+
+static int handle_descriptor_get(const struct bt_mesh_model *model,
+				 struct bt_mesh_msg_ctx *ctx,
+				 struct net_buf_simple *buf)
+{
+	BT_MESH_MODEL_BUF_DEFINE(msg, OP_SENSOR_DESCRIPTOR_STATUS,
+				 SENSOR_COUNT * SENSOR_DESCRIPTOR_LEN);
+
+	bt_mesh_model_msg_init(&msg, OP_SENSOR_DESCRIPTOR_STATUS);
+
+	if (buf->len >= 2) {
+		uint16_t prop_id = net_buf_simple_pull_le16(buf);
+		struct mesh_sensor *sensor = sensor_find(prop_id);
+
+		/* Unknown property: only the property ID is returned */
+		if (sensor == NULL) {
+			net_buf_simple_add_le16(&msg, prop_id);
+		} else {
+			add_descriptor(&msg, sensor);
+		}
+	} else {
+		for (size_t i = 0; i < ARRAY_SIZE(sensors); i++) {
+			add_descriptor(&msg, &sensors[i]);
+		}
+	}
+
+	return bt_mesh_model_send(model, ctx, &msg, NULL, NULL);
+}
+
+static int handle_sensor_get(const struct bt_mesh_model *model,
+			     struct bt_mesh_msg_ctx *ctx,
+			     struct net_buf_simple *buf)
+{
+	BT_MESH_MODEL_BUF_DEFINE(msg, OP_SENSOR_STATUS, SENSOR_STATUS_LEN);
+
+	bt_mesh_model_msg_init(&msg, OP_SENSOR_STATUS);
+
+	if (buf->len >= 2) {
+		uint16_t prop_id = net_buf_simple_pull_le16(buf);
+		struct mesh_sensor *sensor = sensor_find(prop_id);
+
+		if (sensor == NULL) {
+			/* Format B with length 0x7F marks an unknown property */
+			net_buf_simple_add_u8(&msg, (0x7F << 1) | 1);
+			net_buf_simple_add_le16(&msg, prop_id);
+		} else {
+			add_sensor_data(&msg, sensor, sensor_value(sensor));
+		}
+	} else {
+		for (size_t i = 0; i < ARRAY_SIZE(sensors); i++) {
+			add_sensor_data(&msg, &sensors[i], sensor_value(&sensors[i]));
+		}
+	}
+
+	return bt_mesh_model_send(model, ctx, &msg, NULL, NULL);
+}
+
+static const struct bt_mesh_model_op sensor_srv_op[] = {
+	{ OP_SENSOR_DESCRIPTOR_GET, BT_MESH_LEN_MIN(0), handle_descriptor_get },
+	{ OP_SENSOR_GET, BT_MESH_LEN_MIN(0), handle_sensor_get },
+	BT_MESH_MODEL_OP_END,
+};
+
+static int send_cadence_status(const struct bt_mesh_model *model,
+			       struct bt_mesh_msg_ctx *ctx, uint16_t prop_id)
+{
+	BT_MESH_MODEL_BUF_DEFINE(msg, OP_SENSOR_CADENCE_STATUS, CADENCE_LEN);
+	struct mesh_sensor *sensor = sensor_find(prop_id);
+
+	bt_mesh_model_msg_init(&msg, OP_SENSOR_CADENCE_STATUS);
+
+	if (sensor == NULL) {
+		net_buf_simple_add_le16(&msg, prop_id);
+	} else {
+		add_cadence(&msg, sensor);
+	}
+
+	return bt_mesh_model_send(model, ctx, &msg, NULL, NULL);
+}
+
+static int handle_cadence_get(const struct bt_mesh_model *model,
+			      struct bt_mesh_msg_ctx *ctx,
+			      struct net_buf_simple *buf)
+{
+	return send_cadence_status(model, ctx, net_buf_simple_pull_le16(buf));
+}
+
+static int cadence_set(struct net_buf_simple *buf, uint16_t *prop_id)
+{
+	struct mesh_sensor *sensor;
+	uint8_t div_type;
+	uint8_t min_interval;
+
+	*prop_id = net_buf_simple_pull_le16(buf);
+	sensor = sensor_find(*prop_id);
+	if (sensor == NULL) {
+		return -ENOENT;
+	}
+
+	if (buf->len != CADENCE_LEN - 2) {
+		return -EMSGSIZE;
+	}
+
+	div_type = net_buf_simple_pull_u8(buf);
+	if ((div_type & ~TRIGGER_TYPE_PERCENT) > CADENCE_MAX_DIVISOR) {
+		return -EINVAL;
+	}
+
+	sensor->period_div = div_type & ~TRIGGER_TYPE_PERCENT;
+	sensor->trigger_percent = (div_type & TRIGGER_TYPE_PERCENT) != 0;
+	sensor->delta_down = net_buf_simple_pull_le16(buf);
+	sensor->delta_up = net_buf_simple_pull_le16(buf);
+	min_interval = net_buf_simple_pull_u8(buf);
+	sensor->min_interval = MIN(min_interval, CADENCE_MAX_MIN_INTERVAL);
+	sensor->fast_low = get_value(buf, sensor->is_signed);
+	sensor->fast_high = get_value(buf, sensor->is_signed);
+
+	LOG_INF("Cadence 0x%04x: div %u, delta -%u/+%u%s, min 2^%u ms",
+		*prop_id, sensor->period_div, sensor->delta_down, sensor->delta_up,
+		sensor->trigger_percent ? " (0.01%)" : "", sensor->min_interval);
+
+	return 0;
+}
+
+static int handle_cadence_set(const struct bt_mesh_model *model,
+			      struct bt_mesh_msg_ctx *ctx,
+			      struct net_buf_simple *buf)
+{
+	uint16_t prop_id;
+	int err;
+
+	err = cadence_set(buf, &prop_id);
+	if (err == -EMSGSIZE || err == -EINVAL) {
+		return err;
+	}
+
+	return send_cadence_status(model, ctx, prop_id);
+}
+
+static int handle_cadence_set_unack(const struct bt_mesh_model *model,
+				    struct bt_mesh_msg_ctx *ctx,
+				    struct net_buf_simple *buf)
+{
+	uint16_t prop_id;
+	int err;
+
+	err = cadence_set(buf, &prop_id);
+
+	return (err == -ENOENT) ? 0 : err;
+}
+
+/* No sensor settings, answer with an empty list */
+static int handle_settings_get(const struct bt_mesh_model *model,
+			       struct bt_mesh_msg_ctx *ctx,
+			       struct net_buf_simple *buf)
+{
+	BT_MESH_MODEL_BUF_DEFINE(msg, OP_SENSOR_SETTINGS_STATUS, 2);
+
+	bt_mesh_model_msg_init(&msg, OP_SENSOR_SETTINGS_STATUS);
+	net_buf_simple_add_le16(&msg, net_buf_simple_pull_le16(buf));
+
+	return bt_mesh_model_send(model, ctx, &msg, NULL, NULL);
+}
+
+static const struct bt_mesh_model_op sensor_setup_srv_op[] = {
+	{ OP_SENSOR_CADENCE_GET, BT_MESH_LEN_EXACT(2), handle_cadence_get },
+	{ OP_SENSOR_CADENCE_SET, BT_MESH_LEN_MIN(2), handle_cadence_set },
+	{ OP_SENSOR_CADENCE_SET_UNACK, BT_MESH_LEN_MIN(2), handle_cadence_set_unack },
+	{ OP_SENSOR_SETTINGS_GET, BT_MESH_LEN_EXACT(2), handle_settings_get },
+	BT_MESH_MODEL_OP_END,
+};
+
+/*
+ * Generic Battery Status: level u8, time to discharge u24, time to
+ * charge u24 (both unknown), flags u8
+ */
+#define BATTERY_STATUS_LEN 8
+#define BATTERY_TIME_UNKNOWN 0xFFFFFF
+#define BATTERY_PRESENT_NON_REMOVABLE 0x01
+#define BATTERY_CHARGING_UNKNOWN (0x03 << 4)
+#define BATTERY_SERVICE_UNKNOWN (0x03 << 6)
+
+static void add_battery_status(struct net_buf_simple *msg)
+{
+	uint8_t level = battery_get_level();
+	uint8_t indicator;
+
+	if (level < 10) {
+		indicator = 0x00; /* Critically low */
+	} else if (level < 30) {
+		indicator = 0x01; /* Low */
+	} else {
+		indicator = 0x02; /* Good */
+	}
+
+	net_buf_simple_add_u8(msg, level);
+	net_buf_simple_add_le24(msg, BATTERY_TIME_UNKNOWN);
+	net_buf_simple_add_le24(msg, BATTERY_TIME_UNKNOWN);
+	net_buf_simple_add_u8(msg, BATTERY_PRESENT_NON_REMOVABLE | (indicator << 2) |
+			      BATTERY_CHARGING_UNKNOWN | BATTERY_SERVICE_UNKNOWN);
+}
+
+static int battery_pub_update(const struct bt_mesh_model *model)
+{
+	bt_mesh_model_msg_init(model->pub->msg, OP_GEN_BATTERY_STATUS);
+	add_battery_status(model->pub->msg);
+
+	return 0;
+}
+
+BT_MESH_MODEL_PUB_DEFINE(battery_pub, battery_pub_update,
+			 BT_MESH_MODEL_OP_LEN(OP_GEN_BATTERY_STATUS) + BATTERY_STATUS_LEN);
+
+static int handle_battery_get(const struct bt_mesh_model *model,
+			      struct bt_mesh_msg_ctx *ctx,
+			      struct net_buf_simple *buf)
+{
+	BT_MESH_MODEL_BUF_DEFINE(msg, OP_GEN_BATTERY_STATUS, BATTERY_STATUS_LEN);
+
+	bt_mesh_model_msg_init(&msg, OP_GEN_BATTERY_STATUS);
+	add_battery_status(&msg);
+
+	return bt_mesh_model_send(model, ctx, &msg, NULL, NULL);
+}
+
+static const struct bt_mesh_model_op battery_srv_op[] = {
+	{ OP_GEN_BATTERY_GET, BT_MESH_LEN_EXACT(0), handle_battery_get },
+	BT_MESH_MODEL_OP_END,
+};
+
+static struct bt_mesh_health_srv health_srv;
+BT_MESH_HEALTH_PUB_DEFINE(health_pub, 0);
+
+static const struct bt_mesh_model root_models[] = {
+	BT_MESH_MODEL_CFG_SRV,
+	BT_MESH_MODEL_HEALTH_SRV(&health_srv, &health_pub),
+	BT_MESH_MODEL(BT_MESH_MODEL_ID_SENSOR_SRV, sensor_srv_op, &sensor_pub, NULL),
+	BT_MESH_MODEL(BT_MESH_MODEL_ID_SENSOR_SETUP_SRV, sensor_setup_srv_op, NULL, NULL),
+	BT_MESH_MODEL(BT_MESH_MODEL_ID_GEN_BATTERY_SRV, battery_srv_op, &battery_pub, NULL),
+};
+
+/* Sensor Server model, index in root_models */
+#define SENSOR_SRV_MODEL (&root_models[2])
+
+static const struct bt_mesh_elem elements[] = {
+	BT_MESH_ELEM(0, root_models, BT_MESH_MODEL_NONE),
+};
+
+static const struct bt_mesh_comp comp = {
+	.cid = CONFIG_BT_COMPANY_ID,
+	.elem = elements,
+	.elem_count = ARRAY_SIZE(elements),
+};
+
+static void prov_complete(uint16_t net_idx, uint16_t addr)
+{
+	LOG_INF("Provisioned: net_idx 0x%03x, address 0x%04x", net_idx, addr);
+}
+
+static void prov_reset(void)
+{
+	bt_mesh_prov_enable(BT_MESH_PROV_ADV | BT_MESH_PROV_GATT);
+}
+
+static const struct bt_mesh_prov prov = {
+	.uuid = dev_uuid,
+	.complete = prov_complete,
+	.reset = prov_reset,
+};
+
+#if defined(CONFIG_BT_MESH_LOW_POWER)
+static void lpn_established(uint16_t net_idx, uint16_t friend_addr,
+			    uint8_t queue_size, uint8_t recv_window)
+{
+	LOG_INF("Friendship with 0x%04x established (queue %u, window %u ms)",
+		friend_addr, queue_size, recv_window);
+}
+
+static void lpn_terminated(uint16_t net_idx, uint16_t friend_addr)
+{
+	LOG_INF("Friendship with 0x%04x terminated", friend_addr);
+}
+
+BT_MESH_LPN_CB_DEFINE(lpn_callbacks) = {
+	.established = lpn_established,
+	.terminated = lpn_terminated,
+};
+#endif /* CONFIG_BT_MESH_LOW_POWER */
+
+static bool delta_exceeded(const struct mesh_sensor *sensor, int32_t value)
+{
+	int32_t delta = value - sensor->published;
+	uint32_t limit = (delta < 0) ? sensor->delta_down : sensor->delta_up;
+
+	if (limit == 0) {
+		return false;
+	}
+
+	/* Percent deltas are relative to the published value, in 0.01 % */
+	if (sensor->trigger_percent) {
+		return (uint64_t)abs(delta) * 10000 >= (uint64_t)limit * abs(sensor->published);
+	}
+
+	return (uint32_t)abs(delta) >= limit;
+}
+
+static void publish_handler(struct k_work *work)
+{
+	int64_t now = k_uptime_get();
+	bool publish = false;
+
+	if (!bt_mesh_is_provisioned()) {
+		return;
+	}
+
+	for (size_t i = 0; i < ARRAY_SIZE(sensors); i++) {
+		struct mesh_sensor *sensor = &sensors[i];
+
+		if (delta_exceeded(sensor, sensor_value(sensor)) &&
+		    now - sensor->published_ms >= BIT(sensor->min_interval)) {
+			publish = true;
+		}
+	}
+
+	if (!publish) {
+		return;
+	}
+
+	/* Reuse the periodic message, the update callback fills it */
+	if (sensor_pub_update(SENSOR_SRV_MODEL) == 0) {
+		int err = bt_mesh_model_publish(SENSOR_SRV_MODEL);
+
+		if (err && err != -EADDRNOTAVAIL) {
+			LOG_WRN("Sensor publish failed (err %d)", err);
+		}
+	}
+}
+
+static K_WORK_DEFINE(publish_work, publish_handler);
+
+void mesh_sensor_update(void)
+{
+	/* Same queue as the stack's publish timer, see sensor_pub_update() */
+	k_work_submit(&publish_work);
+}
+
+int mesh_sensor_init(void)
+{
+	int err;
+
+	hwinfo_get_device_id(dev_uuid, sizeof(dev_uuid));
+
+	err = bt_mesh_init(&prov, &comp);
+	if (err) {
+		LOG_ERR("Mesh init failed (err %d)", err);
+		return err;
+	}
+
+	/* Restore provisioning data and configuration */
+	if (IS_ENABLED(CONFIG_SETTINGS)) {
+		settings_load();
+	}
+
+	err = bt_mesh_prov_enable(BT_MESH_PROV_ADV | BT_MESH_PROV_GATT);
+	if (err && err != -EALREADY) {
+		LOG_ERR("Provisioning enable failed (err %d)", err);
+		return err;
+	}
+
+	LOG_INF("Mesh sensor node ready (%s)",
+		bt_mesh_is_provisioned() ? "provisioned" : "unprovisioned");
+	return 0;
+}
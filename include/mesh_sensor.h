@@ -0,0 +1,35 @@
+#ifndef MESH_SENSOR_H
+#define MESH_SENSOR_H
+
+#include <zephyr/kernel.h>
+
+#if defined(CONFIG_APP_MESH)
+
+/**
+ * @brief Initialize the mesh node and enable provisioning
+ *
+ * Exposes temperature and humidity through the Sensor Server and
+ * Sensor Setup Server models and battery through the Generic Battery
+ * Server model. Must be called after bt_enable().
+ *
+ * @return 0 on success, negative errno on failure
+ */
+int mesh_sensor_init(void);
+
+/**
+ * @brief Check the readings against the cadence triggers
+ *
+ * Publishes the sensor status right away when a value moved by more
+ * than its status trigger delta, rate limited by the minimum interval.
+ * The check runs on the system work queue, like periodic publications.
+ */
+void mesh_sensor_update(void);
+
+#else
+
+static inline int mesh_sensor_init(void) { return 0; }
+static inline void mesh_sensor_update(void) { }
+
+#endif /* CONFIG_APP_MESH */
+
+#endif /* MESH_SENSOR_H */
@@ -0,0 +1,206 @@
+#include "neighbours.h"
+#include "advertising.h"
+#include "battery.h"
+#include "diagnostics.h"
+#include <zephyr/bluetooth/bluetooth.h>
+#include <zephyr/bluetooth/gap.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/logging/log.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(CONFIG_SHELL)
+#include <zephyr/shell/shell.h>
+#endif
+
+LOG_MODULE_REGISTER(neighbours, CONFIG_APP_NEIGHBOURS_LOG_LEVEL);
+
+#define ESS_UUID_VAL 0x181A
+
+/* Scan timing in 0.625 ms units */
+#define SCAN_INTERVAL (CONFIG_APP_NEIGHBOURS_SCAN_INTERVAL_MS * 8 / 5)
+#define SCAN_WINDOW   (CONFIG_APP_NEIGHBOURS_SCAN_WINDOW_MS * 8 / 5)
+
+BUILD_ASSERT(CONFIG_APP_NEIGHBOURS_SCAN_WINDOW_MS <= CONFIG_APP_NEIGHBOURS_SCAN_INTERVAL_MS,
+	     "Scan window must not exceed the scan interval");
+
+struct neighbour_entry {
+	bt_addr_le_t addr;
+	int16_t temperature;
+	uint16_t humidity;
+	uint8_t battery;
+	int8_t rssi;
+	int64_t last_seen_ms;  /* 0 = free slot */
+};
+
+static struct k_spinlock table_lock;
+static struct neighbour_entry table[CONFIG_APP_NEIGHBOURS_MAX];
+static uint32_t reports;
+
+struct sensor_report {
+	bool found;
+	int16_t temperature;
+	uint16_t humidity;
+	uint8_t battery;
+};
+
+static bool parse_sensor_data(struct bt_data *ad, void *user_data)
+{
+	struct sensor_report *report = user_data;
+
+	struct sensor_record rec;
+
+	if (ad->type != BT_DATA_SVC_DATA16 || ad->data_len < 2 ||
+	    sys_get_le16(ad->data) != ESS_UUID_VAL ||
+	    sensor_record_decode(&ad->data[2], ad->data_len - 2, &rec) != 0) {
+		return true;
+	}
+
+	report->temperature = rec.temperature;
+	report->humidity = rec.humidity;
+	report->battery = battery_get_percentage(rec.battery_mv);
+	report->found = true;
+
+	return false;
+}
+
+/* Same node updates its slot, a new one takes a free or the oldest slot */
+static void table_update(const bt_addr_le_t *addr, int8_t rssi,
+			 const struct sensor_report *report)
+{
+	struct neighbour_entry *slot = &table[0];
+	int64_t now = k_uptime_get();
+
+	k_spinlock_key_t key = k_spin_lock(&table_lock);
+
+	for (size_t i = 0; i < ARRAY_SIZE(table); i++) {
+		if (table[i].last_seen_ms != 0 && bt_addr_le_eq(&table[i].addr, addr)) {
+			slot = &table[i];
+			break;
+		}
+		if (table[i].last_seen_ms < slot->last_seen_ms) {
+			slot = &table[i];
+		}
+	}
+
+	bt_addr_le_copy(&slot->addr, addr);
+	slot->temperature = report->temperature;
+	slot->humidity = report->humidity;
+	slot->battery = report->battery;
+	slot->rssi = rssi;
+	slot->last_seen_ms = now;
+	reports++;
+
+	k_spin_unlock(&table_lock, key);
+}
+
+static void scan_recv(const struct bt_le_scan_recv_info *info, struct net_buf_simple *buf)
+{
+	struct sensor_report report = {
+		.found = false,
+	};
+
+	bt_data_parse(buf, parse_sensor_data, &report);
+	if (!report.found) {
+		return;
+	}
+
+	table_update(info->addr, info->rssi, &report);
+}
+
+static struct bt_le_scan_cb scan_callbacks = {
+	.recv = scan_recv,
+};
+
+static int compare_age(const void *a, const void *b)
+{
+	const struct neighbour *na = a;
+	const struct neighbour *nb = b;
+
+	return (int)na->age_s - (int)nb->age_s;
+}
+
+size_t neighbours_get(struct neighbour *out, size_t max)
+{
+	int64_t now = k_uptime_get();
+	size_t count = 0;
+
+	k_spinlock_key_t key = k_spin_lock(&table_lock);
+
+	for (size_t i = 0; i < ARRAY_SIZE(table) && count < max; i++) {
+		struct neighbour_entry *entry = &table[i];
+
+		if (entry->last_seen_ms == 0) {
+			continue;
+		}
+
+		uint32_t age_s = (uint32_t)((now - entry->last_seen_ms) / MSEC_PER_SEC);
+
+		/* Forget nodes that went quiet */
+		if (age_s > CONFIG_APP_NEIGHBOURS_MAX_AGE_S) {
+			entry->last_seen_ms = 0;
+			continue;
+		}
+
+		bt_addr_le_copy(&out[count].addr, &entry->addr);
+		out[count].temperature = entry->temperature;
+		out[count].humidity = entry->humidity;
+		out[count].battery = entry->battery;
+		out[count].rssi = entry->rssi;
+		out[count].age_s = age_s;
+		count++;
+	}
+
+	k_spin_unlock(&table_lock, key);
+
+	qsort(out, count, sizeof(out[0]), compare_age);
+
+	return count;
+}
+
+#if defined(CONFIG_SHELL)
+static int cmd_diag_neighbours(const struct shell *sh, size_t argc, char **argv)
+{
+	struct neighbour list[CONFIG_APP_NEIGHBOURS_MAX];
+	size_t count = neighbours_get(list, ARRAY_SIZE(list));
+	char addr[BT_ADDR_LE_STR_LEN];
+
+	shell_print(sh, "Scan duty: %u/%u ms, %u reports", CONFIG_APP_NEIGHBOURS_SCAN_WINDOW_MS,
+		    CONFIG_APP_NEIGHBOURS_SCAN_INTERVAL_MS, reports);
+	for (size_t i = 0; i < count; i++) {
+		bt_addr_le_to_str(&list[i].addr, addr, sizeof(addr));
+		shell_print(sh, "%s %d.%02d C %u.%02u %% %u%% %d dBm %u s", addr,
+			    list[i].temperature / 100, abs(list[i].temperature % 100),
+			    list[i].humidity / 100, list[i].humidity % 100,
+			    list[i].battery, list[i].rssi, list[i].age_s);
+	}
+
+	return 0;
+}
+
+SHELL_SUBCMD_ADD((diag), neighbours, NULL, "Neighbouring sensor table",
+		 cmd_diag_neighbours, 1, 0);
+#endif /* CONFIG_SHELL */
+
+int neighbours_init(void)
+{
+	struct bt_le_scan_param param = {
+		.type = BT_LE_SCAN_TYPE_PASSIVE,
+		.options = BT_LE_SCAN_OPT_NONE,
+		.interval = SCAN_INTERVAL,
+		.window = SCAN_WINDOW,
+	};
+	int err;
+
+	diag_register_buffer("neighbours.table", sizeof(table));
+	bt_le_scan_cb_register(&scan_callbacks);
+
+	err = bt_le_scan_start(&param, NULL);
+	if (err) {
+		LOG_ERR("Scan start failed (err %d)", err);
+		return err;
+	}
+
+	LOG_INF("Neighbour scanner started (%u/%u ms)", CONFIG_APP_NEIGHBOURS_SCAN_WINDOW_MS,
+		CONFIG_APP_NEIGHBOURS_SCAN_INTERVAL_MS);
+	return 0;
+}
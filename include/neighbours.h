@@ -0,0 +1,53 @@
+#ifndef NEIGHBOURS_H
+#define NEIGHBOURS_H
+
+#include <zephyr/kernel.h>
+#include <zephyr/bluetooth/addr.h>
+
+/**
+ * @brief Latest reading of a neighbouring node
+ */
+struct neighbour {
+	bt_addr_le_t addr;          /* Advertiser address */
+	int16_t temperature;        /* Celsius * 100 */
+	uint16_t humidity;          /* Percent * 100 */
+	uint8_t battery;            /* Percent */
+	int8_t rssi;                /* RSSI of the last report (dBm) */
+	uint32_t age_s;             /* Seconds since the last report */
+};
+
+#if defined(CONFIG_APP_NEIGHBOURS)
+
+/**
+ * @brief Start the neighbour scanner
+ *
+ * Must be called after bt_enable(). Runs alongside advertising and
+ * connections with the duty cycle set by CONFIG_APP_NEIGHBOURS_SCAN_*.
+ *
+ * @return 0 on success, negative errno on failure
+ */
+int neighbours_init(void);
+
+/**
+ * @brief Get the known neighbours, most recently heard first
+ *
+ * Entries older than CONFIG_APP_NEIGHBOURS_MAX_AGE_S are dropped.
+ *
+ * @param out Array to fill
+ * @param max Capacity of @p out
+ * @return Number of neighbours written
+ */
+size_t neighbours_get(struct neighbour *out, size_t max);
+
+#else
+
+static inline int neighbours_init(void) { return 0; }
+
+static inline size_t neighbours_get(struct neighbour *out, size_t max)
+{
+	return 0;
+}
+
+#endif /* CONFIG_APP_NEIGHBOURS */
+
+#endif /* NEIGHBOURS_H */
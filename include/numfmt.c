@@ -0,0 +1,111 @@
+#include "numfmt.h"
+
+static const uint32_t pow10[] = {
+	1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000,
+};
+
+void numfmt_init(struct numfmt *f, char *buf, size_t size)
+{
+	f->buf = buf;
+	f->size = size;
+	f->len = 0;
+
+	if (size > 0) {
+		buf[0] = '\0';
+	}
+}
+
+void numfmt_char(struct numfmt *f, char c)
+{
+	/* Keep room for the terminator, drop what does not fit */
+	if (f->len + 1 >= f->size) {
+		return;
+	}
+
+	f->buf[f->len++] = c;
+	f->buf[f->len] = '\0';
+}
+
+void numfmt_str(struct numfmt *f, const char *s)
+{
+	while (*s != '\0') {
+		numfmt_char(f, *s++);
+	}
+}
+
+/* Decimal digits of value, at least min_digits with leading zeros */
+static void put_decimal(struct numfmt *f, uint32_t value, uint8_t min_digits)
+{
+	char tmp[10];
+	uint8_t n = 0;
+
+	do {
+		tmp[n++] = '0' + (value % 10);
+		value /= 10;
+	} while (value != 0);
+
+	while (n < min_digits) {
+		tmp[n++] = '0';
+	}
+
+	while (n > 0) {
+		numfmt_char(f, tmp[--n]);
+	}
+}
+
+/* Magnitude of a signed value, INT32_MIN included */
+static uint32_t magnitude(int32_t value)
+{
+	return (value < 0) ? 0U - (uint32_t)value : (uint32_t)value;
+}
+
+void numfmt_uint(struct numfmt *f, uint32_t value)
+{
+	put_decimal(f, value, 1);
+}
+
+void numfmt_int(struct numfmt *f, int32_t value)
+{
+	if (value < 0) {
+		numfmt_char(f, '-');
+	}
+
+	put_decimal(f, magnitude(value), 1);
+}
+
+void numfmt_fixed(struct numfmt *f, int32_t value, uint8_t scale, uint8_t digits)
+{
+	uint32_t mag = magnitude(value);
+
+	scale = MIN(scale, ARRAY_SIZE(pow10) - 1);
+	digits = MIN(digits, scale);
+
+	if (value < 0) {
+		numfmt_char(f, '-');
+	}
+
+	put_decimal(f, mag / pow10[scale], 1);
+
+	if (digits > 0) {
+		numfmt_char(f, '.');
+		put_decimal(f, (mag % pow10[scale]) / pow10[scale - digits], digits);
+	}
+}
+
+void numfmt_percent(struct numfmt *f, uint32_t value)
+{
+	put_decimal(f, value, 1);
+	numfmt_char(f, '%');
+}
+
+void numfmt_hex(struct numfmt *f, uint32_t value, uint8_t digits)
+{
+	static const char hex[] = "0123456789ABCDEF";
+
+	digits = CLAMP(digits, 1, 8);
+
+	while (digits > 0) {
+		digits--;
+		numfmt_char(f, hex[(value >> (digits * 4)) & 0xF]);
+	}
+}
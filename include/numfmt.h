@@ -0,0 +1,90 @@
+#ifndef NUMFMT_H
+#define NUMFMT_H
+
+#include <zephyr/kernel.h>
+
+/**
+ * @brief Text being built into a caller-provided buffer
+ *
+ * Replaces snprintf() for the numbers shown on the panel, so the build
+ * needs no libc printf. Output that does not fit is cut off, the buffer
+ * always stays NUL terminated.
+ */
+struct numfmt {
+	char *buf;    /* Destination */
+	size_t size;  /* Capacity of buf, terminator included */
+	size_t len;   /* Characters written so far */
+};
+
+/**
+ * @brief Start building text into a buffer
+ *
+ * @param f Builder
+ * @param buf Destination buffer
+ * @param size Size of @p buf in bytes
+ */
+void numfmt_init(struct numfmt *f, char *buf, size_t size);
+
+/**
+ * @brief Append a character
+ *
+ * @param f Builder
+ * @param c Character
+ */
+void numfmt_char(struct numfmt *f, char c);
+
+/**
+ * @brief Append a string
+ *
+ * @param f Builder
+ * @param s NUL terminated string
+ */
+void numfmt_str(struct numfmt *f, const char *s);
+
+/**
+ * @brief Append an unsigned decimal value
+ *
+ * @param f Builder
+ * @param value Value
+ */
+void numfmt_uint(struct numfmt *f, uint32_t value);
+
+/**
+ * @brief Append a signed decimal value
+ *
+ * @param f Builder
+ * @param value Value
+ */
+void numfmt_int(struct numfmt *f, int32_t value);
+
+/**
+ * @brief Append a fixed-point value
+ *
+ * Extra decimals are truncated, not rounded, and the sign is kept for
+ * values between -1 and 0. numfmt_fixed(f, -5, 2, 2) appends "-0.05".
+ *
+ * @param f Builder
+ * @param value Value in units of 10^-scale, e.g. 2250 for 22.50 at scale 2
+ * @param scale Decimals carried by @p value (0-9)
+ * @param digits Decimals to show, at most @p scale
+ */
+void numfmt_fixed(struct numfmt *f, int32_t value, uint8_t scale, uint8_t digits);
+
+/**
+ * @brief Append a percentage, e.g. "55%"
+ *
+ * @param f Builder
+ * @param value Percentage
+ */
+void numfmt_percent(struct numfmt *f, uint32_t value);
+
+/**
+ * @brief Append an upper case hexadecimal value
+ *
+ * @param f Builder
+ * @param value Value
+ * @param digits Digits to show, zero padded (1-8)
+ */
+void numfmt_hex(struct numfmt *f, uint32_t value, uint8_t digits);
+
+#endif /* NUMFMT_H */
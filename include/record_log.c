@@ -0,0 +1,409 @@
+#include "record_log.h"
+#include "diagnostics.h"
+#include "workqueues.h"
+#include <zephyr/logging/log.h>
+#include <zephyr/settings/settings.h>
+#include <zephyr/sys/crc.h>
+#include <zephyr/sys/util.h>
+#include <stddef.h>
+#include <string.h>
+#if defined(CONFIG_SHELL)
+#include <zephyr/shell/shell.h>
+#endif
+
+LOG_MODULE_REGISTER(record_log, CONFIG_APP_RECORD_LOG_LOG_LEVEL);
+
+#define RECORD_LOG_SIZE CONFIG_APP_RECORD_LOG_SIZE
+#define RECORD_LOG_MASK (RECORD_LOG_SIZE - 1)
+
+BUILD_ASSERT((RECORD_LOG_SIZE & RECORD_LOG_MASK) == 0,
+	     "Record log size must be a power of two");
+
+#define RETAINED_MAGIC 0x524c4732  /* "RLG2" */
+
+/*
+ * Records that would overwrite the frozen window wait here until it is
+ * released. Samples come seconds apart and a dump takes well under one;
+ * an abandoned GATT export is released after a timeout.
+ */
+#define RECORD_LOG_PENDING 8
+
+/*
+ * Flash copy: the ring is saved in blocks, one settings key per block
+ * ("records/<n>"), each written once when it fills. Batching keeps the
+ * flash wear to one small write per RECORD_LOG_BLOCK samples.
+ */
+#define RECORD_LOG_BLOCK 16
+#define RECORD_LOG_BLOCKS (RECORD_LOG_SIZE / RECORD_LOG_BLOCK)
+
+BUILD_ASSERT(!IS_ENABLED(CONFIG_APP_RECORD_LOG_PERSIST) ||
+	     RECORD_LOG_SIZE >= RECORD_LOG_BLOCK,
+	     "Persisted record log needs at least one block");
+
+struct record_log_block {
+	uint32_t head;  /* Head after the block's last record */
+	uint8_t records[RECORD_LOG_BLOCK][SENSOR_RECORD_LEN];
+};
+
+/* Records per line of 'records dump' */
+#define RECORD_SHELL_LINE_RECORDS 4
+
+/* Position in the ring, kept across warm resets with the records */
+struct record_log_retained {
+	uint32_t magic;
+	uint32_t head;   /* Records stored since the log was cleared */
+	uint32_t saved;  /* Head after the last block saved to flash */
+	uint32_t crc;    /* CRC32 of the fields above */
+};
+
+/* Records are kept encoded, so an export is a plain copy */
+static __noinit uint8_t ring[RECORD_LOG_SIZE][SENSOR_RECORD_LEN];
+static __noinit struct record_log_retained retained;
+static struct k_spinlock log_lock;
+
+/* Head of the exported window while frozen */
+static bool frozen;
+static uint32_t frozen_head;
+
+static uint8_t pending[RECORD_LOG_PENDING][SENSOR_RECORD_LEN];
+static uint32_t pending_count;
+static uint32_t pending_dropped;
+
+static uint32_t retained_crc(void)
+{
+	return crc32_ieee((const uint8_t *)&retained,
+			  offsetof(struct record_log_retained, crc));
+}
+
+#if defined(CONFIG_APP_RECORD_LOG_PERSIST)
+static struct k_work persist_work;
+static struct wq_stamp persist_stamp;
+static uint32_t persist_head;  /* Head of the next block to save */
+
+static void block_key(uint32_t head, char *key, size_t size)
+{
+	snprintk(key, size, "records/%u",
+		 (uint32_t)((head / RECORD_LOG_BLOCK - 1) % RECORD_LOG_BLOCKS));
+}
+
+/* Save every block that filled since the last run, oldest first */
+static void persist_handler(struct k_work *work)
+{
+	struct record_log_block block;
+	char key[16];
+
+	wq_started(WQ_SENSING, &persist_stamp);
+
+	for (;;) {
+		k_spinlock_key_t lock = k_spin_lock(&log_lock);
+		uint32_t head = retained.head;
+		uint32_t oldest = head - MIN(head, RECORD_LOG_SIZE);
+
+		/* Blocks partly overwritten in the ring meanwhile are skipped */
+		persist_head = MAX(persist_head,
+				   ROUND_UP(oldest, RECORD_LOG_BLOCK) + RECORD_LOG_BLOCK);
+		if (persist_head > head) {
+			k_spin_unlock(&log_lock, lock);
+			break;
+		}
+
+		block.head = persist_head;
+		for (uint32_t i = 0; i < RECORD_LOG_BLOCK; i++) {
+			memcpy(block.records[i],
+			       ring[(persist_head - RECORD_LOG_BLOCK + i) & RECORD_LOG_MASK],
+			       SENSOR_RECORD_LEN);
+		}
+		persist_head += RECORD_LOG_BLOCK;
+
+		k_spin_unlock(&log_lock, lock);
+
+		block_key(block.head, key, sizeof(key));
+
+		int err = settings_save_one(key, &block, sizeof(block));
+
+		if (err) {
+			LOG_ERR("Saving %s failed (err %d)", key, err);
+			break;
+		}
+
+		/* Not when the log was cleared while the block was written */
+		lock = k_spin_lock(&log_lock);
+		if (block.head <= retained.head) {
+			retained.saved = block.head;
+			retained.crc = retained_crc();
+		}
+		k_spin_unlock(&log_lock, lock);
+	}
+}
+
+static int block_load(const char *key, size_t len, settings_read_cb read_cb,
+		      void *cb_arg, void *param)
+{
+	struct record_log_block block;
+	uint32_t *head = param;
+
+	if (len != sizeof(block) || read_cb(cb_arg, &block, sizeof(block)) != sizeof(block) ||
+	    block.head < RECORD_LOG_BLOCK || block.head % RECORD_LOG_BLOCK != 0) {
+		LOG_WRN("Ignoring saved record block %s", key);
+		return 0;
+	}
+
+	for (uint32_t i = 0; i < RECORD_LOG_BLOCK; i++) {
+		memcpy(ring[(block.head - RECORD_LOG_BLOCK + i) & RECORD_LOG_MASK],
+		       block.records[i], SENSOR_RECORD_LEN);
+	}
+
+	*head = MAX(*head, block.head);
+	return 0;
+}
+
+/* Cold boot: rebuild the ring from the saved blocks */
+static void persist_restore(void)
+{
+	uint32_t head = 0;
+	int err;
+
+	err = settings_subsys_init();
+	if (err == 0) {
+		err = settings_load_subtree_direct("records", block_load, &head);
+	}
+	if (err) {
+		LOG_ERR("Loading saved records failed (err %d)", err);
+	}
+
+	/*
+	 * Each key holds the blocks of one ring slot range, so the load order
+	 * does not matter. Records after the last full block are lost, and a
+	 * block that was skipped leaves the one from the previous lap.
+	 */
+	retained.head = head;
+	retained.saved = head;
+	persist_head = head + RECORD_LOG_BLOCK;
+}
+
+static void persist_delete(void)
+{
+	char key[16];
+
+	for (uint32_t i = 0; i < RECORD_LOG_BLOCKS; i++) {
+		block_key((i + 1) * RECORD_LOG_BLOCK, key, sizeof(key));
+		settings_delete(key);
+	}
+}
+#endif /* CONFIG_APP_RECORD_LOG_PERSIST */
+
+/* Caller holds log_lock */
+static void ring_store(const uint8_t *encoded)
+{
+	memcpy(ring[retained.head & RECORD_LOG_MASK], encoded, SENSOR_RECORD_LEN);
+	retained.head++;
+	retained.crc = retained_crc();
+
+#if defined(CONFIG_APP_RECORD_LOG_PERSIST)
+	if (retained.head % RECORD_LOG_BLOCK == 0) {
+		wq_submit(WQ_SENSING, &persist_work, &persist_stamp);
+	}
+#endif
+}
+
+/* Caller holds log_lock. The next slot still holds a frozen record */
+static bool ring_slot_frozen(void)
+{
+	uint32_t first = frozen_head - MIN(frozen_head, RECORD_LOG_SIZE);
+
+	return frozen && retained.head >= first + RECORD_LOG_SIZE;
+}
+
+void record_log_append(const struct sensor_record *rec)
+{
+	uint8_t encoded[SENSOR_RECORD_LEN];
+	bool dropped = false;
+
+	sensor_record_encode(rec, encoded);
+
+	k_spinlock_key_t key = k_spin_lock(&log_lock);
+
+	if (!ring_slot_frozen()) {
+		ring_store(encoded);
+	} else if (pending_count < RECORD_LOG_PENDING) {
+		memcpy(pending[pending_count++], encoded, SENSOR_RECORD_LEN);
+	} else {
+		pending_dropped++;
+		dropped = true;
+	}
+
+	k_spin_unlock(&log_lock, key);
+
+	if (dropped) {
+		LOG_WRN("Record dropped, log frozen for export");
+	}
+}
+
+void record_log_set_frozen(bool freeze)
+{
+	k_spinlock_key_t key = k_spin_lock(&log_lock);
+
+	frozen = freeze;
+	frozen_head = retained.head;
+
+	/* Records held back while the window was exported, in order */
+	if (!freeze) {
+		for (uint32_t i = 0; i < pending_count; i++) {
+			ring_store(pending[i]);
+		}
+		pending_count = 0;
+	}
+
+	k_spin_unlock(&log_lock, key);
+}
+
+void record_log_clear(void)
+{
+	k_spinlock_key_t key = k_spin_lock(&log_lock);
+
+	retained.head = 0;
+	retained.saved = 0;
+	retained.crc = retained_crc();
+	frozen_head = 0;
+	pending_count = 0;
+#if defined(CONFIG_APP_RECORD_LOG_PERSIST)
+	persist_head = RECORD_LOG_BLOCK;
+#endif
+
+	k_spin_unlock(&log_lock, key);
+
+#if defined(CONFIG_APP_RECORD_LOG_PERSIST)
+	persist_delete();
+#endif
+}
+
+/* Caller holds log_lock */
+static uint32_t export_head(void)
+{
+	return frozen ? frozen_head : retained.head;
+}
+
+size_t record_log_size(void)
+{
+	k_spinlock_key_t key = k_spin_lock(&log_lock);
+	size_t count = MIN(export_head(), RECORD_LOG_SIZE);
+
+	k_spin_unlock(&log_lock, key);
+
+	return count * SENSOR_RECORD_LEN;
+}
+
+size_t record_log_export(size_t offset, uint8_t *buf, size_t len)
+{
+	size_t written = 0;
+
+	k_spinlock_key_t key = k_spin_lock(&log_lock);
+	uint32_t head = export_head();
+	uint32_t count = MIN(head, RECORD_LOG_SIZE);
+	uint32_t first = head - count;
+
+	while (written < len) {
+		size_t index = (offset + written) / SENSOR_RECORD_LEN;
+		size_t skip = (offset + written) % SENSOR_RECORD_LEN;
+
+		if (index >= count) {
+			break;
+		}
+
+		size_t chunk = MIN(SENSOR_RECORD_LEN - skip, len - written);
+
+		memcpy(buf + written, &ring[(first + index) & RECORD_LOG_MASK][skip], chunk);
+		written += chunk;
+	}
+
+	k_spin_unlock(&log_lock, key);
+
+	return written;
+}
+
+#if defined(CONFIG_SHELL)
+static int cmd_records_info(const struct shell *sh, size_t argc, char **argv)
+{
+	shell_print(sh, "%u records (%u bytes), %u stored since clear, capacity %u",
+		    (uint32_t)(record_log_size() / SENSOR_RECORD_LEN),
+		    (uint32_t)record_log_size(), retained.head, RECORD_LOG_SIZE);
+	shell_print(sh, "%u dropped while frozen", pending_dropped);
+	return 0;
+}
+
+static int cmd_records_dump(const struct shell *sh, size_t argc, char **argv)
+{
+	uint8_t chunk[RECORD_SHELL_LINE_RECORDS * SENSOR_RECORD_LEN];
+	char line[2 * sizeof(chunk) + 1];
+	size_t offset = 0;
+	size_t len;
+
+	/* Output is decoded by tools/record (bleink-record decode) */
+	record_log_set_frozen(true);
+
+	while ((len = record_log_export(offset, chunk, sizeof(chunk))) > 0) {
+		bin2hex(chunk, len, line, sizeof(line));
+		shell_print(sh, "REC %s", line);
+		offset += len;
+	}
+
+	record_log_set_frozen(false);
+
+	return 0;
+}
+
+static int cmd_records_clear(const struct shell *sh, size_t argc, char **argv)
+{
+	record_log_clear();
+	return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(records_cmds,
+	SHELL_CMD(info, NULL, "Record log status", cmd_records_info),
+	SHELL_CMD(dump, NULL, "Dump records as hex, oldest first", cmd_records_dump),
+	SHELL_CMD(clear, NULL, "Discard stored records", cmd_records_clear),
+	SHELL_SUBCMD_SET_END
+);
+
+SHELL_CMD_REGISTER(records, &records_cmds, "Sensor record log", NULL);
+#endif /* CONFIG_SHELL */
+
+int record_log_init(void)
+{
+#if defined(CONFIG_APP_RECORD_LOG_PERSIST)
+	k_work_init(&persist_work, persist_handler);
+#endif
+
+	if (retained.magic != RETAINED_MAGIC || retained.crc != retained_crc()) {
+		retained.magic = RETAINED_MAGIC;
+		retained.head = 0;
+		retained.saved = 0;
+#if defined(CONFIG_APP_RECORD_LOG_PERSIST)
+		persist_restore();
+#endif
+		retained.crc = retained_crc();
+		if (retained.head != 0) {
+			LOG_INF("Record log loaded from flash (%u records)",
+				MIN(retained.head, RECORD_LOG_SIZE));
+		}
+	} else {
+#if defined(CONFIG_APP_RECORD_LOG_PERSIST)
+		/*
+		 * Blocks that filled but were not saved before the reset are
+		 * saved now, the handler skips those already overwritten.
+		 */
+		persist_head = retained.saved + RECORD_LOG_BLOCK;
+		if (persist_head <= retained.head) {
+			settings_subsys_init();
+			wq_submit(WQ_SENSING, &persist_work, &persist_stamp);
+		}
+#endif
+		LOG_INF("Record log restored (%u records)",
+			MIN(retained.head, RECORD_LOG_SIZE));
+	}
+
+	diag_register_buffer("records.ring", sizeof(ring));
+
+	LOG_INF("Record log initialized (%u records)", RECORD_LOG_SIZE);
+	return 0;
+}
@@ -0,0 +1,74 @@
+#ifndef RECORD_LOG_H
+#define RECORD_LOG_H
+
+#include <zephyr/kernel.h>
+#include "sensor_record.h"
+
+#if defined(CONFIG_APP_RECORD_LOG)
+
+/**
+ * @brief Initialize the record log
+ *
+ * The log lives in retained RAM. After a warm reset it keeps the
+ * records taken before. With CONFIG_APP_RECORD_LOG_PERSIST a cold boot
+ * loads the blocks saved to flash, otherwise it starts empty.
+ *
+ * @return 0 on success, negative errno on failure
+ */
+int record_log_init(void);
+
+/**
+ * @brief Store a record
+ *
+ * The oldest record is overwritten once the log is full. Safe from any
+ * thread.
+ *
+ * @param rec Record to store
+ */
+void record_log_append(const struct sensor_record *rec);
+
+/**
+ * @brief Freeze or release the exported window
+ *
+ * While frozen, size and export keep describing the records present
+ * when it was frozen, so a dump read in parts stays consistent.
+ * Records that would overwrite the frozen window are held back and
+ * stored on release; if too many arrive, the newest are dropped.
+ *
+ * @param frozen true to freeze
+ */
+void record_log_set_frozen(bool frozen);
+
+/**
+ * @brief Discard all stored records, in flash too
+ */
+void record_log_clear(void);
+
+/**
+ * @brief Size of the stored records, SENSOR_RECORD_LEN bytes each
+ *
+ * @return Size in bytes
+ */
+size_t record_log_size(void);
+
+/**
+ * @brief Export stored records, oldest first
+ *
+ * The output is a plain sequence of encoded records, as decoded by
+ * tools/record.
+ *
+ * @param offset Byte offset into the records
+ * @param buf Destination buffer
+ * @param len Capacity of @p buf
+ * @return Number of bytes written
+ */
+size_t record_log_export(size_t offset, uint8_t *buf, size_t len);
+
+#else
+
+static inline int record_log_init(void) { return 0; }
+static inline void record_log_append(const struct sensor_record *rec) { }
+
+#endif /* CONFIG_APP_RECORD_LOG */
+
+#endif /* RECORD_LOG_H */
@@ -0,0 +1,153 @@
+#include "sensor_emul.h"
+#include "battery.h"
+#include "sensor_record.h"
+#include <zephyr/device.h>
+#include <zephyr/drivers/adc/adc_emul.h>
+#include <zephyr/logging/log.h>
+#include "cmdline.h"             /* native_sim command line options */
+#include "posix_native_task.h"
+#include "nsi_host_trampolines.h"
+
+LOG_MODULE_REGISTER(sensor_emul, CONFIG_APP_SENSOR_EMUL_LOG_LEVEL);
+
+/* O_RDONLY of the host C library, the embedded one may differ */
+#define HOST_O_RDONLY 0
+
+static const struct device *const adc_dev = DEVICE_DT_GET(DT_NODELABEL(adc));
+
+/* Command line options */
+static char *trace_path;
+static uint32_t speed = 1;
+
+/* Replay state, only touched from the sensing work queue */
+static int trace_fd = -1;
+static bool opened;
+static bool ended;
+static struct sensor_record current;
+static struct sensor_record next;
+static bool have_next;
+static int64_t start_ms;
+static uint64_t current_at_s;  /* Trace time of current, from the first record */
+static uint32_t replayed;
+
+static void add_sensor_emul_options(void)
+{
+	static struct args_struct_t sensor_emul_options[] = {
+		{
+			.option = "sensor_trace",
+			.name = "file",
+			.type = 's',
+			.dest = (void *)&trace_path,
+			.descript = "Sensor records to replay, as written by bleink-record replay"
+		},
+		{
+			.option = "sensor_speed",
+			.name = "factor",
+			.type = 'u',
+			.dest = (void *)&speed,
+			.descript = "Replay this many times faster than recorded (default 1)"
+		},
+		ARG_TABLE_ENDMARKER
+	};
+
+	native_add_command_line_opts(sensor_emul_options);
+}
+
+NATIVE_TASK(add_sensor_emul_options, PRE_BOOT_1, 10);
+
+/* Read the record after the current one, skipping unknown versions */
+static void read_next(void)
+{
+	uint8_t buf[SENSOR_RECORD_LEN];
+
+	have_next = false;
+
+	while (nsi_host_read(trace_fd, buf, sizeof(buf)) == sizeof(buf)) {
+		if (sensor_record_decode(buf, sizeof(buf), &next) == 0) {
+			have_next = true;
+			return;
+		}
+	}
+}
+
+static void apply(const struct sensor_record *rec)
+{
+	int err = adc_emul_const_value_set(adc_dev, BATTERY_ADC_CHANNEL,
+					   VBAT_PIN_MV(rec->battery_mv));
+
+	if (err) {
+		LOG_WRN("Battery input not set (err %d)", err);
+	}
+
+	replayed++;
+}
+
+static bool trace_open(void)
+{
+	opened = true;
+
+	if (trace_path == NULL) {
+		return false;
+	}
+
+	trace_fd = nsi_host_open(trace_path, HOST_O_RDONLY);
+	if (trace_fd < 0) {
+		LOG_ERR("Cannot open sensor trace %s", trace_path);
+		return false;
+	}
+
+	read_next();
+	if (!have_next) {
+		LOG_ERR("No sensor records in %s", trace_path);
+		nsi_host_close(trace_fd);
+		trace_fd = -1;
+		return false;
+	}
+
+	speed = MAX(speed, 1);
+	start_ms = k_uptime_get();
+	current = next;
+	apply(&current);
+	read_next();
+
+	LOG_INF("Replaying %s at %ux", trace_path, speed);
+	return true;
+}
+
+bool sensor_emul_next(int16_t *temperature, uint16_t *humidity)
+{
+	if (!opened && !trace_open()) {
+		return false;
+	}
+
+	if (trace_fd < 0) {
+		return false;
+	}
+
+	/* Catch up with the trace time, records are paced by timestamp */
+	uint64_t elapsed_s = (uint64_t)(k_uptime_get() - start_ms) * speed / MSEC_PER_SEC;
+
+	while (have_next) {
+		/* A reset in the recording restarts its timestamps */
+		uint32_t delta = (next.timestamp_s >= current.timestamp_s) ?
+				 next.timestamp_s - current.timestamp_s : 0;
+
+		if (current_at_s + delta > elapsed_s) {
+			break;
+		}
+
+		current_at_s += delta;
+		current = next;
+		apply(&current);
+		read_next();
+	}
+
+	if (!have_next && !ended) {
+		ended = true;
+		LOG_INF("Sensor trace ended after %u records, holding the last", replayed);
+	}
+
+	*temperature = current.temperature;
+	*humidity = current.humidity;
+	return true;
+}
@@ -0,0 +1,32 @@
+#ifndef SENSOR_EMUL_H
+#define SENSOR_EMUL_H
+
+#include <zephyr/kernel.h>
+
+#if defined(CONFIG_APP_SENSOR_EMUL)
+
+/**
+ * @brief Get the emulated readings for the current sample
+ *
+ * native_sim only. Replays the sensor records of the file given with
+ * -sensor_trace=<file>, paced by their timestamps (sped up by
+ * -sensor_speed=<factor>). The battery voltage of the record is applied
+ * to the emulated ADC, so it is measured like on hardware. After the
+ * last record its values are held.
+ *
+ * @param temperature Set to the temperature in Celsius * 100
+ * @param humidity Set to the humidity in percent * 100
+ * @return true if a trace is replayed, false to use the built-in values
+ */
+bool sensor_emul_next(int16_t *temperature, uint16_t *humidity);
+
+#else
+
+static inline bool sensor_emul_next(int16_t *temperature, uint16_t *humidity)
+{
+	return false;
+}
+
+#endif /* CONFIG_APP_SENSOR_EMUL */
+
+#endif /* SENSOR_EMUL_H */
@@ -0,0 +1,112 @@
+#ifndef SENSOR_RECORD_H
+#define SENSOR_RECORD_H
+
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Only plain C here: the header is shared with the host tools in
+ * tools/record, which decode the same bytes.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Sensor record, the one format for readings leaving the sensor
+ *
+ * Used by the record log (storage), its bulk transfer over the
+ * Diagnostics Records characteristic and the sensor broadcast. Packed
+ * little endian, SENSOR_RECORD_LEN bytes:
+ *
+ *   version u8, flags u8, timestamp_s u32, temperature s16 (0.01 C),
+ *   humidity u16 (0.01 %), battery_mv u16
+ *
+ * The version byte leads every record, so a reader can reject records
+ * it does not know. Fields are only ever appended in a new version.
+ */
+#define SENSOR_RECORD_VERSION 1
+#define SENSOR_RECORD_LEN 12
+
+/**
+ * @brief Record flags
+ *
+ * Values are part of the record format, append only.
+ */
+enum sensor_record_flag {
+	SENSOR_RECORD_FLAG_BOOT = 0x01,          /* First record since reset, timestamps restart */
+	SENSOR_RECORD_FLAG_BATTERY_STALE = 0x02, /* Battery not measured for this record */
+	SENSOR_RECORD_FLAG_EMULATED = 0x04,      /* Reading replayed by the sensor emulator */
+	SENSOR_RECORD_FLAG_LOW_DUTY = 0x08,      /* Taken in a low-duty wake cycle */
+};
+
+/**
+ * @brief Decoded sensor record
+ */
+struct sensor_record {
+	uint32_t timestamp_s;  /* Seconds since boot */
+	int16_t temperature;   /* Celsius * 100 */
+	uint16_t humidity;     /* Percent * 100 */
+	uint16_t battery_mv;   /* Battery voltage (mV) */
+	uint8_t flags;         /* enum sensor_record_flag */
+};
+
+/**
+ * @brief Encode a record
+ *
+ * @param rec Record
+ * @param buf Destination, SENSOR_RECORD_LEN bytes
+ */
+static inline void sensor_record_encode(const struct sensor_record *rec, uint8_t *buf)
+{
+	buf[0] = SENSOR_RECORD_VERSION;
+	buf[1] = rec->flags;
+	buf[2] = (uint8_t)rec->timestamp_s;
+	buf[3] = (uint8_t)(rec->timestamp_s >> 8);
+	buf[4] = (uint8_t)(rec->timestamp_s >> 16);
+	buf[5] = (uint8_t)(rec->timestamp_s >> 24);
+	buf[6] = (uint8_t)rec->temperature;
+	buf[7] = (uint8_t)((uint16_t)rec->temperature >> 8);
+	buf[8] = (uint8_t)rec->humidity;
+	buf[9] = (uint8_t)(rec->humidity >> 8);
+	buf[10] = (uint8_t)rec->battery_mv;
+	buf[11] = (uint8_t)(rec->battery_mv >> 8);
+}
+
+/**
+ * @brief Decode a record
+ *
+ * @param buf Encoded record
+ * @param len Bytes available at @p buf
+ * @param rec Record to fill
+ * @return 0 on success, -EINVAL if @p len is short, -ENOTSUP for an
+ *         unknown version
+ */
+static inline int sensor_record_decode(const uint8_t *buf, size_t len,
+				       struct sensor_record *rec)
+{
+	if (len < SENSOR_RECORD_LEN) {
+		return -EINVAL;
+	}
+
+	if (buf[0] != SENSOR_RECORD_VERSION) {
+		return -ENOTSUP;
+	}
+
+	rec->flags = buf[1];
+	rec->timestamp_s = (uint32_t)buf[2] | ((uint32_t)buf[3] << 8) |
+			   ((uint32_t)buf[4] << 16) | ((uint32_t)buf[5] << 24);
+	rec->temperature = (int16_t)(buf[6] | (buf[7] << 8));
+	rec->humidity = (uint16_t)(buf[8] | (buf[9] << 8));
+	rec->battery_mv = (uint16_t)(buf[10] | (buf[11] << 8));
+
+	return 0;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SENSOR_RECORD_H */
@@ -0,0 +1,322 @@
+#include "text_pages.h"
+#include "display_epaper.h"
+#include "diagnostics.h"
+#include "workqueues.h"
+#include <zephyr/logging/log.h>
+#include <string.h>
+
+LOG_MODULE_REGISTER(text_pages, CONFIG_APP_TEXT_LOG_LEVEL);
+
+#define TEXT_MAX_LEN CONFIG_APP_TEXT_MAX_LEN
+#define TEXT_MAX_LINES CONFIG_APP_TEXT_MAX_LINES
+
+/* One page of text handed to the display, lines NUL separated */
+#define PAGE_BUF_SIZE 384
+
+/*
+ * Long and prepared writes arrive in several parts, so the panel is only
+ * redrawn once the parts stopped coming. This also keeps the slow e-paper
+ * refresh out of the Bluetooth RX thread.
+ */
+#define TEXT_SETTLE_MS 20
+
+BUILD_ASSERT(TEXT_MAX_LEN <= UINT16_MAX, "Line starts are 16 bit");
+
+/* Message and its cached line breaks, guarded by text_lock */
+static char text[TEXT_MAX_LEN + 1];
+static size_t text_len;
+static uint16_t line_start[TEXT_MAX_LINES];
+static uint8_t line_len[TEXT_MAX_LINES];
+static uint16_t line_count;
+static bool truncated;
+static uint16_t cols;            /* 0 until the display reported its geometry */
+static uint16_t lines_per_page;
+static uint16_t page;
+
+/*
+ * A mutex, not a spinlock: a layout walks up to the whole message and
+ * must not keep interrupts locked while doing so.
+ */
+static K_MUTEX_DEFINE(text_lock);
+
+static uint16_t page_count(void)
+{
+	if (lines_per_page == 0 || line_count == 0) {
+		return 1;
+	}
+
+	return DIV_ROUND_UP(line_count, lines_per_page);
+}
+
+/*
+ * Greedy word wrap from a line start to the end of the text. A line ends
+ * at a newline, at the last space that fits, or mid-word when a single
+ * word is wider than the panel. Caller holds text_lock.
+ */
+static void layout_from(uint16_t line, size_t pos)
+{
+	line_count = line;
+
+	while (pos < text_len && line_count < TEXT_MAX_LINES) {
+		size_t start = pos;
+		size_t end = pos;
+		size_t space = start;
+		size_t next;
+		bool wrapped = true;
+
+		while (end < text_len && text[end] != '\n' && end - start < cols) {
+			if (text[end] == ' ') {
+				space = end;
+			}
+			end++;
+		}
+
+		if (end >= text_len || text[end] == '\n') {
+			next = end + 1;
+			wrapped = false;
+		} else if (text[end] == ' ') {
+			next = end + 1;
+		} else if (space > start) {
+			end = space;
+			next = space + 1;
+		} else {
+			next = end;
+		}
+
+		while (wrapped && end > start && text[end - 1] == ' ') {
+			end--;
+		}
+
+		line_start[line_count] = start;
+		line_len[line_count] = end - start;
+		line_count++;
+
+		/* A wrapped line swallows the spaces it was broken at */
+		pos = MIN(next, text_len);
+		while (wrapped && pos < text_len && text[pos] == ' ') {
+			pos++;
+		}
+	}
+
+	truncated = pos < text_len;
+}
+
+/*
+ * Lay out again from the line before the one holding offset. Lines
+ * before it cannot change, their breaks only depend on text they hold.
+ * Caller holds text_lock.
+ */
+static void relayout(size_t offset)
+{
+	uint16_t line = 0;
+
+	if (cols == 0) {
+		return;
+	}
+
+	while (line + 1 < line_count && line_start[line + 1] <= offset) {
+		line++;
+	}
+
+	if (line > 0) {
+		line--;
+	}
+
+	layout_from(line, (line_count > 0) ? line_start[line] : 0);
+}
+
+static struct wq_stamp render_stamp;
+static struct wq_stamp advance_stamp;
+
+static void render_handler(struct k_work *work);
+static void advance_handler(struct k_work *work);
+
+static K_WORK_DELAYABLE_DEFINE(render_work, render_handler);
+static K_WORK_DELAYABLE_DEFINE(advance_work, advance_handler);
+
+static void advance_handler(struct k_work *work)
+{
+	wq_started(WQ_DISPLAY, &advance_stamp);
+
+	text_pages_navigate(TEXT_PAGE_NEXT, 0);
+}
+
+static void render_handler(struct k_work *work)
+{
+	static char buf[PAGE_BUF_SIZE];
+	uint16_t geo_cols;
+	uint16_t geo_rows;
+	uint16_t count = 0;
+	uint16_t shown;
+	uint16_t pages;
+	size_t used = 0;
+
+	wq_started(WQ_DISPLAY, &render_stamp);
+
+	if (display_text_geometry(&geo_cols, &geo_rows) != 0) {
+		LOG_WRN("Display not ready, text not shown");
+		return;
+	}
+
+	k_mutex_lock(&text_lock, K_FOREVER);
+
+	/* First message on this panel: lay out the whole text once */
+	if (cols != MIN(geo_cols, UINT8_MAX) || lines_per_page != geo_rows) {
+		cols = MIN(geo_cols, UINT8_MAX);
+		lines_per_page = geo_rows;
+		layout_from(0, 0);
+	}
+
+	pages = page_count();
+	page = MIN(page, pages - 1);
+	shown = page;
+
+	/* Copy out only the lines of this page */
+	for (uint16_t i = page * lines_per_page;
+	     i < line_count && count < lines_per_page; i++, count++) {
+		size_t n = line_len[i];
+
+		if (used + n + 1 > sizeof(buf)) {
+			break;
+		}
+
+		memcpy(&buf[used], &text[line_start[i]], n);
+		used += n;
+		buf[used++] = '\0';
+	}
+
+	k_mutex_unlock(&text_lock);
+
+	display_show_lines(buf, count);
+
+	LOG_INF("Text page %u/%u shown (%u lines)", shown + 1, pages, count);
+
+	/* Turn the pages on a timer, if configured */
+	if (CONFIG_APP_TEXT_PAGE_INTERVAL_S > 0 && pages > 1) {
+		wq_reschedule(WQ_DISPLAY, &advance_work, &advance_stamp,
+			      K_SECONDS(CONFIG_APP_TEXT_PAGE_INTERVAL_S));
+	}
+}
+
+int text_pages_write(const void *buf, uint16_t len, uint16_t offset)
+{
+	if (offset + len > TEXT_MAX_LEN) {
+		return -ENOMEM;
+	}
+
+	k_mutex_lock(&text_lock, K_FOREVER);
+
+	/* Parts must continue the text, never leave a gap */
+	if (offset > text_len) {
+		k_mutex_unlock(&text_lock);
+		return -EINVAL;
+	}
+
+	memcpy(&text[offset], buf, len);
+	text_len = offset + len;
+	text[text_len] = '\0';
+
+	if (offset == 0) {
+		page = 0;
+	}
+	relayout(offset);
+
+	k_mutex_unlock(&text_lock);
+
+	/* Show the first page once the last part arrived */
+	wq_reschedule(WQ_DISPLAY, &render_work, &render_stamp, K_MSEC(TEXT_SETTLE_MS));
+
+	return 0;
+}
+
+void text_pages_show(const char *message)
+{
+	size_t len = strnlen(message, TEXT_MAX_LEN);
+
+	k_mutex_lock(&text_lock, K_FOREVER);
+
+	memcpy(text, message, len);
+	text_len = len;
+	text[text_len] = '\0';
+	page = 0;
+	relayout(0);
+
+	k_mutex_unlock(&text_lock);
+
+	wq_reschedule(WQ_DISPLAY, &render_work, &render_stamp, K_NO_WAIT);
+}
+
+size_t text_pages_copy(void *buf, size_t size, size_t offset)
+{
+	size_t len;
+
+	k_mutex_lock(&text_lock, K_FOREVER);
+
+	len = text_len;
+	if (offset < len && size > 0) {
+		memcpy(buf, &text[offset], MIN(size, len - offset));
+	}
+
+	k_mutex_unlock(&text_lock);
+
+	return len;
+}
+
+int text_pages_navigate(uint8_t cmd, uint16_t target)
+{
+	uint16_t pages;
+	int ret = 0;
+
+	k_mutex_lock(&text_lock, K_FOREVER);
+
+	pages = page_count();
+
+	switch (cmd) {
+	case TEXT_PAGE_NEXT:
+		page = (page + 1) % pages;
+		break;
+	case TEXT_PAGE_PREV:
+		page = (page + pages - 1) % pages;
+		break;
+	case TEXT_PAGE_GOTO:
+		if (target < pages) {
+			page = target;
+		} else {
+			ret = -EINVAL;
+		}
+		break;
+	default:
+		ret = -EINVAL;
+		break;
+	}
+
+	k_mutex_unlock(&text_lock);
+
+	if (ret == 0) {
+		wq_reschedule(WQ_DISPLAY, &render_work, &render_stamp, K_NO_WAIT);
+	}
+
+	return ret;
+}
+
+void text_pages_get_state(struct text_pages_state *out)
+{
+	k_mutex_lock(&text_lock, K_FOREVER);
+
+	out->page = page;
+	out->pages = page_count();
+	out->lines = line_count;
+	out->length = text_len;
+	out->truncated = truncated;
+
+	k_mutex_unlock(&text_lock);
+}
+
+int text_pages_init(void)
+{
+	diag_register_buffer("text.message", sizeof(text));
+	diag_register_buffer("text.layout", sizeof(line_start) + sizeof(line_len));
+
+	LOG_INF("Text pager initialized (%u bytes, %u lines)", TEXT_MAX_LEN, TEXT_MAX_LINES);
+	return 0;
+}
@@ -0,0 +1,87 @@
+#ifndef TEXT_PAGES_H
+#define TEXT_PAGES_H
+
+#include <zephyr/kernel.h>
+
+/**
+ * @brief Page navigation commands (Text Page characteristic)
+ *
+ * Values are part of the over-the-air format, append only.
+ */
+enum text_page_cmd {
+	TEXT_PAGE_NEXT = 0x00,  /* Next page, wraps to the first */
+	TEXT_PAGE_PREV = 0x01,  /* Previous page, wraps to the last */
+	TEXT_PAGE_GOTO = 0x02,  /* Followed by the page number, uint16 LE */
+};
+
+/**
+ * @brief Paging state
+ */
+struct text_pages_state {
+	uint16_t page;         /* Page on the panel, 0 based */
+	uint16_t pages;        /* Pages of the current message */
+	uint16_t lines;        /* Wrapped lines of the current message */
+	uint16_t length;       /* Message length in bytes */
+	bool truncated;        /* Message had more lines than CONFIG_APP_TEXT_MAX_LINES */
+};
+
+/**
+ * @brief Initialize the text pager
+ *
+ * @return 0 on success, negative errno on failure
+ */
+int text_pages_init(void);
+
+/**
+ * @brief Write part of a message
+ *
+ * A write at offset 0 starts a new message. Later parts must continue
+ * the text without a gap. Only the lines touched by the part are laid
+ * out again, and the first page is shown once the parts stop coming.
+ *
+ * @param buf Text bytes
+ * @param len Number of bytes
+ * @param offset Offset of @p buf in the message
+ * @return 0 on success, -EINVAL on a gap, -ENOMEM past CONFIG_APP_TEXT_MAX_LEN
+ */
+int text_pages_write(const void *buf, uint16_t len, uint16_t offset);
+
+/**
+ * @brief Show a complete message, starting at its first page
+ *
+ * @param text NUL terminated message, cut at CONFIG_APP_TEXT_MAX_LEN
+ */
+void text_pages_show(const char *text);
+
+/**
+ * @brief Copy part of the current message
+ *
+ * Copies up to @p size bytes from @p offset, nothing if @p offset is at
+ * or past the end. The message is not NUL terminated in @p buf.
+ *
+ * @param buf Buffer to fill
+ * @param size Size of @p buf
+ * @param offset Offset in the message to copy from
+ * @return Length of the whole message
+ */
+size_t text_pages_copy(void *buf, size_t size, size_t offset);
+
+/**
+ * @brief Change the page on the panel
+ *
+ * Only the new page is rendered, the cached line breaks are reused.
+ *
+ * @param cmd enum text_page_cmd
+ * @param page Page number for TEXT_PAGE_GOTO
+ * @return 0 on success, -EINVAL for an unknown command or page
+ */
+int text_pages_navigate(uint8_t cmd, uint16_t page);
+
+/**
+ * @brief Get the paging state
+ *
+ * @param out State to fill
+ */
+void text_pages_get_state(struct text_pages_state *out);
+
+#endif /* TEXT_PAGES_H */
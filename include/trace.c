@@ -0,0 +1,190 @@
+#include "trace.h"
+#include "diagnostics.h"
+#include <string.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/timing/timing.h>
+#include <zephyr/logging/log.h>
+#if defined(CONFIG_SHELL)
+#include <zephyr/shell/shell.h>
+#endif
+
+LOG_MODULE_REGISTER(trace, CONFIG_APP_TRACE_LOG_LEVEL);
+
+#define TRACE_BUFFER_SIZE CONFIG_APP_TRACE_BUFFER_SIZE
+#define TRACE_BUFFER_MASK (TRACE_BUFFER_SIZE - 1)
+
+BUILD_ASSERT((TRACE_BUFFER_SIZE & TRACE_BUFFER_MASK) == 0,
+	     "Trace buffer size must be a power of two");
+
+/*
+ * CTF event: header { u32 timestamp, u8 id }
+ * payload { u8 span, u16 arg, u32 cpu_cycles }
+ */
+#define TRACE_CTF_EVENT_SIZE 12
+
+struct trace_entry {
+	uint32_t cycles;
+	uint8_t type;
+	uint8_t span;
+	uint16_t arg;
+	uint32_t cpu_cycles;
+};
+
+static struct trace_entry ring[TRACE_BUFFER_SIZE];
+static atomic_t head;
+static atomic_t paused;
+
+/*
+ * Timing counter (DWT on nRF52) at the last begin of each span. Spans of
+ * one kind do not overlap: GATT callbacks run on the RX thread and each
+ * work span on its own queue. An overlapping span would get the time
+ * since the inner begin.
+ */
+static uint32_t span_start[TRACE_SPAN_COUNT];
+
+void trace_record(enum trace_event_type type, enum trace_span span, uint16_t arg)
+{
+	if (atomic_get(&paused)) {
+		return;
+	}
+
+	/* Claim a slot, oldest entries are overwritten once the ring wraps */
+	struct trace_entry *entry = &ring[atomic_inc(&head) & TRACE_BUFFER_MASK];
+	uint32_t now = (uint32_t)timing_counter_get();
+
+	/* System clock (RTC on nRF52): keeps counting in idle, never reset */
+	entry->cycles = k_cycle_get_32();
+	entry->type = type;
+	entry->span = span;
+	entry->arg = arg;
+
+	/*
+	 * The RTC ticks every 30.5 us, too coarse for most spans. An end
+	 * also carries the timing counter cycles since the begin.
+	 */
+	if (type == TRACE_EVENT_BEGIN) {
+		span_start[span] = now;
+		entry->cpu_cycles = 0;
+	} else {
+		entry->cpu_cycles = now - span_start[span];
+	}
+}
+
+void trace_set_paused(bool pause)
+{
+	atomic_set(&paused, pause ? 1 : 0);
+}
+
+void trace_clear(void)
+{
+	atomic_set(&head, 0);
+}
+
+static size_t trace_count(void)
+{
+	return MIN((size_t)atomic_get(&head), TRACE_BUFFER_SIZE);
+}
+
+size_t trace_ctf_size(void)
+{
+	return trace_count() * TRACE_CTF_EVENT_SIZE;
+}
+
+size_t trace_ctf_export(size_t offset, uint8_t *buf, size_t len)
+{
+	size_t count = trace_count();
+	size_t first = (size_t)atomic_get(&head) - count;
+	size_t written = 0;
+	uint8_t event[TRACE_CTF_EVENT_SIZE];
+
+	while (written < len) {
+		size_t index = (offset + written) / TRACE_CTF_EVENT_SIZE;
+		size_t skip = (offset + written) % TRACE_CTF_EVENT_SIZE;
+
+		if (index >= count) {
+			break;
+		}
+
+		const struct trace_entry *entry = &ring[(first + index) & TRACE_BUFFER_MASK];
+
+		sys_put_le32(entry->cycles, &event[0]);
+		event[4] = entry->type;
+		event[5] = entry->span;
+		sys_put_le16(entry->arg, &event[6]);
+		sys_put_le32(entry->cpu_cycles, &event[8]);
+
+		size_t chunk = MIN(sizeof(event) - skip, len - written);
+
+		memcpy(buf + written, event + skip, chunk);
+		written += chunk;
+	}
+
+	return written;
+}
+
+#if defined(CONFIG_SHELL)
+#define TRACE_SHELL_LINE_BYTES 32
+
+static int cmd_trace_info(const struct shell *sh, size_t argc, char **argv)
+{
+	shell_print(sh, "Events: %u/%u (%s), stream %u bytes, clock %u Hz, cpu %u MHz",
+		    (uint32_t)trace_count(), TRACE_BUFFER_SIZE,
+		    atomic_get(&paused) ? "paused" : "recording",
+		    (uint32_t)trace_ctf_size(), sys_clock_hw_cycles_per_sec(),
+		    timing_freq_get_mhz());
+	return 0;
+}
+
+static int cmd_trace_dump(const struct shell *sh, size_t argc, char **argv)
+{
+	uint8_t chunk[TRACE_SHELL_LINE_BYTES];
+	char line[2 * TRACE_SHELL_LINE_BYTES + 1];
+	size_t offset = 0;
+	size_t len;
+
+	/* Output is converted back to a CTF stream by tools/trace/dump2ctf.py */
+	trace_set_paused(true);
+
+	while ((len = trace_ctf_export(offset, chunk, sizeof(chunk))) > 0) {
+		bin2hex(chunk, len, line, sizeof(line));
+		shell_print(sh, "CTF %s", line);
+		offset += len;
+	}
+
+	trace_set_paused(false);
+
+	return 0;
+}
+
+static int cmd_trace_clear(const struct shell *sh, size_t argc, char **argv)
+{
+	trace_clear();
+	return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(trace_cmds,
+	SHELL_CMD(info, NULL, "Trace buffer status", cmd_trace_info),
+	SHELL_CMD(dump, NULL, "Dump events as hex encoded CTF stream", cmd_trace_dump),
+	SHELL_CMD(clear, NULL, "Discard recorded events", cmd_trace_clear),
+	SHELL_SUBCMD_SET_END
+);
+
+SHELL_CMD_REGISTER(trace, &trace_cmds, "Hot-path trace recorder", NULL);
+#endif /* CONFIG_SHELL */
+
+int trace_init(void)
+{
+	/*
+	 * Start the timing counter for the span CPU time. timing_start() is
+	 * reference counted, so the BLE metrics and the render benchmark
+	 * starting and stopping it later do not reset it.
+	 */
+	timing_init();
+	timing_start();
+
+	diag_register_buffer("trace.ring", sizeof(ring));
+
+	LOG_INF("Trace recorder started (%d events)", TRACE_BUFFER_SIZE);
+	return 0;
+}
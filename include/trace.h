@@ -0,0 +1,109 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <zephyr/kernel.h>
+
+/**
+ * @brief Traced spans
+ *
+ * Values are part of the CTF metadata (tools/trace/metadata), append only.
+ */
+enum trace_span {
+	TRACE_SPAN_DRAW_IMAGE = 0,  /* display_draw_image() */
+	TRACE_SPAN_DRAW_GRAPH = 1,  /* display_draw_graph() */
+	TRACE_SPAN_FB_FINALIZE = 2, /* cfb_framebuffer_finalize() */
+	TRACE_SPAN_BATTERY_READ = 3, /* Battery measurement window */
+	TRACE_SPAN_GATT_READ = 4,   /* GATT read callback, arg = UUID */
+	TRACE_SPAN_GATT_WRITE = 5,  /* GATT write callback, arg = UUID */
+	TRACE_SPAN_WORK = 6,        /* Work item handler, arg = enum trace_work */
+	TRACE_SPAN_COUNT,           /* Number of spans, not recorded */
+};
+
+/**
+ * @brief Work items reported with TRACE_SPAN_WORK
+ */
+enum trace_work {
+	TRACE_WORK_SENSOR_UPDATE = 0,
+	TRACE_WORK_BATTERY_START = 1,
+	TRACE_WORK_BATTERY_SAMPLE = 2,
+	TRACE_WORK_BATTERY_DONE = 3,
+};
+
+/**
+ * @brief Event kinds recorded in the ring buffer
+ */
+enum trace_event_type {
+	TRACE_EVENT_BEGIN = 0,
+	TRACE_EVENT_END = 1,
+};
+
+#if defined(CONFIG_APP_TRACE)
+
+/**
+ * @brief Record a span event
+ *
+ * Timestamped with the system clock cycle counter (k_cycle_get_32()),
+ * which is monotonic and runs while the CPU sleeps. An end event also
+ * carries the timing counter cycles since the begin of its span (DWT on
+ * nRF52, 64 MHz), which resolves short spans. Safe from any context.
+ *
+ * @param type Begin or end
+ * @param span Span identifier
+ * @param arg Span argument (UUID, work id, ...)
+ */
+void trace_record(enum trace_event_type type, enum trace_span span, uint16_t arg);
+
+/**
+ * @brief Initialize the trace recorder
+ *
+ * @return 0 on success, negative errno on failure
+ */
+int trace_init(void);
+
+/**
+ * @brief Pause or resume recording
+ *
+ * Recording is paused while a dump is in progress so it stays consistent.
+ *
+ * @param paused true to pause
+ */
+void trace_set_paused(bool paused);
+
+/**
+ * @brief Discard all recorded events
+ */
+void trace_clear(void);
+
+/**
+ * @brief Size of the current trace as a CTF event stream
+ *
+ * @return Stream size in bytes
+ */
+size_t trace_ctf_size(void);
+
+/**
+ * @brief Export recorded events as a CTF event stream
+ *
+ * Events are written oldest first. The stream layout is described by
+ * tools/trace/metadata.
+ *
+ * @param offset Byte offset into the stream
+ * @param buf Destination buffer
+ * @param len Capacity of @p buf
+ * @return Number of bytes written
+ */
+size_t trace_ctf_export(size_t offset, uint8_t *buf, size_t len);
+
+#define TRACE_BEGIN(span, arg) trace_record(TRACE_EVENT_BEGIN, (span), (arg))
+#define TRACE_END(span, arg) trace_record(TRACE_EVENT_END, (span), (arg))
+
+#else
+
+static inline int trace_init(void) { return 0; }
+
+#define TRACE_BEGIN(span, arg) do { } while (0)
+#define TRACE_END(span, arg) do { } while (0)
+
+#endif /* CONFIG_APP_TRACE */
+
+#endif /* TRACE_H */
@@ -0,0 +1,158 @@
+#include "workqueues.h"
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/util.h>
+#if defined(CONFIG_SHELL)
+#include <zephyr/shell/shell.h>
+#endif
+
+LOG_MODULE_REGISTER(workqueues, CONFIG_APP_WORKQ_LOG_LEVEL);
+
+K_THREAD_STACK_DEFINE(sensing_stack, CONFIG_APP_WQ_SENSING_STACK_SIZE);
+K_THREAD_STACK_DEFINE(display_stack, CONFIG_APP_WQ_DISPLAY_STACK_SIZE);
+
+struct wq {
+	struct k_work_q queue;
+	const char *name;
+	k_thread_stack_t *stack;
+	size_t stack_size;
+	int priority;
+	struct wq_stats stats;
+};
+
+static struct wq queues[WQ_COUNT] = {
+	[WQ_SENSING] = {
+		.name = "wq_sensing",
+		.stack = sensing_stack,
+		.stack_size = K_THREAD_STACK_SIZEOF(sensing_stack),
+		.priority = CONFIG_APP_WQ_SENSING_PRIORITY,
+	},
+	[WQ_DISPLAY] = {
+		.name = "wq_display",
+		.stack = display_stack,
+		.stack_size = K_THREAD_STACK_SIZEOF(display_stack),
+		.priority = CONFIG_APP_WQ_DISPLAY_PRIORITY,
+	},
+};
+
+static struct k_spinlock stats_lock;
+
+int workqueues_init(void)
+{
+	for (int i = 0; i < WQ_COUNT; i++) {
+		struct k_work_queue_config cfg = {
+			.name = queues[i].name,
+		};
+
+		k_work_queue_start(&queues[i].queue, queues[i].stack, queues[i].stack_size,
+				   queues[i].priority, &cfg);
+	}
+
+	LOG_INF("Work queues started (sensing prio %d, display prio %d)",
+		CONFIG_APP_WQ_SENSING_PRIORITY, CONFIG_APP_WQ_DISPLAY_PRIORITY);
+	return 0;
+}
+
+struct k_work_q *wq_queue(enum wq_id id)
+{
+	return &queues[id].queue;
+}
+
+/*
+ * The stamp is written before the item is queued: a queue above the
+ * caller's priority runs the item before the submit call returns. When
+ * the item was not newly queued the previous stamp still applies.
+ */
+static int stamp_keep(struct wq_stamp *stamp, int64_t prev, int ret)
+{
+	if (ret <= 0) {
+		stamp->ready_ticks = prev;
+	}
+
+	return ret;
+}
+
+int wq_submit(enum wq_id id, struct k_work *work, struct wq_stamp *stamp)
+{
+	int64_t prev = stamp->ready_ticks;
+
+	stamp->ready_ticks = k_uptime_ticks();
+
+	return stamp_keep(stamp, prev, k_work_submit_to_queue(&queues[id].queue, work));
+}
+
+int wq_schedule(enum wq_id id, struct k_work_delayable *dwork, struct wq_stamp *stamp,
+		k_timeout_t delay)
+{
+	int64_t prev = stamp->ready_ticks;
+
+	stamp->ready_ticks = k_uptime_ticks() + delay.ticks;
+
+	return stamp_keep(stamp, prev, k_work_schedule_for_queue(&queues[id].queue, dwork, delay));
+}
+
+int wq_reschedule(enum wq_id id, struct k_work_delayable *dwork, struct wq_stamp *stamp,
+		  k_timeout_t delay)
+{
+	int64_t prev = stamp->ready_ticks;
+
+	stamp->ready_ticks = k_uptime_ticks() + delay.ticks;
+
+	return stamp_keep(stamp, prev, k_work_reschedule_for_queue(&queues[id].queue, dwork, delay));
+}
+
+void wq_started(enum wq_id id, const struct wq_stamp *stamp)
+{
+	int64_t late = k_uptime_ticks() - stamp->ready_ticks;
+	uint32_t latency_us = (uint32_t)k_ticks_to_us_near64(MAX(late, 0));
+	uint32_t latency_ms = latency_us / 1000;
+	int bucket = (latency_ms == 0) ? 0 : MIN(LOG2(latency_ms) + 1, WQ_HIST_BUCKETS - 1);
+	struct wq_stats *stats = &queues[id].stats;
+
+	k_spinlock_key_t key = k_spin_lock(&stats_lock);
+
+	stats->runs++;
+	stats->hist[bucket]++;
+	stats->max_latency_us = MAX(stats->max_latency_us, latency_us);
+
+	k_spin_unlock(&stats_lock, key);
+}
+
+void wq_get_stats(enum wq_id id, struct wq_stats *out)
+{
+	k_spinlock_key_t key = k_spin_lock(&stats_lock);
+
+	*out = queues[id].stats;
+
+	k_spin_unlock(&stats_lock, key);
+}
+
+#if defined(CONFIG_SHELL)
+static int cmd_diag_workq(const struct shell *sh, size_t argc, char **argv)
+{
+	struct wq_stats stats;
+
+	shell_fprintf(sh, SHELL_NORMAL, "{");
+
+	for (int i = 0; i < WQ_COUNT; i++) {
+		wq_get_stats(i, &stats);
+
+		shell_fprintf(sh, SHELL_NORMAL,
+			      "%s\"%s\":{\"priority\":%d,\"runs\":%u,\"max_latency_us\":%u,\"hist_ms\":[",
+			      i ? "," : "", queues[i].name, queues[i].priority,
+			      stats.runs, stats.max_latency_us);
+
+		for (int b = 0; b < WQ_HIST_BUCKETS; b++) {
+			shell_fprintf(sh, SHELL_NORMAL, "%s%u", b ? "," : "", stats.hist[b]);
+		}
+
+		shell_fprintf(sh, SHELL_NORMAL, "]}");
+	}
+
+	shell_fprintf(sh, SHELL_NORMAL, "}\n");
+
+	return 0;
+}
+
+SHELL_SUBCMD_ADD((diag), workq, NULL, "Work queue latency histograms (JSON)",
+		 cmd_diag_workq, 1, 0);
+#endif /* CONFIG_SHELL */
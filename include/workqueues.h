@@ -0,0 +1,116 @@
+#ifndef WORKQUEUES_H
+#define WORKQUEUES_H
+
+#include <zephyr/kernel.h>
+
+/**
+ * @brief Application work queues
+ *
+ * Sensing runs above display rendering, so a multi-second e-paper
+ * refresh no longer delays readings, notifications or the Bluetooth
+ * stack work left on the system workqueue.
+ */
+enum wq_id {
+	WQ_SENSING = 0,  /* Sensor sampling, battery, BLE data preparation */
+	WQ_DISPLAY,      /* Rendering and panel flushes */
+	WQ_COUNT,
+};
+
+/* Queue latency histogram: bucket 0 is < 1 ms, bucket n is [2^(n-1), 2^n) ms */
+#define WQ_HIST_BUCKETS 12
+
+/**
+ * @brief Queue latency statistics of one work queue
+ */
+struct wq_stats {
+	uint32_t runs;                   /* Items started */
+	uint32_t max_latency_us;         /* Worst ready-to-start latency */
+	uint32_t hist[WQ_HIST_BUCKETS];  /* Latency histogram */
+};
+
+/**
+ * @brief Time a work item became ready to run
+ *
+ * Kept next to the work item and handed to the submit/schedule helpers
+ * and to wq_started().
+ */
+struct wq_stamp {
+	int64_t ready_ticks;
+};
+
+/**
+ * @brief Start the application work queues
+ *
+ * Must be called before any work is submitted to them.
+ *
+ * @return 0 on success, negative errno on failure
+ */
+int workqueues_init(void);
+
+/**
+ * @brief Get the kernel work queue of an application queue
+ *
+ * For APIs without a helper here, e.g. k_work_poll_submit_to_queue().
+ *
+ * @param id Queue
+ * @return Work queue
+ */
+struct k_work_q *wq_queue(enum wq_id id);
+
+/**
+ * @brief Submit work to an application queue
+ *
+ * @param id Queue
+ * @param work Work item
+ * @param stamp Ready time of @p work, updated when newly queued
+ * @return Result of k_work_submit_to_queue()
+ */
+int wq_submit(enum wq_id id, struct k_work *work, struct wq_stamp *stamp);
+
+/**
+ * @brief Schedule delayable work on an application queue
+ *
+ * Keeps an already pending schedule, like k_work_schedule().
+ *
+ * @param id Queue
+ * @param dwork Delayable work item
+ * @param stamp Ready time of @p dwork, updated when newly scheduled
+ * @param delay Delay before the item becomes ready
+ * @return Result of k_work_schedule_for_queue()
+ */
+int wq_schedule(enum wq_id id, struct k_work_delayable *dwork, struct wq_stamp *stamp,
+		k_timeout_t delay);
+
+/**
+ * @brief Reschedule delayable work on an application queue
+ *
+ * Replaces a pending schedule, like k_work_reschedule().
+ *
+ * @param id Queue
+ * @param dwork Delayable work item
+ * @param stamp Ready time of @p dwork
+ * @param delay Delay before the item becomes ready
+ * @return Result of k_work_reschedule_for_queue()
+ */
+int wq_reschedule(enum wq_id id, struct k_work_delayable *dwork, struct wq_stamp *stamp,
+		  k_timeout_t delay);
+
+/**
+ * @brief Record the queue latency of a work item
+ *
+ * Call first thing in the work handler.
+ *
+ * @param id Queue the item ran on
+ * @param stamp Ready time of the item
+ */
+void wq_started(enum wq_id id, const struct wq_stamp *stamp);
+
+/**
+ * @brief Get the latency statistics of a queue
+ *
+ * @param id Queue
+ * @param out Destination snapshot
+ */
+void wq_get_stats(enum wq_id id, struct wq_stats *out);
+
+#endif /* WORKQUEUES_H */
@@ -4,25 +4,29 @@
 #include <zephyr/bluetooth/conn.h>
 #include <zephyr/bluetooth/uuid.h>
 #include <zephyr/logging/log.h>
+#include <zephyr/settings/settings.h>
 
 #include "../include/ble_rgb_service.h"
+#include "../include/led_effects.h"
 #include "../include/ble_ess_service.h"
+#include "../include/ble_bas_service.h"
 #include "../include/display_epaper.h"
 #include "../include/battery.h"
-
-LOG_MODULE_REGISTER(main, LOG_LEVEL_INF);
-
-/* BLE advertising data */
-static const struct bt_data ad[] = {
-	BT_DATA_BYTES(BT_DATA_FLAGS, (BT_LE_AD_GENERAL | BT_LE_AD_NO_BREDR)),
-	BT_DATA_BYTES(BT_DATA_UUID16_ALL,
-		      0x1A, 0x18,  /* Environmental Sensing Service (0x181A) - little endian */
-		      0xE0, 0xFF), /* RGB LED Service (0xFFE0) - little endian */
-};
-
-static const struct bt_data sd[] = {
-	BT_DATA(BT_DATA_NAME_COMPLETE, CONFIG_BT_DEVICE_NAME, sizeof(CONFIG_BT_DEVICE_NAME) - 1),
-};
+#include "../include/diagnostics.h"
+#include "../include/ble_diag_service.h"
+#include "../include/ble_metrics.h"
+#include "../include/trace.h"
+#include "../include/display_bench.h"
+#include "../include/esl_sync.h"
+#include "../include/advertising.h"
+#include "../include/neighbours.h"
+#include "../include/mesh_sensor.h"
+#include "../include/boot.h"
+#include "../include/workqueues.h"
+#include "../include/low_duty.h"
+#include "../include/record_log.h"
+
+LOG_MODULE_REGISTER(main, CONFIG_APP_MAIN_LOG_LEVEL);
 
 /* Connection callbacks */
 static void connected(struct bt_conn *conn, uint8_t err)
@@ -31,6 +35,7 @@ static void connected(struct bt_conn *conn, uint8_t err)
 		LOG_ERR("Connection failed (err 0x%02x)", err);
 	} else {
 		LOG_INF("Connected");
+		led_effects_play_status(LED_STATUS_CONNECTED);
 	}
 }
 
@@ -44,12 +49,108 @@ BT_CONN_CB_DEFINE(conn_callbacks) = {
 	.disconnected = disconnected,
 };
 
+/*
+ * Display and battery bring-up run on the application work queues below
+ * main, so BLE comes up first without stacks that are only used at boot.
+ */
+static struct wq_stamp boot_display_stamp;
+static struct wq_stamp boot_battery_stamp;
+
+static void boot_display(struct k_work *work)
+{
+	int err;
+
+	wq_started(WQ_DISPLAY, &boot_display_stamp);
+
+	/* LED status patterns play while the panel refreshes */
+	err = display_epaper_init();
+	if (err) {
+		LOG_ERR("Display init failed (err %d)", err);
+		return;
+	}
+
+	/* After a warm reset the dashboard is already on the panel */
+	if (!display_is_restored()) {
+		/* Initialize sensor display labels */
+		display_init_sensor_labels();
+
+		/* Show the initial battery level once it was read */
+		boot_wait(BOOT_PHASE_BATTERY_READY, K_FOREVER);
+		display_update_battery(battery_get_voltage(), battery_get_level());
+	}
+
+	boot_mark(BOOT_PHASE_DISPLAY_READY);
+}
+
+/* Initial battery level, taken once the logo refresh released BUSY */
+static void boot_battery_measured(int err, uint16_t voltage)
+{
+	if (err) {
+		LOG_WRN("Initial battery measurement failed (err %d)", err);
+	}
+
+	bas_update_battery(voltage, battery_get_percentage(voltage));
+
+	boot_mark(BOOT_PHASE_BATTERY_READY);
+
+	/* Readings carry the battery level, so start them once it is known */
+	if (!IS_ENABLED(CONFIG_APP_LOW_DUTY)) {
+		ess_start_auto_update();
+	}
+}
+
+static void boot_battery(struct k_work *work)
+{
+	int err;
+
+	wq_started(WQ_SENSING, &boot_battery_stamp);
+
+	/* Initialize battery monitoring */
+	err = battery_init();
+	if (err) {
+		LOG_ERR("Battery init failed (err %d)", err);
+		/* Continue anyway - not critical */
+	}
+
+	/*
+	 * The display comes up at the same time. The asynchronous
+	 * measurement waits for the panel to leave BUSY, so the divider is
+	 * never sampled during a refresh.
+	 */
+	err = battery_measure_async(boot_battery_measured);
+	if (err) {
+		boot_battery_measured(err, battery_get_voltage());
+	}
+}
+
+static K_WORK_DEFINE(boot_display_work, boot_display);
+static K_WORK_DEFINE(boot_battery_work, boot_battery);
+
 int main(void)
 {
 	int err;
 
+	boot_mark(BOOT_PHASE_MAIN);
 	LOG_INF("=== BLE H&T Sensor Starting ===");
 
+	/* Start recording before anything is traced */
+	trace_init();
+
+#if defined(CONFIG_APP_RENDER_BENCH)
+	/* Render benchmark build: measure drawing cost instead of running */
+	err = display_bench_run();
+	if (err) {
+		LOG_ERR("Render benchmark failed (err %d)", err);
+	}
+	return 0;
+#endif
+
+	/* Sensing and display queues, before anything submits to them */
+	workqueues_init();
+
+	/* Record log before the first sample is taken */
+	record_log_init();
+
 	/* Initialize RGB LED service */
 	err = ble_rgb_service_init();
 	if (err) {
@@ -57,6 +158,10 @@ int main(void)
 		return 0;
 	}
 
+	/* LED engine is up: bring up display and battery in parallel */
+	wq_submit(WQ_DISPLAY, &boot_display_work, &boot_display_stamp);
+	wq_submit(WQ_SENSING, &boot_battery_work, &boot_battery_stamp);
+
 	/* Initialize Environmental Sensing Service */
 	err = ble_ess_service_init();
 	if (err) {
@@ -64,6 +169,20 @@ int main(void)
 		return 0;
 	}
 
+	/* Initialize Battery Service */
+	err = ble_bas_service_init();
+	if (err) {
+		LOG_ERR("BAS init failed (err %d)", err);
+		return 0;
+	}
+
+	/* Initialize Diagnostics Service */
+	err = ble_diag_service_init();
+	if (err) {
+		LOG_ERR("Diagnostics service init failed (err %d)", err);
+		return 0;
+	}
+
 	/* Initialize Bluetooth */
 	err = bt_enable(NULL);
 	if (err) {
@@ -71,54 +190,60 @@ int main(void)
 		return 0;
 	}
 	LOG_INF("Bluetooth initialized");
-
-	/* Start BLE advertising */
-	struct bt_le_adv_param adv_param = {
-		.id = BT_ID_DEFAULT,
-		.sid = 0,
-		.secondary_max_skip = 0,
-		.options = BT_LE_ADV_OPT_CONN,
-		.interval_min = BT_GAP_ADV_FAST_INT_MIN_2,
-		.interval_max = BT_GAP_ADV_FAST_INT_MAX_2,
-		.peer = NULL,
-	};
-
-	err = bt_le_adv_start(&adv_param, ad, ARRAY_SIZE(ad), sd, ARRAY_SIZE(sd));
-	if (err) {
-		LOG_ERR("Advertising failed to start (err %d)", err);
-		return 0;
+	boot_mark(BOOT_PHASE_BT_READY);
+
+	/* Start energy accounting together with advertising */
+	diagnostics_init();
+	ble_metrics_init();
+
+	/* Start BLE advertising, or join the mesh which owns the advertiser */
+	if (IS_ENABLED(CONFIG_APP_MESH)) {
+		err = mesh_sensor_init();
+		if (err) {
+			LOG_ERR("Mesh init failed (err %d)", err);
+			return 0;
+		}
+	} else if (IS_ENABLED(CONFIG_APP_LOW_DUTY)) {
+		/* Unconnectable: sample and broadcast in bursts only */
+		err = low_duty_start();
+		if (err) {
+			LOG_ERR("Low-duty mode failed to start (err %d)", err);
+			return 0;
+		}
+	} else {
+		/* Restore bonds and the database hash before advertising */
+		if (IS_ENABLED(CONFIG_BT_SETTINGS)) {
+			settings_load();
+		}
+
+		err = advertising_start();
+		if (err) {
+			LOG_ERR("Advertising failed to start (err %d)", err);
+			return 0;
+		}
 	}
+	boot_mark(BOOT_PHASE_ADVERTISING);
 
-	LOG_INF("Advertising started as '%s'", CONFIG_BT_DEVICE_NAME);
 	LOG_INF("Services ready:");
 	LOG_INF("  - Environmental Sensing Service (0x181A)");
+	LOG_INF("  - Battery Service (0x180F)");
 	LOG_INF("  - RGB LED Service (0xFFE0)");
+	LOG_INF("  - Diagnostics Service (0xFFD0)");
 
-	/* Start automatic sensor data updates */
-	ess_start_auto_update();
-
-	/* Initialize E-Paper Display */
-	err = display_epaper_init();
+	/* Listen to neighbouring nodes, if enabled */
+	err = neighbours_init();
 	if (err) {
-		LOG_ERR("Display init failed (err %d)", err);
-		return 0;
+		LOG_ERR("Neighbour scanner init failed (err %d)", err);
+		/* Continue anyway - own readings still shown */
 	}
 
-	/* Initialize battery monitoring */
-	err = battery_init();
+	/* Follow the shelf label train, if enabled */
+	err = esl_sync_init();
 	if (err) {
-		LOG_ERR("Battery init failed (err %d)", err);
-		/* Continue anyway - not critical */
+		LOG_ERR("ESL sync init failed (err %d)", err);
+		/* Continue anyway - GATT access still works */
 	}
 
-	/* Initialize sensor display labels */
-	display_init_sensor_labels();
-
-	/* Read and display initial battery level */
-	uint16_t voltage = battery_read_voltage();
-	uint8_t battery_pct = battery_get_percentage(voltage);
-	display_update_battery(voltage, battery_pct);
-
 	/* Main loop - just sleep */
 	while (1) {
 		k_sleep(K_FOREVER);
@@ -0,0 +1,166 @@
+/*
+ * Microbenchmark of ADC code to mV and percent: the lookup tables of
+ * battery.c against the one-step arithmetic and the conversion chain
+ * they replaced (three truncating divides and a table search).
+ *
+ *   bench_battery_math [--count N] [--rounds N]
+ */
+
+#include "battery_math.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static uint16_t mv_lut[VBAT_LUT_SIZE];
+static uint8_t pct_lut[VBAT_LUT_SIZE];
+
+/* Keeps the results live */
+static volatile uint32_t sink;
+
+/* Conversion before the lookup tables */
+static uint16_t legacy_mv(int32_t code)
+{
+	int32_t adc_voltage = (code * 600 * 6) / 4096;
+	int32_t mv = (adc_voltage * VBAT_DIVIDER_NUMERATOR) / VBAT_DIVIDER_DENOMINATOR;
+
+	return (uint16_t)((mv * VBAT_CALIBRATION_FACTOR) / 1000);
+}
+
+static uint8_t legacy_pct(uint16_t mv)
+{
+	static const uint16_t voltage_table[] = {
+		4200, 4100, 4000, 3900, 3800, 3700, 3600, 3500, 3400, 3300
+	};
+	static const uint8_t percent_table[] = {
+		100, 96, 90, 80, 60, 40, 25, 10, 5, 0
+	};
+
+	if (mv >= 4000) {
+		return 100;
+	}
+	if (mv <= 3300) {
+		return 0;
+	}
+
+	for (int i = 0; i < 9; i++) {
+		if (mv >= voltage_table[i + 1]) {
+			uint16_t v1 = voltage_table[i];
+			uint16_t v2 = voltage_table[i + 1];
+			uint8_t p1 = percent_table[i];
+			uint8_t p2 = percent_table[i + 1];
+
+			return p1 - ((p1 - p2) * (v1 - mv) / (v1 - v2));
+		}
+	}
+
+	return 0;
+}
+
+static uint32_t convert_legacy(uint16_t code)
+{
+	uint16_t mv = legacy_mv(code);
+
+	return mv + legacy_pct(mv);
+}
+
+static uint32_t convert_arith(uint16_t code)
+{
+	uint16_t mv = VBAT_CODE_TO_MV(code);
+
+	return mv + VBAT_MV_TO_PCT(mv);
+}
+
+static uint32_t convert_lut(uint16_t code)
+{
+	uint16_t index = code - VBAT_LUT_FIRST_CODE;
+
+	return mv_lut[index] + pct_lut[index];
+}
+
+static double now_s(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Best of several rounds over codes cycling through the LUT range */
+static double bench(uint32_t (*convert)(uint16_t), unsigned long count, unsigned rounds)
+{
+	double best = 0;
+
+	for (unsigned round = 0; round < rounds; round++) {
+		uint32_t sum = 0;
+		double start = now_s();
+
+		for (unsigned long i = 0; i < count; i++) {
+			sum += convert(VBAT_LUT_FIRST_CODE + (uint16_t)((i * 7) % VBAT_LUT_SIZE));
+		}
+
+		double s = now_s() - start;
+
+		sink += sum;
+		if (round == 0 || s < best) {
+			best = s;
+		}
+	}
+
+	return best / count * 1e9;
+}
+
+static unsigned long parse_number(const char *option, const char *value)
+{
+	char *end;
+	unsigned long number = strtoul(value, &end, 10);
+
+	if (value[0] < '0' || value[0] > '9' || *end != '\0' || number == 0) {
+		fprintf(stderr, "bad value for %s: %s\n", option, value);
+		exit(2);
+	}
+
+	return number;
+}
+
+int main(int argc, char **argv)
+{
+	unsigned long count = 10000000;
+	unsigned rounds = 5;
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--count") == 0 && i + 1 < argc) {
+			count = parse_number(argv[i], argv[i + 1]);
+			i++;
+		} else if (strcmp(argv[i], "--rounds") == 0 && i + 1 < argc) {
+			rounds = (unsigned)parse_number(argv[i], argv[i + 1]);
+			i++;
+		} else {
+			fprintf(stderr, "usage: %s [--count N] [--rounds N]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	/* Same tables battery.c builds with LISTIFY at compile time */
+	for (int i = 0; i < VBAT_LUT_SIZE; i++) {
+		mv_lut[i] = VBAT_CODE_TO_MV(VBAT_LUT_FIRST_CODE + i);
+		pct_lut[i] = VBAT_MV_TO_PCT(mv_lut[i]);
+	}
+
+	/* The table and the arithmetic path must agree on every code */
+	for (uint16_t code = VBAT_LUT_FIRST_CODE; code < VBAT_LUT_FIRST_CODE + VBAT_LUT_SIZE;
+	     code++) {
+		if (convert_lut(code) != convert_arith(code)) {
+			fprintf(stderr, "code %u: table and arithmetic differ\n", code);
+			return 1;
+		}
+	}
+
+	printf("%-10s %8.2f ns/conversion\n", "legacy", bench(convert_legacy, count, rounds));
+	printf("%-10s %8.2f ns/conversion\n", "arith", bench(convert_arith, count, rounds));
+	printf("%-10s %8.2f ns/conversion\n", "lut", bench(convert_lut, count, rounds));
+	printf("best of %u rounds, %lu conversions each\n", rounds, count);
+
+	return 0;
+}
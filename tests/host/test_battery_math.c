@@ -0,0 +1,114 @@
+/*
+ * Battery conversion math from battery_math.h, checked against a
+ * floating point reference over every 12-bit ADC code.
+ */
+
+#include "battery_math.h"
+
+#include <math.h>
+#include <stdio.h>
+
+#define ADC_CODES 4096
+
+static int failures;
+
+#define CHECK(cond, ...)					\
+	do {							\
+		if (!(cond)) {					\
+			printf("FAIL %s:%d: ", __FILE__, __LINE__);	\
+			printf(__VA_ARGS__);			\
+			printf("\n");				\
+			failures++;				\
+		}						\
+	} while (0)
+
+/* code * (600mV * 6) / 4096 * divider * calibration, unrounded */
+static double reference_mv(int code)
+{
+	return code * 3600.0 / 4096.0 * VBAT_DIVIDER_NUMERATOR / VBAT_DIVIDER_DENOMINATOR *
+	       VBAT_CALIBRATION_FACTOR / 1000.0;
+}
+
+/* One rounding step, so never more than half a mV off */
+static void test_code_to_mv(void)
+{
+	uint16_t prev = 0;
+
+	for (int code = 0; code < ADC_CODES; code++) {
+		uint16_t mv = VBAT_CODE_TO_MV(code);
+		double error = fabs(mv - reference_mv(code));
+
+		CHECK(error <= 0.5, "code %d: %u mV, reference %.2f", code, mv, reference_mv(code));
+		CHECK(mv >= prev, "code %d: %u mV below the previous code", code, mv);
+		prev = mv;
+	}
+}
+
+/* The lookup tables must cover the whole discharge curve */
+static void test_lut_range(void)
+{
+	uint16_t first = VBAT_CODE_TO_MV(VBAT_LUT_FIRST_CODE);
+	uint16_t last = VBAT_CODE_TO_MV(VBAT_LUT_FIRST_CODE + VBAT_LUT_SIZE - 1);
+
+	CHECK(first < 3300, "LUT starts at %u mV", first);
+	CHECK(last > 4200, "LUT ends at %u mV", last);
+	CHECK(VBAT_LUT_FIRST_CODE + VBAT_LUT_SIZE <= ADC_CODES, "LUT beyond 12 bits");
+}
+
+static void test_mv_to_pct(void)
+{
+	static const struct {
+		uint16_t mv;
+		int pct;
+	} points[] = {
+		{5000, 100}, {4200, 100}, {4150, 98}, {4100, 96}, {4000, 90},
+		{3900, 80}, {3800, 60}, {3750, 50}, {3700, 40}, {3600, 25},
+		{3500, 10}, {3400, 5}, {3300, 0}, {3000, 0}, {0, 0},
+	};
+	int prev = 0;
+
+	for (size_t i = 0; i < sizeof(points) / sizeof(points[0]); i++) {
+		int pct = VBAT_MV_TO_PCT(points[i].mv);
+
+		CHECK(pct == points[i].pct, "%u mV: %d %%, expected %d %%",
+		      points[i].mv, pct, points[i].pct);
+	}
+
+	for (uint32_t mv = 0; mv <= 5000; mv++) {
+		int pct = VBAT_MV_TO_PCT(mv);
+
+		CHECK(pct >= 0 && pct <= 100, "%u mV: %d %%", mv, pct);
+		CHECK(pct >= prev, "%u mV: %d %% below %d %%", mv, pct, prev);
+		prev = pct;
+	}
+}
+
+/* The emulation's pin voltage must read back as the battery voltage */
+static void test_pin_round_trip(void)
+{
+	for (uint32_t mv = 3000; mv <= 4500; mv++) {
+		uint32_t pin = VBAT_PIN_MV(mv);
+		int code = (int)(pin * 4096 / 3600);
+		int back = VBAT_CODE_TO_MV(code);
+
+		/* One code is about 2.7 mV at the battery, plus the pin rounding */
+		CHECK(back <= (int)mv && (int)mv - back <= 6, "%u mV reads back as %d mV",
+		      mv, back);
+	}
+}
+
+int main(void)
+{
+	test_code_to_mv();
+	test_lut_range();
+	test_mv_to_pct();
+	test_pin_round_trip();
+
+	if (failures) {
+		printf("%d checks failed\n", failures);
+		return 1;
+	}
+
+	printf("battery_math: all checks passed\n");
+	return 0;
+}
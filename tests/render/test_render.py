@@ -0,0 +1,39 @@
+"""Render regression checks on the console output of the render benchmark.
+
+Run by twister through testcase.yaml at the repository root. The frames
+and results are parsed with tools/render/frames2pbm.py.
+"""
+
+import pathlib
+import sys
+
+from twister_harness import DeviceAdapter
+
+ROOT = pathlib.Path(__file__).resolve().parents[2]
+REFERENCE = ROOT / "tests" / "render" / "reference"
+
+sys.path.insert(0, str(ROOT / "tools" / "render"))
+import frames2pbm  # noqa: E402
+
+
+def bench_output(dut):
+    return dut.readlines_until(regex=r"RENDER-BENCH-RESULT (PASS|FAIL)", timeout=90)
+
+
+def test_frames(dut: DeviceAdapter):
+    frames, _ = frames2pbm.parse(bench_output(dut))
+
+    assert frames, "no frames captured"
+    problems = frames2pbm.check_frames(frames, REFERENCE)
+    assert not problems, "\n".join(problems)
+
+
+def test_budgets(dut: DeviceAdapter):
+    lines = bench_output(dut)
+    _, bench = frames2pbm.parse(lines)
+
+    assert bench, "no benchmark results"
+    over = ["%s avg=%s budget=%s" % (name, avg, budget)
+            for name, avg, _, _, budget, result in bench if result != "PASS"]
+    assert not over, "over budget: " + ", ".join(over)
+    assert "RENDER-BENCH-RESULT PASS" in lines[-1]
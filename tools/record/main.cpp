@@ -0,0 +1,281 @@
+/*
+ * bleink-record - decode, benchmark and replay BleInk sensor records
+ *
+ *   bleink-record decode <dump> [--raw] [--timeline]
+ *   bleink-record bench [--count N] [--rounds N]
+ *   bleink-record replay <dump> <zephyr.exe> [--raw] [--speed N] [--trace FILE]
+ *
+ * A dump is the UART log of 'records dump' or, with --raw, the
+ * pages read from the Diagnostics Records characteristic (0xFFD6),
+ * concatenated.
+ */
+
+#include "record.hpp"
+
+#include <cerrno>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+
+struct Options {
+	std::vector<std::string> args;  /* Positional arguments */
+	bool raw = false;
+	bool timeline = false;
+	uint64_t count = 10000000;
+	uint32_t rounds = 5;
+	uint32_t speed = 1;
+	std::string trace = "replay.rec";
+};
+
+int usage()
+{
+	std::cerr << "usage:\n"
+		     "  bleink-record decode <dump> [--raw] [--timeline]\n"
+		     "  bleink-record bench [--count N] [--rounds N]\n"
+		     "  bleink-record replay <dump> <zephyr.exe> [--raw] [--speed N] [--trace FILE]\n";
+	return 2;
+}
+
+/* Whole decimal number, throws on anything else or if it exceeds max */
+uint64_t parse_number(const std::string &option, const std::string &value,
+		      uint64_t max = std::numeric_limits<uint64_t>::max())
+{
+	size_t end = 0;
+	uint64_t number = 0;
+
+	if (!value.empty() && value[0] >= '0' && value[0] <= '9') {
+		try {
+			number = std::stoull(value, &end);
+		} catch (const std::out_of_range &) {
+			end = 0;
+		}
+	}
+
+	if (end == 0 || end != value.size() || number > max) {
+		throw std::invalid_argument("bad value for " + option + ": " + value);
+	}
+
+	return number;
+}
+
+bool parse(int argc, char **argv, Options &opt)
+{
+	for (int i = 2; i < argc; i++) {
+		std::string arg = argv[i];
+		bool has_value = i + 1 < argc;
+
+		if (arg == "--raw") {
+			opt.raw = true;
+		} else if (arg == "--timeline") {
+			opt.timeline = true;
+		} else if (arg == "--count" && has_value) {
+			opt.count = parse_number(arg, argv[++i]);
+		} else if (arg == "--rounds" && has_value) {
+			opt.rounds = static_cast<uint32_t>(parse_number(arg, argv[++i], UINT32_MAX));
+		} else if (arg == "--speed" && has_value) {
+			opt.speed = static_cast<uint32_t>(parse_number(arg, argv[++i], UINT32_MAX));
+		} else if (arg == "--trace" && has_value) {
+			opt.trace = argv[++i];
+		} else if (arg.rfind("--", 0) == 0) {
+			return false;
+		} else {
+			opt.args.push_back(arg);
+		}
+	}
+
+	return true;
+}
+
+int cmd_decode(const Options &opt)
+{
+	if (opt.args.size() != 1) {
+		return usage();
+	}
+
+	std::vector<bleink::Record> records = bleink::decode(bleink::read_dump(opt.args[0], opt.raw));
+
+	if (opt.timeline) {
+		records = bleink::timeline(std::move(records));
+	}
+
+	bleink::write_csv(std::cout, records);
+	std::cerr << records.size() << " records\n";
+	return 0;
+}
+
+/* Synthetic readings in the range of the firmware's dummy sensor */
+std::vector<uint8_t> make_dump(uint64_t count)
+{
+	std::vector<uint8_t> bytes(count * SENSOR_RECORD_LEN);
+	bleink::Record rec = {};
+
+	for (uint64_t i = 0; i < count; i++) {
+		rec.timestamp_s = static_cast<uint32_t>(i * 10);
+		rec.temperature = static_cast<int16_t>(2200 + (i * 50) % 500);
+		rec.humidity = static_cast<uint16_t>(5000 + (i * 200) % 2000);
+		rec.battery_mv = static_cast<uint16_t>(4200 - (i / 1000) % 900);
+		rec.flags = (i % 4 == 0) ? 0 : SENSOR_RECORD_FLAG_BATTERY_STALE;
+		sensor_record_encode(&rec, &bytes[i * SENSOR_RECORD_LEN]);
+	}
+
+	return bytes;
+}
+
+int cmd_bench(const Options &opt)
+{
+	using clock = std::chrono::steady_clock;
+
+	if (!opt.args.empty() || opt.count == 0 || opt.rounds == 0) {
+		return usage();
+	}
+
+	std::vector<uint8_t> bytes = make_dump(opt.count);
+	std::vector<bleink::Record> records(opt.count);
+	double best_s = 0;
+	uint64_t check = 0;
+
+	/* Best of several rounds, the first one also faults the pages in */
+	for (uint32_t round = 0; round < opt.rounds; round++) {
+		auto start = clock::now();
+		size_t n = bleink::decode_into(bytes.data(), bytes.size(), records.data(),
+					       records.size());
+		double s = std::chrono::duration<double>(clock::now() - start).count();
+
+		if (n != records.size()) {
+			std::cerr << "decoded " << n << " of " << records.size() << " records\n";
+			return 1;
+		}
+
+		/* Keeps the decoded fields live and catches codec errors */
+		for (const bleink::Record &rec : records) {
+			check += static_cast<uint64_t>(rec.temperature + rec.humidity + rec.battery_mv);
+		}
+
+		if (round == 0 || s < best_s) {
+			best_s = s;
+		}
+	}
+
+	std::cout << "decoded " << opt.count << " records (" << bytes.size() / 1000000.0
+		  << " MB) in " << best_s * 1000 << " ms, best of " << opt.rounds << "\n"
+		  << opt.count / best_s / 1e6 << " Mrecords/s, " << bytes.size() / best_s / 1e6
+		  << " MB/s (check " << check << ")\n";
+	return 0;
+}
+
+/* Run a program without a shell, so paths need no quoting */
+int run(const std::vector<std::string> &args)
+{
+	std::vector<char *> argv;
+
+	for (const std::string &arg : args) {
+		argv.push_back(const_cast<char *>(arg.c_str()));
+	}
+	argv.push_back(nullptr);
+
+	pid_t pid = fork();
+
+	if (pid < 0) {
+		throw std::runtime_error("cannot start " + args[0]);
+	}
+
+	if (pid == 0) {
+		execv(argv[0], argv.data());
+		std::cerr << "cannot run " << args[0] << "\n";
+		_exit(127);
+	}
+
+	int status;
+
+	while (waitpid(pid, &status, 0) < 0) {
+		if (errno != EINTR) {
+			throw std::runtime_error("cannot wait for " + args[0]);
+		}
+	}
+
+	return WIFEXITED(status) && WEXITSTATUS(status) == 0 ? 0 : 1;
+}
+
+int cmd_replay(const Options &opt)
+{
+	if (opt.args.size() != 2 || opt.speed == 0) {
+		return usage();
+	}
+
+	/* The emulator paces by timestamp, so resets must not jump back */
+	std::vector<bleink::Record> records =
+		bleink::timeline(bleink::decode(bleink::read_dump(opt.args[0], opt.raw)));
+
+	if (records.empty()) {
+		std::cerr << "no records in " << opt.args[0] << "\n";
+		return 1;
+	}
+
+	std::vector<uint8_t> bytes = bleink::encode(records);
+	std::ofstream out(opt.trace, std::ios::binary);
+
+	out.write(reinterpret_cast<const char *>(bytes.data()),
+		  static_cast<std::streamsize>(bytes.size()));
+	if (!out) {
+		std::cerr << "cannot write " << opt.trace << "\n";
+		return 1;
+	}
+	out.close();
+
+	/* Stop the simulation one sampling round after the last record */
+	double duration_s = static_cast<double>(records.back().timestamp_s) / opt.speed + 60;
+	std::vector<std::string> args = {
+		opt.args[1],
+		"-sensor_trace=" + opt.trace,
+		"-sensor_speed=" + std::to_string(opt.speed),
+		"-stop_at=" + std::to_string(duration_s),
+	};
+
+	std::cerr << "replaying " << records.size() << " records over "
+		  << records.back().timestamp_s << " s\n";
+	for (const std::string &arg : args) {
+		std::cerr << arg << (&arg == &args.back() ? "\n" : " ");
+	}
+
+	return run(args);
+}
+
+} /* namespace */
+
+int main(int argc, char **argv)
+{
+	Options opt;
+
+	if (argc < 2) {
+		return usage();
+	}
+
+	std::string cmd = argv[1];
+
+	try {
+		if (!parse(argc, argv, opt)) {
+			return usage();
+		}
+
+		if (cmd == "decode") {
+			return cmd_decode(opt);
+		} else if (cmd == "bench") {
+			return cmd_bench(opt);
+		} else if (cmd == "replay") {
+			return cmd_replay(opt);
+		}
+	} catch (const std::exception &e) {
+		std::cerr << "bleink-record: " << e.what() << "\n";
+		return 1;
+	}
+
+	return usage();
+}
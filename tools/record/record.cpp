@@ -0,0 +1,194 @@
+#include "record.hpp"
+
+#include <cctype>
+#include <fstream>
+#include <iterator>
+#include <ostream>
+
+namespace bleink {
+
+RecordError::RecordError(const std::string &what, size_t offset)
+	: std::runtime_error(what + " at byte " + std::to_string(offset)), offset_(offset)
+{
+}
+
+static int hex_value(char c)
+{
+	if (c >= '0' && c <= '9') {
+		return c - '0';
+	}
+	c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+	if (c >= 'a' && c <= 'f') {
+		return c - 'a' + 10;
+	}
+	return -1;
+}
+
+std::vector<uint8_t> read_dump(const std::string &path, bool raw)
+{
+	std::ifstream in(path, std::ios::binary);
+
+	if (!in) {
+		throw std::runtime_error("cannot open " + path);
+	}
+
+	if (raw) {
+		return std::vector<uint8_t>(std::istreambuf_iterator<char>(in),
+					    std::istreambuf_iterator<char>());
+	}
+
+	/* Shell log: records follow "REC " on their line, the rest is ignored */
+	std::vector<uint8_t> bytes;
+	std::string line;
+
+	while (std::getline(in, line)) {
+		size_t marker = line.find("REC ");
+
+		if (marker == std::string::npos) {
+			continue;
+		}
+
+		int high = -1;
+
+		for (size_t i = marker + 4; i < line.size(); i++) {
+			int value = hex_value(line[i]);
+
+			if (value < 0) {
+				break;
+			}
+			if (high < 0) {
+				high = value;
+			} else {
+				bytes.push_back(static_cast<uint8_t>(high << 4 | value));
+				high = -1;
+			}
+		}
+	}
+
+	return bytes;
+}
+
+size_t decode_into(const uint8_t *data, size_t len, Record *out, size_t max)
+{
+	size_t count = 0;
+
+	while (count < max && len >= SENSOR_RECORD_LEN &&
+	       sensor_record_decode(data, len, &out[count]) == 0) {
+		data += SENSOR_RECORD_LEN;
+		len -= SENSOR_RECORD_LEN;
+		count++;
+	}
+
+	return count;
+}
+
+std::vector<Record> decode(const std::vector<uint8_t> &bytes)
+{
+	std::vector<Record> records(bytes.size() / SENSOR_RECORD_LEN);
+	size_t count = decode_into(bytes.data(), bytes.size(), records.data(), records.size());
+
+	if (count < records.size()) {
+		size_t offset = count * SENSOR_RECORD_LEN;
+
+		throw RecordError("unknown record version " + std::to_string(bytes[offset]),
+				  offset);
+	}
+
+	if (bytes.size() % SENSOR_RECORD_LEN != 0) {
+		throw RecordError("truncated record", count * SENSOR_RECORD_LEN);
+	}
+
+	return records;
+}
+
+std::vector<uint8_t> encode(const std::vector<Record> &records)
+{
+	std::vector<uint8_t> bytes(records.size() * SENSOR_RECORD_LEN);
+
+	for (size_t i = 0; i < records.size(); i++) {
+		sensor_record_encode(&records[i], &bytes[i * SENSOR_RECORD_LEN]);
+	}
+
+	return bytes;
+}
+
+std::vector<Record> timeline(std::vector<Record> records)
+{
+	int64_t shift = 0;   /* Added to the recorded timestamps of this segment */
+	int64_t last = 0;    /* Timeline time of the previous record */
+	uint32_t prev = 0;   /* Recorded timestamp of the previous record */
+
+	for (size_t i = 0; i < records.size(); i++) {
+		Record &rec = records[i];
+
+		/* Gaps across a reset are unknown, the new segment goes on at once */
+		if (i == 0 || (rec.flags & SENSOR_RECORD_FLAG_BOOT) || rec.timestamp_s < prev) {
+			shift = last - rec.timestamp_s;
+		}
+
+		prev = rec.timestamp_s;
+		last = rec.timestamp_s + shift;
+		if (last > UINT32_MAX) {
+			throw RecordError("timeline longer than 2^32 s", i * SENSOR_RECORD_LEN);
+		}
+		rec.timestamp_s = static_cast<uint32_t>(last);
+	}
+
+	return records;
+}
+
+std::string flag_names(uint8_t flags)
+{
+	static const struct {
+		uint8_t flag;
+		const char *name;
+	} names[] = {
+		{SENSOR_RECORD_FLAG_BOOT, "boot"},
+		{SENSOR_RECORD_FLAG_BATTERY_STALE, "stale"},
+		{SENSOR_RECORD_FLAG_EMULATED, "emulated"},
+		{SENSOR_RECORD_FLAG_LOW_DUTY, "lowduty"},
+	};
+	std::string out;
+
+	for (const auto &n : names) {
+		if (flags & n.flag) {
+			out += out.empty() ? "" : "|";
+			out += n.name;
+			flags &= ~n.flag;
+		}
+	}
+
+	/* Flags of a newer firmware are shown as a number */
+	if (flags != 0) {
+		static const char hex[] = "0123456789abcdef";
+
+		out += out.empty() ? "0x" : "|0x";
+		out += hex[flags >> 4];
+		out += hex[flags & 0xF];
+	}
+
+	return out.empty() ? "-" : out;
+}
+
+/* Fixed point with two decimals, like the panel */
+static std::string centi(int32_t value)
+{
+	uint32_t mag = value < 0 ? 0U - static_cast<uint32_t>(value) : static_cast<uint32_t>(value);
+	std::string frac = std::to_string(mag % 100);
+
+	return (value < 0 ? "-" : "") + std::to_string(mag / 100) + "." +
+	       (frac.size() < 2 ? "0" : "") + frac;
+}
+
+void write_csv(std::ostream &out, const std::vector<Record> &records)
+{
+	out << "timestamp_s,temperature_c,humidity_pct,battery_mv,flags\n";
+
+	for (const Record &rec : records) {
+		out << rec.timestamp_s << ',' << centi(rec.temperature) << ','
+		    << centi(rec.humidity) << ',' << rec.battery_mv << ','
+		    << flag_names(rec.flags) << '\n';
+	}
+}
+
+} /* namespace bleink */
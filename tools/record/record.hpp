@@ -0,0 +1,67 @@
+#ifndef BLEINK_RECORD_HPP
+#define BLEINK_RECORD_HPP
+
+/*
+ * Host side of the sensor record format. The byte layout and the codec
+ * come from the firmware header, so both sides decode the same bytes.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "sensor_record.h"
+
+namespace bleink {
+
+using Record = sensor_record;
+
+/* Malformed dump or record, with the byte offset where it was found */
+class RecordError : public std::runtime_error {
+public:
+	RecordError(const std::string &what, size_t offset);
+
+	size_t offset() const { return offset_; }
+
+private:
+	size_t offset_;
+};
+
+/*
+ * Read a record dump. By default the file is the UART log of
+ * 'records dump' (lines with "REC <hex>"), with raw = true it holds the
+ * pages read from the Records characteristic (0xFFD6), concatenated.
+ */
+std::vector<uint8_t> read_dump(const std::string &path, bool raw);
+
+/* Decode a whole dump, throws RecordError on a short or unknown record */
+std::vector<Record> decode(const std::vector<uint8_t> &bytes);
+
+/*
+ * Decode up to max records without checks beyond the codec, for bulk
+ * use. Returns the number of records decoded, stops at the first bad one.
+ */
+size_t decode_into(const uint8_t *data, size_t len, Record *out, size_t max);
+
+/* Encode records back into a dump */
+std::vector<uint8_t> encode(const std::vector<Record> &records);
+
+/*
+ * Make timestamps continuous. Each SENSOR_RECORD_FLAG_BOOT record (or
+ * a timestamp going backwards) starts a new segment, which is moved to
+ * begin where the previous one ended. The first record is at 0.
+ */
+std::vector<Record> timeline(std::vector<Record> records);
+
+/* Flag names joined by '|', e.g. "boot|stale", or "-" */
+std::string flag_names(uint8_t flags);
+
+/* One CSV line per record, with a header */
+void write_csv(std::ostream &out, const std::vector<Record> &records);
+
+} /* namespace bleink */
+
+#endif /* BLEINK_RECORD_HPP */
@@ -0,0 +1,130 @@
+#!/usr/bin/env python3
+"""Extract captured frames and render benchmark results from a native_sim run.
+
+    west build -b native_sim -d build_sim
+    ./build_sim/zephyr/zephyr.exe -stop_at=30 > render.log
+    ./frames2pbm.py render.log frames/ [--reference tests/render/reference]
+    ./frames2pbm.py render.log frames/ --bless tests/render/reference
+
+Frames are written as frames/frame_NNNN.pbm. With --reference, every frame
+is compared against the file of the same name in the reference directory,
+and the run must produce exactly the reference frames. --bless replaces
+the references with the frames of this run, after a reviewed change.
+Exits non-zero if a benchmark is over budget or a frame is missing, extra
+or differs.
+"""
+
+import argparse
+import pathlib
+import re
+import sys
+
+FRAME_BEGIN = re.compile(r"FRAME-BEGIN (\d+) crc32=([0-9a-f]{8})")
+FRAME_END = re.compile(r"FRAME-END (\d+)")
+BENCH = re.compile(r"RENDER-BENCH (\S+) avg=(\d+) min=(\d+) max=(\d+) budget=(\d+) (PASS|FAIL|REPORT)")
+
+
+def parse(lines):
+    frames = []
+    bench = []
+    current = None
+
+    for line in lines:
+        line = line.rstrip("\r\n")
+        match = FRAME_BEGIN.search(line)
+        if match:
+            current = {"index": int(match.group(1)), "crc": match.group(2), "pbm": []}
+            continue
+        if current is not None:
+            if FRAME_END.search(line):
+                frames.append(current)
+                current = None
+            else:
+                current["pbm"].append(line)
+            continue
+        match = BENCH.search(line)
+        if match:
+            bench.append(match.groups())
+
+    return frames, bench
+
+
+def check_frames(frames, reference):
+    """Compare frames against a reference directory, return the problems."""
+    ref_dir = pathlib.Path(reference)
+    expected = {p.name for p in ref_dir.glob("frame_*.pbm")}
+    problems = []
+
+    if not expected:
+        return ["%s: no reference frames, bless a reviewed run first" % ref_dir]
+
+    for frame in frames:
+        name = frame_name(frame)
+        expected.discard(name)
+        ref = ref_dir / name
+        if not ref.exists():
+            problems.append("%s: no reference" % name)
+        elif ref.read_text() != frame_content(frame):
+            problems.append("%s: differs from reference" % name)
+
+    for name in sorted(expected):
+        problems.append("%s: not rendered" % name)
+
+    return problems
+
+
+def frame_name(frame):
+    return "frame_%04d.pbm" % frame["index"]
+
+
+def frame_content(frame):
+    return "\n".join(frame["pbm"]) + "\n"
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("log", help="console output of the native_sim run")
+    parser.add_argument("outdir", help="directory for the extracted frames")
+    group = parser.add_mutually_exclusive_group()
+    group.add_argument("--reference", help="directory with reference frames")
+    group.add_argument("--bless", metavar="DIR",
+                       help="write the frames of this run as the references")
+    args = parser.parse_args()
+
+    with open(args.log, errors="replace") as log:
+        frames, bench = parse(log)
+
+    out = pathlib.Path(args.outdir)
+    out.mkdir(parents=True, exist_ok=True)
+
+    failed = False
+    for frame in frames:
+        (out / frame_name(frame)).write_text(frame_content(frame))
+
+    print("%d frames written to %s" % (len(frames), out))
+
+    if args.bless:
+        bless = pathlib.Path(args.bless)
+        bless.mkdir(parents=True, exist_ok=True)
+        for old in bless.glob("frame_*.pbm"):
+            old.unlink()
+        for frame in frames:
+            (bless / frame_name(frame)).write_text(frame_content(frame))
+        print("%d reference frames written to %s" % (len(frames), bless))
+
+    if args.reference:
+        for problem in check_frames(frames, args.reference):
+            print(problem)
+            failed = True
+
+    for name, avg, low, high, budget, result in bench:
+        print("%-28s avg %10s  min %10s  max %10s  budget %10s  %s"
+              % (name, avg, low, high, budget, result))
+        failed |= result == "FAIL"
+
+    sys.exit(1 if failed else 0)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,60 @@
+#!/usr/bin/env python3
+"""Convert a BleInk trace dump into a CTF trace directory.
+
+Accepts either the UART shell output of 'trace dump' (lines prefixed with
+"CTF ") or a raw stream read from the Diagnostics Trace characteristic
+(0xFFD2), its 512 byte pages concatenated. The result can be opened with babeltrace2 or Trace Compass:
+
+    ./dump2ctf.py console.log out/
+    babeltrace2 out/
+"""
+
+import argparse
+import pathlib
+import re
+import sys
+
+METADATA = pathlib.Path(__file__).with_name("metadata")
+EVENT_SIZE = 12  # TRACE_CTF_EVENT_SIZE in include/trace.c
+
+
+def read_stream(path, raw):
+    data = pathlib.Path(path).read_bytes()
+    if raw:
+        return data
+
+    stream = bytearray()
+    for line in data.decode(errors="replace").splitlines():
+        marker = line.find("CTF ")
+        if marker >= 0:
+            stream += bytes.fromhex(line[marker + 4:].strip())
+    return bytes(stream)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("dump", help="shell log or raw stream file")
+    parser.add_argument("outdir", help="CTF trace directory to create")
+    parser.add_argument("--raw", action="store_true",
+                        help="input is a raw binary stream (BLE read)")
+    parser.add_argument("--freq", type=int, default=32768,
+                        help="timestamp clock in Hz, 'trace info' prints it (default 32768)")
+    args = parser.parse_args()
+
+    stream = read_stream(args.dump, args.raw)
+    if len(stream) % EVENT_SIZE:
+        sys.exit("truncated stream: %d bytes is not a multiple of %d"
+                 % (len(stream), EVENT_SIZE))
+
+    out = pathlib.Path(args.outdir)
+    out.mkdir(parents=True, exist_ok=True)
+    metadata = re.sub(r"freq = \d+;", "freq = %d;" % args.freq, METADATA.read_text(), count=1)
+    (out / "metadata").write_text(metadata)
+    (out / "stream").write_bytes(stream)
+
+    print("%d events written to %s" % (len(stream) // EVENT_SIZE, out))
+
+
+if __name__ == "__main__":
+    main()